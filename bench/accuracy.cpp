@@ -0,0 +1,205 @@
+/*
+ * accuracy.cpp
+ *
+ * 積分器の精度と計算時間の比較（弱収束の誤差 vs 実行時間）
+ *
+ * 積分器ごとに時間刻み dt を振り、時刻 t_end までの run_ensemble の実行時間と
+ * 次の3つの相対誤差（統計誤差 se 付き）を求める:
+ *   err_msd   ⟨r²(t_end)⟩ と厳密解 theoretical_msd_from_rest の差
+ *   err_v2    ⟨v²(t_end)⟩ と厳密解 (2kBT/m)(1 - e^{-2t/τ}) の差
+ *   err_tkin  後半 (t >= t_end/2) の運動エネルギーから求めた温度 T_kin = ⟨E_kin⟩/kB と T の差
+ * シミュレーションは (r, v) = (0, 0) から始まるので、比較には静止状態からの厳密解を使う
+ * （report1_haruki.py の theoretical_msd は熱平衡の初速度の式で、そのずれは err_msd_thermal に出す）。
+ *
+ * --target を指定すると、3つの誤差が全て target 以下になる組み合わせのうち最も速いものを表示する。
+ *
+ * 使い方:
+ *   ./itphys_accuracy [--particles N] [--t-end T] [--dts 0.1,0.05,...] [--integrators euler,baoab,...]
+ *                     [--target ERR] [--threads P] [--quick] [--reps N] [--json PATH] [--csv PATH]
+ *   python3 bench/plot_accuracy.py accuracy.csv   # 誤差 vs 実行時間の図
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "itphys/ensemble.hpp"
+#include "itphys/langevin.hpp"
+#include "itphys/observables.hpp"
+
+namespace {
+
+/** "a,b,c" を分割する */
+std::vector<std::string> split(const std::string& s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+/** 1つの (積分器, dt) の誤差 */
+struct Errors {
+    double msd = 0.0, se_msd = 0.0;
+    double v2 = 0.0, se_v2 = 0.0;
+    double tkin = 0.0, se_tkin = 0.0;
+    double msd_thermal = 0.0;
+
+    double worst() const {
+        return std::max({std::fabs(msd), std::fabs(v2), std::fabs(tkin)});
+    }
+};
+
+Errors measure_errors(const itphys::EnsembleObservables& obs, const itphys::LangevinParams& p) {
+    Errors e;
+    const std::size_t last = static_cast<std::size_t>(p.n_steps);
+    const double t = obs.msd.time(last);
+
+    const double msd_exact = itphys::theoretical_msd_from_rest(t, p);
+    e.msd = obs.msd.at(last).mean() / msd_exact - 1.0;
+    e.se_msd = obs.msd.at(last).std_error() / msd_exact;
+    e.msd_thermal = obs.msd.at(last).mean() / itphys::theoretical_msd(t, p) - 1.0;
+
+    // ⟨v²⟩ = 2⟨E_kin⟩/m
+    const double v2_exact = itphys::theoretical_v2_from_rest(t, p);
+    e.v2 = 2.0 * obs.energy[last].mean() / p.m / v2_exact - 1.0;
+    e.se_v2 = 2.0 * obs.energy[last].std_error() / p.m / v2_exact;
+
+    // 2次元なので ⟨E_kin⟩ = kB T。後半の時刻で平均する（時刻間の相関があるので se は最終時刻の値で代用）
+    double sum = 0.0;
+    int n = 0;
+    for (std::size_t i = last / 2; i <= last; i++) {
+        sum += obs.energy[i].mean();
+        n++;
+    }
+    const double tkin = sum / n / p.kB;
+    e.tkin = tkin / p.T - 1.0;
+    e.se_tkin = obs.energy[last].std_error() / p.kB / p.T;
+    return e;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t particles = 0;
+    double t_end = 0.0;
+    double target = -1.0;
+    int threads = 0;
+    std::string dts_arg, integ_arg = "euler,baoab,exact_ou";
+    bool quick = false;
+    std::vector<char*> rest = {argv[0]};
+    for (int i = 1; i < argc; i++) {
+        const bool v = i + 1 < argc;
+        if (std::strcmp(argv[i], "--particles") == 0 && v) {
+            particles = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--t-end") == 0 && v) {
+            t_end = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--dts") == 0 && v) {
+            dts_arg = argv[++i];
+        } else if (std::strcmp(argv[i], "--integrators") == 0 && v) {
+            integ_arg = argv[++i];
+        } else if (std::strcmp(argv[i], "--target") == 0 && v) {
+            target = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && v) {
+            threads = std::atoi(argv[++i]);
+        } else {
+            if (std::strcmp(argv[i], "--quick") == 0) quick = true;
+            rest.push_back(argv[i]);
+        }
+    }
+    itphys::bench::Options opt;
+    opt.reps = 1;
+    opt.warmup = 0;
+    if (opt.parse(static_cast<int>(rest.size()), rest.data()) != static_cast<int>(rest.size())) {
+        std::fprintf(stderr,
+                     "usage: %s [--particles N] [--t-end T] [--dts a,b,...] [--integrators a,b,...]\n"
+                     "          [--target ERR] [--threads P] [--quick] [--reps N] [--json PATH] [--csv PATH]\n",
+                     argv[0]);
+        return 1;
+    }
+    if (particles == 0) particles = quick ? 2000 : 20000;
+    if (t_end <= 0.0) t_end = quick ? 5.0 : 10.0;
+    if (dts_arg.empty()) {
+        dts_arg = quick ? "0.2,0.1,0.05,0.02,0.01" : "0.2,0.1,0.05,0.02,0.01,0.005,0.002,0.001";
+    }
+
+    std::vector<double> dts;
+    for (const std::string& s : split(dts_arg)) dts.push_back(std::atof(s.c_str()));
+    std::vector<itphys::Integrator> integs;
+    for (const std::string& s : split(integ_arg)) {
+        itphys::Integrator k;
+        if (!itphys::parse_integrator(s, k)) {
+            std::fprintf(stderr, "unknown integrator: %s\n", s.c_str());
+            return 1;
+        }
+        integs.push_back(k);
+    }
+
+    std::printf("# N = %zu particles, t_end = %g, errors are relative (value ± se)\n", particles,
+                t_end);
+    itphys::bench::Runner run("accuracy", opt);
+    struct Best {
+        std::string name;
+        double seconds = -1.0;
+    } best;
+
+    for (itphys::Integrator k : integs) {
+        for (double dt : dts) {
+            itphys::LangevinParams p;
+            p.dt = dt;
+            p.n_steps = std::max(1LL, std::llround(t_end / dt));
+            itphys::EnsembleOptions eo;
+            eo.n_particles = particles;
+            eo.n_threads = threads;
+            eo.integrator = k;
+            itphys::EnsembleObservables obs(p.n_steps + 1);
+
+            char name[96];
+            std::snprintf(name, sizeof(name), "acc/%s/dt%g", itphys::integrator_name(k), dt);
+            itphys::bench::Result* r = run.run(name, "particle-steps/s", [&] {
+                obs = itphys::EnsembleObservables(p.n_steps + 1);
+                itphys::run_ensemble(p, eo, &obs);
+                return double(particles) * p.n_steps;
+            });
+            if (!r) continue;
+
+            const Errors e = measure_errors(obs, p);
+            r->params = {{"integrator", double(static_cast<int>(k))},
+                         {"dt", dt},
+                         {"n_steps", double(p.n_steps)},
+                         {"particles", double(particles)},
+                         {"err_msd", e.msd},
+                         {"se_msd", e.se_msd},
+                         {"err_v2", e.v2},
+                         {"se_v2", e.se_v2},
+                         {"err_tkin", e.tkin},
+                         {"se_tkin", e.se_tkin},
+                         {"err_msd_thermal", e.msd_thermal}};
+            std::printf("  %-40s msd %+.2e±%.1e  v2 %+.2e±%.1e  Tkin %+.2e±%.1e\n", "", e.msd,
+                        e.se_msd, e.v2, e.se_v2, e.tkin, e.se_tkin);
+            if (target > 0.0 && e.worst() <= target && (best.seconds < 0 || r->seconds < best.seconds)) {
+                best.name = name;
+                best.seconds = r->seconds;
+            }
+        }
+    }
+
+    if (target > 0.0) {
+        if (best.seconds >= 0) {
+            std::printf("# cheapest meeting target %g: %s (%.3g s)\n", target, best.name.c_str(),
+                        best.seconds);
+        } else {
+            std::printf("# no configuration meets target %g (statistical error ~ 1/sqrt(N))\n",
+                        target);
+        }
+    }
+    return run.finish();
+}
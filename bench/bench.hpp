@@ -0,0 +1,254 @@
+/*
+ * bench.hpp
+ *
+ * ベンチマーク用の共通部品（bench/ 以下の実行ファイルで共有）
+ *
+ * - 各ケースはウォームアップの後に reps 回計測し、処理量/秒の中央値と MAD（中央絶対偏差）を報告する
+ * - 結果は表として標準出力に、--json を指定すれば JSON ファイルにも書く
+ *   （コミットごとの JSON を比べて性能の退行を見つけるため、git のリビジョンも記録する）
+ */
+
+#ifndef ITPHYS_BENCH_HPP
+#define ITPHYS_BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef ITPHYS_GIT_REV
+#define ITPHYS_GIT_REV "unknown"
+#endif
+
+namespace itphys {
+namespace bench {
+
+/** 計算結果を最適化で消されないようにする */
+template <class T>
+inline void do_not_optimize(const T& v) {
+    asm volatile("" : : "g"(&v) : "memory");
+}
+
+inline double now_seconds() {
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+}
+
+inline double median(std::vector<double> v) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    const std::size_t n = v.size();
+    return n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+/** 中央絶対偏差 median(|v - median(v)|) */
+inline double mad(const std::vector<double>& v) {
+    const double m = median(v);
+    std::vector<double> d(v.size());
+    for (std::size_t i = 0; i < v.size(); i++) d[i] = std::fabs(v[i] - m);
+    return median(d);
+}
+
+/** コマンドラインで共通に指定できる設定 */
+struct Options {
+    int warmup = 1;            // ウォームアップ回数
+    int reps = 5;              // 計測回数
+    bool quick = false;        // 問題サイズを小さくする（動作確認用）
+    std::string filter;        // 名前にこの文字列を含むケースだけ実行する
+    std::string json_path;     // JSON の出力先（空なら出力しない）
+    std::string csv_path;      // CSV の出力先（空なら出力しない）
+
+    /**
+     * --reps N --warmup N --quick --filter S --json PATH --csv PATH を読む
+     * @return 読めなかった引数の位置（全て読めたら argc）
+     */
+    int parse(int argc, char* argv[]) {
+        int i = 1;
+        for (; i < argc; i++) {
+            const char* a = argv[i];
+            const bool has_value = i + 1 < argc;
+            if (std::strcmp(a, "--quick") == 0) {
+                quick = true;
+            } else if (std::strcmp(a, "--reps") == 0 && has_value) {
+                reps = std::max(1, std::atoi(argv[++i]));
+            } else if (std::strcmp(a, "--warmup") == 0 && has_value) {
+                warmup = std::max(0, std::atoi(argv[++i]));
+            } else if (std::strcmp(a, "--filter") == 0 && has_value) {
+                filter = argv[++i];
+            } else if (std::strcmp(a, "--json") == 0 && has_value) {
+                json_path = argv[++i];
+            } else if (std::strcmp(a, "--csv") == 0 && has_value) {
+                csv_path = argv[++i];
+            } else {
+                break;
+            }
+        }
+        return i;
+    }
+};
+
+/** 1ケースの計測結果。値は全て「処理量/秒」（unit で単位を示す） */
+struct Result {
+    std::string name;
+    std::string unit;
+    double median = 0.0;
+    double mad = 0.0;
+    double seconds = 0.0;  // 1回あたりの実行時間の中央値
+    int reps = 0;
+    std::vector<std::pair<std::string, double>> params;  // 粒子数などの条件や追加の指標
+};
+
+/** JSON の文字列リテラルとして出力する */
+inline void json_string(std::FILE* fp, const std::string& s) {
+    std::fputc('"', fp);
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', fp);
+            std::fputc(c, fp);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            std::fprintf(fp, "\\u%04x", c);
+        } else {
+            std::fputc(c, fp);
+        }
+    }
+    std::fputc('"', fp);
+}
+
+/** JSON では inf/nan を書けないので null にする */
+inline void json_number(std::FILE* fp, double v) {
+    if (std::isfinite(v)) {
+        std::fprintf(fp, "%.9g", v);
+    } else {
+        std::fputs("null", fp);
+    }
+}
+
+/** ケースの実行と結果の集計 */
+class Runner {
+public:
+    Runner(const char* suite, const Options& opt) : suite_(suite), opt_(opt) {}
+
+    bool selected(const std::string& name) const {
+        return opt_.filter.empty() || name.find(opt_.filter) != std::string::npos;
+    }
+
+    /**
+     * ケースを計測する
+     * @param body 1回分の処理を実行し、処理量（サンプル数・バイト数など）を返す関数
+     * @return 記録した結果（フィルタで除外されたら nullptr）。後から params を追加してよい
+     */
+    template <class F>
+    Result* run(const std::string& name, const std::string& unit, F&& body,
+                std::vector<std::pair<std::string, double>> params = {}) {
+        if (!selected(name)) return nullptr;
+        for (int i = 0; i < opt_.warmup; i++) do_not_optimize(body());
+        std::vector<double> rate(opt_.reps), sec(opt_.reps);
+        for (int i = 0; i < opt_.reps; i++) {
+            const double t0 = now_seconds();
+            const double work = body();
+            sec[i] = now_seconds() - t0;
+            rate[i] = work / sec[i];
+        }
+        Result r;
+        r.name = name;
+        r.unit = unit;
+        r.median = median(rate);
+        r.mad = mad(rate);
+        r.seconds = median(sec);
+        r.reps = opt_.reps;
+        r.params = std::move(params);
+        std::printf("%-44s %12.4g %-12s ± %-10.3g (%.3g s/rep)\n", r.name.c_str(), r.median,
+                    r.unit.c_str(), r.mad, r.seconds);
+        std::fflush(stdout);
+        results_.push_back(std::move(r));
+        return &results_.back();
+    }
+
+    /** 計測済みの結果をそのまま追加する（スケーリング計測などで独自に集計した場合） */
+    void add(Result r) { results_.push_back(std::move(r)); }
+
+    const std::deque<Result>& results() const { return results_; }
+
+    /** {"suite", "git_rev", "compiler", "cases": [...]} の形式で書く */
+    bool write_json(const std::string& path) const {
+        std::FILE* fp = std::fopen(path.c_str(), "w");
+        if (!fp) return false;
+        std::fprintf(fp, "{\n  \"suite\": ");
+        json_string(fp, suite_);
+        std::fprintf(fp, ",\n  \"git_rev\": ");
+        json_string(fp, ITPHYS_GIT_REV);
+        std::fprintf(fp, ",\n  \"compiler\": ");
+        json_string(fp, __VERSION__);
+        std::fprintf(fp, ",\n  \"reps\": %d,\n  \"cases\": [", opt_.reps);
+        for (std::size_t i = 0; i < results_.size(); i++) {
+            const Result& r = results_[i];
+            std::fprintf(fp, "%s\n    {\"name\": ", i ? "," : "");
+            json_string(fp, r.name);
+            std::fprintf(fp, ", \"unit\": ");
+            json_string(fp, r.unit);
+            std::fprintf(fp, ", \"median\": ");
+            json_number(fp, r.median);
+            std::fprintf(fp, ", \"mad\": ");
+            json_number(fp, r.mad);
+            std::fprintf(fp, ", \"seconds\": ");
+            json_number(fp, r.seconds);
+            for (const auto& kv : r.params) {
+                std::fprintf(fp, ", ");
+                json_string(fp, kv.first);
+                std::fprintf(fp, ": ");
+                json_number(fp, kv.second);
+            }
+            std::fprintf(fp, "}");
+        }
+        std::fprintf(fp, "\n  ]\n}\n");
+        return std::fclose(fp) == 0;
+    }
+
+    /** name,unit,median,mad,seconds,<params...> の形式で書く（params の列は最初の結果に合わせる） */
+    bool write_csv(const std::string& path) const {
+        std::FILE* fp = std::fopen(path.c_str(), "w");
+        if (!fp) return false;
+        std::fprintf(fp, "name,unit,median,mad,seconds");
+        if (!results_.empty()) {
+            for (const auto& kv : results_[0].params) std::fprintf(fp, ",%s", kv.first.c_str());
+        }
+        std::fprintf(fp, "\n");
+        for (const Result& r : results_) {
+            std::fprintf(fp, "%s,%s,%.9g,%.9g,%.9g", r.name.c_str(), r.unit.c_str(), r.median,
+                         r.mad, r.seconds);
+            for (const auto& kv : r.params) std::fprintf(fp, ",%.9g", kv.second);
+            std::fprintf(fp, "\n");
+        }
+        return std::fclose(fp) == 0;
+    }
+
+    /** Options で指定された JSON / CSV を書く。失敗したら 1 を返す */
+    int finish() const {
+        int rc = 0;
+        if (!opt_.json_path.empty() && !write_json(opt_.json_path)) {
+            std::fprintf(stderr, "cannot write %s\n", opt_.json_path.c_str());
+            rc = 1;
+        }
+        if (!opt_.csv_path.empty() && !write_csv(opt_.csv_path)) {
+            std::fprintf(stderr, "cannot write %s\n", opt_.csv_path.c_str());
+            rc = 1;
+        }
+        return rc;
+    }
+
+private:
+    std::string suite_;
+    Options opt_;
+    std::deque<Result> results_;  // run() が返すポインタを無効にしないため deque
+};
+
+}  // namespace bench
+}  // namespace itphys
+
+#endif  // ITPHYS_BENCH_HPP
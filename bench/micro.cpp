@@ -0,0 +1,510 @@
+/*
+ * micro.cpp
+ *
+ * libitphys のマイクロベンチマーク
+ *
+ * 1. 正規分布乱数の生成速度（サンプル/秒）: 生成器の実装ごと
+ * 2. ランジュバン方程式の積分（粒子・ステップ/秒）: 1粒子と粒子数 1〜10^8 のアンサンブル、
+ *    積分器（euler, baoab, exact_ou）ごとの run_ensemble、次元 × 積分器 × ノイズの run_ensemble、
+ *    精度（double, 単精度の mixed）ごとの run_ensemble、
+ *    外力（force.hpp）ごとの run_ensemble、
+ *    相互作用する粒子（suspension.hpp）の Suspension::step（近傍リストの作り直しを含む）、
+ *    記憶のある摩擦（gle.hpp）の GleEnsemble::step（モード数ごと）、
+ *    自己推進粒子（active.hpp）の ActiveBrownian::step と、向きの cos, sin（libm と sincos_2pi）、
+ *    初通過時間（first_passage.hpp）の run_first_passage（レーンの詰め直しと固定の一斉実行）
+ * 3. 出力 sink のスループット（MB/秒）: テキスト、バイナリ、mmap
+ * 4. run_brownian_motion の既定条件（1000 ステップ、テキスト出力）の実行時間
+ *
+ * 使い方:
+ *   ./itphys_bench [--quick] [--reps N] [--warmup N] [--filter S] [--json PATH]
+ *                  [--max-particles N] [--dir DIR]
+ *     --max-particles: アンサンブルの最大粒子数（デフォルト 10^8、--quick では 10^5）
+ *     --dir:           出力 sink の計測で一時ファイルを置くディレクトリ（デフォルト /tmp）
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "bench.hpp"
+#include "itphys/active.hpp"
+#include "itphys/ensemble.hpp"
+#include "itphys/first_passage.hpp"
+#include "itphys/force.hpp"
+#include "itphys/gle.hpp"
+#include "itphys/hydrodynamics.hpp"
+#include "itphys/io.hpp"
+#include "itphys/langevin.hpp"
+#include "itphys/rng.hpp"
+#include "itphys/suspension.hpp"
+
+using itphys::bench::do_not_optimize;
+
+namespace {
+
+/** 以前の normal_rand.c と同じ rand() による Box-Muller（比較用、cos の値だけを使う） */
+double legacy_normal_rand() {
+    const double u1 = (std::rand() + 1.0) / (RAND_MAX + 2.0);
+    const double u2 = (std::rand() + 1.0) / (RAND_MAX + 2.0);
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586477 * u2);
+}
+
+void bench_rng(itphys::bench::Runner& run, bool quick) {
+    const std::size_t n = quick ? 1000000 : 10000000;
+    const std::vector<std::pair<std::string, double>> params = {{"samples", double(n)}};
+
+    run.run("rng/uniform/xoshiro256ss", "samples/s", [&] {
+        static itphys::Xoshiro256ss eng(1);
+        std::uint64_t acc = 0;
+        for (std::size_t i = 0; i < n; i++) acc ^= eng();
+        do_not_optimize(acc);
+        return double(n);
+    }, params);
+
+    run.run("rng/normal/legacy_rand", "samples/s", [&] {
+        double acc = 0.0;
+        for (std::size_t i = 0; i < n; i++) acc += legacy_normal_rand();
+        do_not_optimize(acc);
+        return double(n);
+    }, params);
+
+    run.run("rng/normal/box_muller_scalar", "samples/s", [&] {
+        static itphys::NormalRng rng(1);
+        double acc = 0.0;
+        for (std::size_t i = 0; i < n; i++) acc += rng();
+        do_not_optimize(acc);
+        return double(n);
+    }, params);
+
+    run.run("rng/normal/box_muller_fill", "samples/s", [&] {
+        static itphys::NormalRng rng(1);
+        static std::vector<double> buf(4096);
+        double acc = 0.0;
+        for (std::size_t i = 0; i < n; i += buf.size()) {
+            rng.fill(buf.data(), buf.size());
+            acc += buf[0];
+        }
+        do_not_optimize(acc);
+        return double(n);
+    }, params);
+
+    run.run("rng/normal/std_normal_distribution", "samples/s", [&] {
+        static itphys::Xoshiro256ss eng(1);
+        std::normal_distribution<double> dist;
+        double acc = 0.0;
+        for (std::size_t i = 0; i < n; i++) acc += dist(eng);
+        do_not_optimize(acc);
+        return double(n);
+    }, params);
+}
+
+void bench_integrator(itphys::bench::Runner& run, bool quick, double max_particles) {
+    const itphys::LangevinParams p;
+
+    // 1粒子: run_brownian_motion を出力なしで実行する
+    const long long n_steps = quick ? 1000000 : 10000000;
+    run.run("integrator/euler/particle", "steps/s", [&] {
+        static itphys::NormalRng rng(1);
+        itphys::LangevinParams q = p;
+        q.n_steps = n_steps;
+        itphys::NullSink sink;
+        const itphys::ParticleState s = itphys::run_brownian_motion(q, rng, sink);
+        do_not_optimize(s);
+        return double(n_steps);
+    }, {{"particles", 1.0}, {"steps", double(n_steps)}});
+
+    // アンサンブル: 1回の計測で約 work 粒子・ステップを処理する
+    const double work = quick ? 1e6 : 2e7;
+    const itphys::EulerIntegrator integ(p);
+    for (double n = 1; n <= max_particles; n *= 10) {
+        const std::string name = "integrator/euler/ensemble/" + std::to_string((long long)n);
+        if (!run.selected(name)) continue;
+        const long long steps = std::max(1LL, (long long)(work / n));
+        try {
+            itphys::Ensemble e(static_cast<std::size_t>(n));
+            itphys::NormalRng rng(1);
+            itphys::bench::Result* r = run.run(name, "particle-steps/s", [&] {
+                for (long long k = 0; k < steps; k++) integ.step(e, rng);
+                do_not_optimize(e.x[0]);
+                return n * steps;
+            }, {{"particles", n}, {"steps", double(steps)}});
+            if (r) r->params.emplace_back("ns_per_particle_step", 1e9 / r->median);
+        } catch (const std::bad_alloc&) {
+            std::printf("%-44s skipped (out of memory)\n", name.c_str());
+        }
+    }
+}
+
+/** 各積分器で run_ensemble（1スレッド、集計なし）を実行する */
+void bench_integrator_kinds(itphys::bench::Runner& run, bool quick) {
+    const std::size_t n = 1 << 16;
+    itphys::LangevinParams p;
+    p.n_steps = quick ? 16 : 300;
+    for (itphys::Integrator k :
+         {itphys::Integrator::kEuler, itphys::Integrator::kBaoab, itphys::Integrator::kExactOu}) {
+        itphys::EnsembleOptions opt;
+        opt.n_particles = n;
+        opt.n_threads = 1;
+        opt.integrator = k;
+        run.run(std::string("integrator/") + itphys::integrator_name(k) + "/run_ensemble",
+                "particle-steps/s", [&] {
+                    itphys::run_ensemble(p, opt);
+                    return double(n) * p.n_steps;
+                }, {{"particles", double(n)}, {"steps", double(p.n_steps)}});
+    }
+}
+
+/**
+ * 精度（double, mixed）× 積分器 × ノイズごとに2次元の run_ensemble（1スレッド、集計なし）を実行する
+ * 粒子数は 2^20（状態が L2 に収まらず、メモリの読み書きも効く大きさ）で、ステップ順に全粒子を進める
+ */
+void bench_precision(itphys::bench::Runner& run, bool quick) {
+    const std::size_t n = quick ? 1 << 16 : 1 << 20;
+    itphys::LangevinParams p;
+    p.n_steps = quick ? 16 : 100;
+    for (itphys::Precision pr : {itphys::Precision::kDouble, itphys::Precision::kMixed}) {
+        for (itphys::Integrator k :
+             {itphys::Integrator::kEuler, itphys::Integrator::kBaoab, itphys::Integrator::kExactOu}) {
+            for (itphys::Noise noise : {itphys::Noise::kGaussian, itphys::Noise::kUniform}) {
+                itphys::EnsembleOptions opt;
+                opt.n_particles = n;
+                opt.n_threads = 1;
+                opt.schedule = itphys::Schedule::kStepMajor;
+                opt.integrator = k;
+                opt.noise = noise;
+                opt.precision = pr;
+                run.run(std::string("precision/") + itphys::precision_name(pr) + "/" + itphys::integrator_name(k) +
+                            "/" + itphys::noise_name(noise),
+                        "particle-steps/s", [&] {
+                            itphys::run_ensemble(p, opt);
+                            return double(n) * p.n_steps;
+                        }, {{"particles", double(n)}, {"steps", double(p.n_steps)}});
+            }
+        }
+    }
+}
+
+/** 次元（1〜3）× 積分器 × ノイズの組み合わせごとに run_ensemble（1スレッド、集計なし）を実行する */
+void bench_dims(itphys::bench::Runner& run, bool quick) {
+    const std::size_t n = 1 << 16;
+    itphys::LangevinParams p;
+    p.n_steps = quick ? 16 : 300;
+    for (int dim = 1; dim <= 3; dim++) {
+        for (itphys::Integrator k :
+             {itphys::Integrator::kEuler, itphys::Integrator::kBaoab, itphys::Integrator::kExactOu}) {
+            for (itphys::Noise noise : {itphys::Noise::kGaussian, itphys::Noise::kUniform}) {
+                itphys::EnsembleOptions opt;
+                opt.n_particles = n;
+                opt.n_threads = 1;
+                opt.integrator = k;
+                opt.dim = dim;
+                opt.noise = noise;
+                run.run("dim/" + std::to_string(dim) + "d/" + itphys::integrator_name(k) + "/" +
+                            itphys::noise_name(noise),
+                        "particle-steps/s", [&] {
+                            itphys::run_ensemble(p, opt);
+                            return double(n) * p.n_steps;
+                        }, {{"particles", double(n)}, {"steps", double(p.n_steps)}, {"dim", double(dim)}});
+            }
+        }
+    }
+}
+
+/**
+ * 外力ごとに run_ensemble（1スレッド、集計なし）を実行する
+ * 力は step_block の中で計算するので、free との差が力の計算そのものの費用になる
+ */
+void bench_forces(itphys::bench::Runner& run, bool quick) {
+    const std::size_t n = 1 << 16;
+    itphys::LangevinParams p;
+    p.n_steps = quick ? 16 : 300;
+    const std::pair<const char*, const char*> kForces[] = {
+        {"free", "none"},
+        {"harmonic", "harmonic:k=2"},
+        {"washboard", "washboard:v0=1,period=1,tilt=0.5"},
+        {"double_well", "double_well:barrier=2,a=1"},
+        {"all", "harmonic:k=2+washboard:v0=1,period=1,tilt=0.5+double_well:barrier=2,a=1"},
+    };
+    for (itphys::Integrator k : {itphys::Integrator::kEuler, itphys::Integrator::kBaoab}) {
+        for (const auto& f : kForces) {
+            itphys::EnsembleOptions opt;
+            opt.n_particles = n;
+            opt.n_threads = 1;
+            opt.integrator = k;
+            itphys::parse_force_field(f.second, opt.force);
+            run.run(std::string("force/") + itphys::integrator_name(k) + "/" + f.first,
+                    "particle-steps/s", [&] {
+                        itphys::run_ensemble(p, opt);
+                        return double(n) * p.n_steps;
+                    }, {{"particles", double(n)}, {"steps", double(p.n_steps)}});
+        }
+    }
+}
+
+/**
+ * 相互作用する N 粒子（密度 0.5、粒子数 10^4〜10^6）の Suspension::step
+ * 近傍リストの作り直しの頻度も含めて測るため、1回の計測で steps ステップ進める
+ */
+void bench_pairs(itphys::bench::Runner& run, bool quick, double max_particles) {
+    itphys::LangevinParams p;
+    p.dt = 0.002;
+    const long long steps = quick ? 5 : 50;
+    for (itphys::PairPotential k : {itphys::PairPotential::kWca, itphys::PairPotential::kLennardJones,
+                                    itphys::PairPotential::kYukawa}) {
+        for (double n = 1e4; n <= std::min(max_particles, 1e6); n *= 10) {
+            const std::string name =
+                std::string("pair/") + itphys::pair_potential_name(k) + "/" + std::to_string((long long)n);
+            if (!run.selected(name)) continue;
+            itphys::SuspensionOptions opt;
+            opt.n_particles = static_cast<std::size_t>(n);
+            opt.density = 0.5;
+            opt.pair.kind = k;
+            opt.n_threads = 1;
+            itphys::Suspension s(p, opt);
+            itphys::bench::Result* r = run.run(name, "particle-steps/s", [&] {
+                s.step(steps);
+                do_not_optimize(s.x()[0]);
+                return n * steps;
+            }, {{"particles", n}, {"steps", double(steps)}});
+            if (r) {
+                r->params.emplace_back("steps_per_s", r->median / n);
+                r->params.emplace_back("neighbors", double(s.n_neighbors()) / n);
+            }
+        }
+    }
+}
+
+/**
+ * 流体力学的相互作用（RPY）: 移動度テンソルの積 M f と、ランチョス法のノイズを含む
+ * HydroBrownian::step（どちらも O(N²)、1スレッド）
+ */
+void bench_hydro(itphys::bench::Runner& run, bool quick) {
+    itphys::LangevinParams p;
+    const std::size_t n = quick ? 1000 : 4000;
+    const std::string suffix = "/" + std::to_string(n);
+    itphys::HydroOptions opt;
+    opt.n_particles = n;
+    opt.n_threads = 1;
+    itphys::HydroBrownian s(p, opt);
+
+    if (run.selected("hydro/rpy_apply" + suffix)) {
+        std::vector<double> f(2 * n), u(2 * n);
+        itphys::NormalRng rng(1);
+        rng.fill(f.data(), f.size());
+        run.run("hydro/rpy_apply" + suffix, "pairs/s", [&] {
+            s.mobility().apply(s.x().data(), s.y().data(), n, f.data(), f.data() + n, u.data(), u.data() + n, 1);
+            do_not_optimize(u[0]);
+            return double(n) * n;
+        }, {{"particles", double(n)}});
+    }
+    if (run.selected("hydro/step" + suffix)) {
+        itphys::bench::Result* r = run.run("hydro/step" + suffix, "particle-steps/s", [&] {
+            s.step(1);
+            do_not_optimize(s.x()[0]);
+            return double(n);
+        }, {{"particles", double(n)}});
+        if (r) r->params.emplace_back("krylov_mean", s.mean_krylov());
+    }
+}
+
+/**
+ * 一般化ランジュバン方程式: プロニー級数のモード数 1, 4, 16 ごとの GleEnsemble::step
+ * （2^16 粒子、1スレッド。1ステップの費用はモード数に比例する）
+ */
+void bench_gle(itphys::bench::Runner& run, bool quick) {
+    itphys::LangevinParams p;
+    const std::size_t n = quick ? 1 << 12 : 1 << 16;
+    for (int modes : {1, 4, 16}) {
+        const std::string name = "gle/step/" + std::to_string(modes);
+        if (!run.selected(name)) continue;
+        itphys::GleOptions opt;
+        opt.n_particles = n;
+        opt.n_threads = 1;
+        for (int k = 0; k < modes; k++) opt.kernel.modes.push_back({1.0 / modes, std::pow(2.0, k - 2)});
+        itphys::GleEnsemble g(p, opt);
+        run.run(name, "particle-steps/s", [&] {
+            g.step(10);
+            do_not_optimize(g.x()[0]);
+            return double(n) * 10;
+        }, {{"particles", double(n)}, {"modes", double(modes)}});
+    }
+}
+
+/**
+ * 自己推進粒子: 向きの cos, sin を 2^16 個計算するループ（libm と sincos_2pi）と、
+ * ノイズごとの ActiveBrownian::step（2^16 粒子、1スレッド。比べる相手は dim/2d/euler/<ノイズ>）
+ */
+void bench_active(itphys::bench::Runner& run, bool quick) {
+    const std::size_t n = 1 << 16;
+    std::vector<double> u(n), s(n), c(n);
+    for (std::size_t i = 0; i < n; i++) u[i] = double(i) / n - 0.5;
+    run.run("active/sincos/libm", "values/s", [&] {
+        for (std::size_t i = 0; i < n; i++) {
+            s[i] = std::sin(6.283185307179586 * u[i]);
+            c[i] = std::cos(6.283185307179586 * u[i]);
+        }
+        do_not_optimize(s[0] + c[0]);
+        return double(n);
+    });
+    run.run("active/sincos/sincos_2pi", "values/s", [&] {
+        for (std::size_t i = 0; i < n; i++) itphys::sincos_2pi(u[i], s[i], c[i]);
+        do_not_optimize(s[0] + c[0]);
+        return double(n);
+    });
+    itphys::LangevinParams p;
+    for (itphys::Noise noise : {itphys::Noise::kGaussian, itphys::Noise::kUniform}) {
+        const std::string name = std::string("active/step/") + itphys::noise_name(noise);
+        if (!run.selected(name)) continue;
+        itphys::ActiveOptions opt;
+        opt.n_particles = quick ? 1 << 12 : n;
+        opt.n_threads = 1;
+        opt.noise = noise;
+        itphys::ActiveBrownian a(p, opt);
+        run.run(name, "particle-steps/s", [&] {
+            a.step(10);
+            do_not_optimize(a.x()[0]);
+            return double(opt.n_particles) * 10;
+        }, {{"particles", double(opt.n_particles)}});
+    }
+}
+
+/**
+ * 初通過時間: 半径 3 の円から出るまでの 2^14 粒子（--quick では 2^11）を、吸収されたレーンに次の粒子を
+ * 入れて詰める refill と、一斉に始めて全員が出るまで全レーンを進める mask で比べる（1スレッド）
+ */
+void bench_first_passage(itphys::bench::Runner& run, bool quick) {
+    itphys::LangevinParams p;
+    for (itphys::FptLanes lanes : {itphys::FptLanes::kRefill, itphys::FptLanes::kMask}) {
+        const std::string name = std::string("fpt/") + itphys::fpt_lanes_name(lanes);
+        if (!run.selected(name)) continue;
+        itphys::FptOptions opt;
+        opt.n_walkers = quick ? 1 << 11 : 1 << 14;
+        opt.n_lanes = 1024;
+        opt.lanes = lanes;
+        opt.n_threads = 1;
+        double utilization = 0.0;
+        itphys::bench::Result* r = run.run(name, "walkers/s", [&] {
+            const itphys::FptResult res = itphys::run_first_passage(p, opt);
+            utilization = res.lane_utilization(p.dt);
+            return double(opt.n_walkers);
+        }, {{"walkers", double(opt.n_walkers)}});
+        if (r) r->params.emplace_back("lane_utilization", utilization);
+    }
+}
+
+/** sink に n 件の状態を書いて閉じるまでの時間を計測する（単位: MB/秒） */
+template <class MakeSink>
+void bench_sink(itphys::bench::Runner& run, const std::string& name, std::size_t n,
+                MakeSink make_sink) {
+    run.run(name, "MB/s", [&] {
+        double bytes = 0.0;
+        make_sink([&](auto& sink) {
+            sink.header();
+            itphys::ParticleState s;
+            for (std::size_t i = 0; i < n; i++) {
+                s.t += 0.01;
+                s.x += 1e-3;
+                s.vx = -s.vx + 0.5;
+                sink.write(s);
+            }
+            sink.flush();
+            bytes = double(sink.bytes_written());
+        });
+        return bytes / 1e6;
+    }, {{"records", double(n)}});
+}
+
+void bench_sinks(itphys::bench::Runner& run, bool quick, const std::string& dir) {
+    const std::size_t n = quick ? 100000 : 2000000;
+    const std::string path = dir + "/itphys_bench_" + std::to_string(getpid()) + ".dat";
+
+    bench_sink(run, "sink/text", n, [&](auto&& body) {
+        std::FILE* fp = std::fopen(path.c_str(), "w");
+        if (!fp) return;
+        {
+            itphys::TextSink sink(fp);
+            body(sink);
+        }
+        std::fclose(fp);
+    });
+    bench_sink(run, "sink/binary", n, [&](auto&& body) {
+        std::FILE* fp = std::fopen(path.c_str(), "wb");
+        if (!fp) return;
+        {
+            itphys::BinarySink sink(fp);
+            body(sink);
+        }
+        std::fclose(fp);
+    });
+    bench_sink(run, "sink/mmap", n, [&](auto&& body) {
+        itphys::MmapSink sink(path);
+        body(sink);
+    });
+    std::remove(path.c_str());
+}
+
+void bench_end_to_end(itphys::bench::Runner& run) {
+    // brownian_motion を引数なしで実行したときと同じ条件（出力先は /dev/null）
+    const itphys::LangevinParams p;
+    const int runs = 100;
+    run.run("e2e/run_brownian_motion/default", "runs/s", [&] {
+        std::FILE* fp = std::fopen("/dev/null", "w");
+        for (int i = 0; i < runs; i++) {
+            itphys::NormalRng rng(i + 1);
+            itphys::TextSink out(fp);
+            out.header();
+            itphys::run_brownian_motion(p, rng, out);
+        }
+        std::fclose(fp);
+        return double(runs);
+    }, {{"steps", double(p.n_steps)}});
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    // このプログラム固有の引数を取り除いてから共通の引数を読む
+    double max_particles = -1.0;
+    std::string dir = "/tmp";
+    std::vector<char*> rest = {argv[0]};
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--max-particles") == 0 && i + 1 < argc) {
+            max_particles = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else {
+            rest.push_back(argv[i]);
+        }
+    }
+    itphys::bench::Options opt;
+    if (opt.parse(static_cast<int>(rest.size()), rest.data()) != static_cast<int>(rest.size())) {
+        std::fprintf(stderr,
+                     "usage: %s [--quick] [--reps N] [--warmup N] [--filter S] [--json PATH]\n"
+                     "          [--max-particles N] [--dir DIR]\n", argv[0]);
+        return 1;
+    }
+    if (max_particles < 0) max_particles = opt.quick ? 1e5 : 1e8;
+
+    itphys::bench::Runner run("micro", opt);
+    bench_rng(run, opt.quick);
+    bench_integrator(run, opt.quick, max_particles);
+    bench_integrator_kinds(run, opt.quick);
+    bench_dims(run, opt.quick);
+    bench_precision(run, opt.quick);
+    bench_forces(run, opt.quick);
+    bench_pairs(run, opt.quick, max_particles);
+    bench_hydro(run, opt.quick);
+    bench_gle(run, opt.quick);
+    bench_active(run, opt.quick);
+    bench_first_passage(run, opt.quick);
+    bench_sinks(run, opt.quick, dir);
+    bench_end_to_end(run);
+    return run.finish();
+}
@@ -0,0 +1,117 @@
+/*
+ * mlmc.cpp
+ *
+ * マルチレベル・モンテカルロ法（itphys::run_mlmc）の費用と目標誤差の関係
+ *
+ * 目標の RMS 誤差 ε を振り、積分器ごとに ⟨r²(t_end)⟩ を MLMC で推定して次を記録する:
+ *   cost        全レベルの粒子・ステップ数（ε² cost がほぼ一定なら O(ε⁻²)）
+ *   cost_mc     最も細かいレベルの刻みで普通のモンテカルロを行ったときの見積もり（O(ε⁻³) で増える）
+ *   err         厳密解 theoretical_msd_from_rest との差（ε 程度以下になるはず）
+ *
+ * 使い方:
+ *   ./itphys_mlmc [--eps 0.2,0.1,...] [--integrators euler,baoab] [--t-end T] [--dt0 DT]
+ *                 [--threads P] [--quick] [--reps N] [--json PATH] [--csv PATH]
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "itphys/langevin.hpp"
+#include "itphys/mlmc.hpp"
+#include "itphys/observables.hpp"
+
+namespace {
+
+/** "a,b,c" を分割する */
+std::vector<std::string> split(const std::string& s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string eps_arg, integ_arg = "euler,baoab";
+    double t_end = 10.0, dt0 = 0.2;
+    int threads = 0;
+    bool quick = false;
+    std::vector<char*> rest = {argv[0]};
+    for (int i = 1; i < argc; i++) {
+        const bool v = i + 1 < argc;
+        if (std::strcmp(argv[i], "--eps") == 0 && v) {
+            eps_arg = argv[++i];
+        } else if (std::strcmp(argv[i], "--integrators") == 0 && v) {
+            integ_arg = argv[++i];
+        } else if (std::strcmp(argv[i], "--t-end") == 0 && v) {
+            t_end = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--dt0") == 0 && v) {
+            dt0 = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && v) {
+            threads = std::atoi(argv[++i]);
+        } else {
+            if (std::strcmp(argv[i], "--quick") == 0) quick = true;
+            rest.push_back(argv[i]);
+        }
+    }
+    itphys::bench::Options opt;
+    opt.reps = 1;
+    opt.warmup = 0;
+    if (opt.parse(static_cast<int>(rest.size()), rest.data()) != static_cast<int>(rest.size())) {
+        std::fprintf(stderr,
+                     "usage: %s [--eps a,b,...] [--integrators euler,baoab] [--t-end T] [--dt0 DT]\n"
+                     "          [--threads P] [--quick] [--reps N] [--json PATH] [--csv PATH]\n",
+                     argv[0]);
+        return 1;
+    }
+    if (eps_arg.empty()) eps_arg = quick ? "0.4,0.2" : "0.4,0.2,0.1,0.05,0.025";
+
+    itphys::LangevinParams p;
+    p.dt = dt0;
+    p.n_steps = static_cast<long long>(std::llround(t_end / dt0));
+    const double exact = itphys::theoretical_msd_from_rest(p.n_steps * p.dt, p);
+    std::printf("# <r^2(t_end)> by MLMC, t_end = %g, dt0 = %g, exact = %.6f\n", p.n_steps * p.dt, dt0, exact);
+
+    itphys::bench::Runner run("mlmc", opt);
+    for (const std::string& integ_name : split(integ_arg)) {
+        itphys::MlmcOptions mo;
+        mo.n_threads = threads;
+        if (!itphys::parse_integrator(integ_name, mo.integrator)) {
+            std::fprintf(stderr, "unknown integrator: %s\n", integ_name.c_str());
+            return 1;
+        }
+        for (const std::string& e : split(eps_arg)) {
+            mo.target_rmse = std::atof(e.c_str());
+            itphys::MlmcResult r;
+            itphys::bench::Result* res = run.run(integ_name + "/eps" + e, "particle-steps/s", [&] {
+                r = itphys::run_mlmc(p, mo);
+                return r.cost;
+            });
+            if (!res) continue;
+            const double eps2 = mo.target_rmse * mo.target_rmse;
+            res->params = {{"eps", mo.target_rmse},
+                           {"levels", double(r.levels.size())},
+                           {"cost", r.cost},
+                           {"cost_mc", r.cost_mc},
+                           {"eps2_cost", eps2 * r.cost},
+                           {"eps2_cost_mc", eps2 * r.cost_mc},
+                           {"estimate", r.mean[itphys::kMlmcMsd]},
+                           {"err", r.mean[itphys::kMlmcMsd] - exact},
+                           {"std_error", r.std_error[itphys::kMlmcMsd]}};
+            std::printf("  %-40s L = %zu  eps^2 cost %.3g (MC %.3g)  err %+.3g  se %.3g\n", "",
+                        r.levels.size() - 1, eps2 * r.cost, eps2 * r.cost_mc,
+                        r.mean[itphys::kMlmcMsd] - exact, r.std_error[itphys::kMlmcMsd]);
+        }
+    }
+    return run.finish();
+}
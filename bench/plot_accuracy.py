@@ -0,0 +1,68 @@
+"""
+plot_accuracy.py
+
+目的: itphys_accuracy の CSV から、積分器ごとの誤差と実行時間の関係を図にする
+- 横軸: 実行時間 [s]、縦軸: 相対誤差の絶対値（両対数）
+- ⟨r²⟩, ⟨v²⟩, 運動温度の3つのパネル。点の横に dt を書く
+- 灰色の帯は統計誤差（2 se）の目安で、これより下の誤差は区別できない
+
+使い方:
+    ./build/release/bin/itphys_accuracy --csv accuracy.csv
+    python3 bench/plot_accuracy.py accuracy.csv [出力ファイル名]
+"""
+
+import csv                        # CSV の読み込み用
+import sys                        # コマンドライン引数の取得用
+from collections import defaultdict
+
+import matplotlib.pyplot as plt   # グラフ描画ライブラリ
+
+# 日本語フォントの設定
+plt.rcParams['font.family'] = 'Hiragino Sans'
+# マイナス記号の文字化けを防ぐ設定
+plt.rcParams['axes.unicode_minus'] = False
+
+PANELS = [('err_msd', 'se_msd', '⟨r²(t_end)⟩'),
+          ('err_v2', 'se_v2', '⟨v²(t_end)⟩'),
+          ('err_tkin', 'se_tkin', '運動温度 T_kin')]
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+    out = sys.argv[2] if len(sys.argv) >= 3 else 'accuracy.png'
+
+    # 名前 acc/<積分器>/dt<dt> ごとに行をまとめる
+    rows = defaultdict(list)
+    with open(sys.argv[1]) as f:
+        for row in csv.DictReader(f):
+            integ = row['name'].split('/')[1]
+            rows[integ].append(row)
+
+    fig, axes = plt.subplots(1, len(PANELS), figsize=(15, 5))
+    for ax, (err, se, title) in zip(axes, PANELS):
+        se_max = 0.0
+        for integ, items in rows.items():
+            items.sort(key=lambda r: float(r['seconds']))
+            sec = [float(r['seconds']) for r in items]
+            val = [max(abs(float(r[err])), 1e-12) for r in items]
+            ax.loglog(sec, val, 'o-', label=integ)
+            for r, x, y in zip(items, sec, val):
+                ax.annotate(f"{float(r['dt']):g}", (x, y), textcoords='offset points',
+                            xytext=(3, 3), fontsize=7)
+            se_max = max([se_max] + [2.0 * float(r[se]) for r in items])
+        ax.axhspan(1e-12, se_max, color='gray', alpha=0.15)
+        ax.set_xlabel('実行時間 [s]')
+        ax.set_ylabel('相対誤差 |err|')
+        ax.set_title(title)
+        ax.grid(True, which='both', alpha=0.3)
+        ax.legend()
+
+    plt.tight_layout()
+    plt.savefig(out, dpi=150)
+    print(f"saved {out}")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,286 @@
+/*
+ * scaling.cpp
+ *
+ * 並列アンサンブル（itphys::run_ensemble）のスケーリング計測
+ *
+ * - strong: 総粒子数を固定してスレッド数を 1, 2, 4, …, P と増やす（効率 = T(1) / (p T(p))）
+ * - weak:   1スレッドあたりの粒子数を固定して増やす（効率 = T(1) / T(p)）
+ *
+ * どこで頭打ちになるかを切り分けるため、スレッド数ごとに次のカーネルを計測する:
+ *   rng            正規乱数の生成だけ（積分も集計もしない）
+ *   engine/S       run_ensemble（集計なし）
+ *   engine+obs/S   run_ensemble + 各時刻の ⟨r²⟩, ⟨E_kin⟩（スレッドごとの集計と最後のまとめ）
+ *   engine+hist/S  run_ensemble + 運動エネルギーのヒストグラム
+ *   （S は step = 全粒子を1ステップずつ、block = ブロックごとに全ステップ）
+ * time モードでは1本の軌道の長さを固定し、逐次の run_brownian_motion と時間方向の並列計算
+ * （itphys::run_time_parallel）を比べる（効率 = T(逐次) / (p T(p))）:
+ *   time/serial       run_brownian_motion（最終状態だけ）
+ *   time/scan         run_time_parallel（最終状態だけ）
+ *   time/scan+out     run_time_parallel（全時刻を配列に書く。補正のパスが加わる）
+ * さらに同じスレッド数で triad（a = b + s c）のメモリ帯域を測り、
+ * 作業領域が LLC を超え、かつ帯域の半分以上を使っている実行を memory_bound = 1 とする。
+ *
+ * 使い方:
+ *   ./itphys_scaling [--threads P] [--particles N] [--weak-particles N] [--steps S]
+ *                    [--schedule step|block|both] [--time-steps S] [--quick] [--reps N]
+ *                    [--json PATH] [--csv PATH]
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "bench.hpp"
+#include "itphys/ensemble.hpp"
+#include "itphys/io.hpp"
+#include "itphys/langevin.hpp"
+#include "itphys/rng.hpp"
+#include "itphys/time_parallel.hpp"
+
+namespace {
+
+constexpr std::size_t kBlock = itphys::EulerIntegrator::kNoiseBlock;
+// 1粒子・1ステップで読み書きする状態 (x, y, vx, vy) のバイト数（読み 32 + 書き 32）
+constexpr double kStateBytesPerParticleStep = 64.0;
+
+/** 最下位キャッシュの大きさ（取得できなければ 32 MiB とみなす） */
+double llc_bytes() {
+    long v = -1;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    v = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (v <= 0) v = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    return v > 0 ? double(v) : 32.0 * 1024 * 1024;
+}
+
+/** triad a[i] = b[i] + s c[i] のメモリ帯域 [GB/s]（STREAM と同じく 24 バイト/要素で数える） */
+double triad_bandwidth(int threads, std::size_t n, int reps) {
+    std::vector<double> a(n), b(n, 1.0), c(n, 2.0);
+    double best = 0.0;
+    for (int r = 0; r < reps + 1; r++) {
+        const double t0 = itphys::bench::now_seconds();
+#pragma omp parallel for num_threads(threads) schedule(static)
+        for (std::size_t i = 0; i < n; i++) a[i] = b[i] + 3.0 * c[i];
+        const double sec = itphys::bench::now_seconds() - t0;
+        itphys::bench::do_not_optimize(a[n / 2]);
+        if (r > 0) best = std::max(best, 24.0 * n / sec / 1e9);  // 1回目はページ割り当てを含むので捨てる
+    }
+    return best;
+}
+
+/** 正規乱数の生成だけを run_ensemble と同じブロック分割で行う */
+double rng_only(int threads, std::size_t n, long long steps, std::uint64_t seed) {
+    const std::size_t n_blocks = (n + kBlock - 1) / kBlock;
+    std::vector<itphys::NormalRng> rngs;
+    rngs.reserve(n_blocks);
+    for (std::size_t k = 0; k < n_blocks; k++) rngs.emplace_back(seed, k);
+    double acc = 0.0;
+#pragma omp parallel num_threads(threads) reduction(+ : acc)
+    {
+        double eta[2 * kBlock];
+        for (long long s = 0; s < steps; s++) {
+#pragma omp for schedule(static)
+            for (std::size_t k = 0; k < n_blocks; k++) {
+                const std::size_t b = std::min(kBlock, n - k * kBlock);
+                rngs[k].fill(eta, 2 * b);
+                acc += eta[0];
+            }
+        }
+    }
+    itphys::bench::do_not_optimize(acc);
+    return double(n) * steps;
+}
+
+struct Config {
+    int max_threads = 1;
+    std::size_t strong_particles = 1 << 20;
+    std::size_t weak_particles = 1 << 18;  // 1スレッドあたり
+    long long steps = 100;
+    long long time_steps = 1 << 22;  // time モードの軌道の長さ
+    bool step_major = true;
+    bool block_major = true;
+};
+
+/** 1つのモード（strong / weak）の全カーネルを計測し、効率・バイト数・帯域を params に加える */
+void run_mode(itphys::bench::Runner& run, const char* mode, const Config& cfg, bool weak,
+              const std::vector<int>& thread_counts, int reps) {
+    const double llc = llc_bytes();
+    std::vector<double> stream(thread_counts.size());
+    // 配列1本を LLC の4倍（32 MiB〜256 MiB）にしてキャッシュに載らないようにする
+    const std::size_t triad_n = std::min<std::size_t>(
+        std::max<std::size_t>(std::size_t(4 * llc / 8), 1 << 22), 1 << 25);
+    for (std::size_t j = 0; j < thread_counts.size(); j++) {
+        stream[j] = triad_bandwidth(thread_counts[j], triad_n, reps);
+    }
+
+    struct Kernel {
+        std::string name;
+        bool engine;
+        itphys::Schedule schedule;
+        bool obs;
+        bool hist;
+    };
+    std::vector<Kernel> kernels = {{"rng", false, itphys::Schedule::kBlockMajor, false, false}};
+    for (int sched = 0; sched < 2; sched++) {
+        if (sched == 0 && !cfg.step_major) continue;
+        if (sched == 1 && !cfg.block_major) continue;
+        const auto s = sched == 0 ? itphys::Schedule::kStepMajor : itphys::Schedule::kBlockMajor;
+        const std::string tag = sched == 0 ? "step" : "block";
+        kernels.push_back({"engine/" + tag, true, s, false, false});
+        kernels.push_back({"engine+obs/" + tag, true, s, true, false});
+        kernels.push_back({"engine+hist/" + tag, true, s, false, true});
+    }
+
+    itphys::LangevinParams p;
+    p.n_steps = cfg.steps;
+    for (const Kernel& k : kernels) {
+        double t1 = 0.0;
+        for (std::size_t j = 0; j < thread_counts.size(); j++) {
+            const int th = thread_counts[j];
+            const std::size_t n = weak ? cfg.weak_particles * th : cfg.strong_particles;
+            const std::string name = std::string(mode) + "/" + k.name + "/t" + std::to_string(th);
+            itphys::bench::Result* r = run.run(name, "particle-steps/s", [&] {
+                if (!k.engine) return rng_only(th, n, p.n_steps, 1);
+                itphys::EnsembleOptions opt;
+                opt.n_particles = n;
+                opt.n_threads = th;
+                opt.schedule = k.schedule;
+                itphys::EnsembleObservables obs(k.obs ? p.n_steps + 1 : 0);
+                itphys::EnergyHistogram hist(p.m, 10.0 * p.kB * p.T, 64);
+                itphys::run_ensemble(p, opt, k.obs ? &obs : nullptr, k.hist ? &hist : nullptr);
+                return double(n) * p.n_steps;
+            });
+            if (!r) continue;
+            if (j == 0) t1 = r->seconds;
+            // strong: T(1)/(p T(p))、weak: T(1)/T(p)
+            const double eff = t1 > 0.0 ? (weak ? t1 / r->seconds : t1 / (th * r->seconds)) : 0.0;
+            const double bytes_per_step = k.engine ? kStateBytesPerParticleStep * n : 16.0 * n;
+            const double gbps = bytes_per_step * p.n_steps / r->seconds / 1e9;
+            const bool streams = k.engine && k.schedule == itphys::Schedule::kStepMajor;
+            const double working_set = 32.0 * n;  // 全粒子の (x, y, vx, vy)
+            const bool memory_bound = streams && working_set > llc && gbps >= 0.5 * stream[j];
+            r->params = {{"threads", double(th)},
+                         {"particles", double(n)},
+                         {"steps", double(p.n_steps)},
+                         {"efficiency", eff},
+                         {"bytes_per_step", bytes_per_step},
+                         {"achieved_GBps", gbps},
+                         {"stream_GBps", stream[j]},
+                         {"memory_bound", memory_bound ? 1.0 : 0.0}};
+            std::printf("  %-40s eff %5.2f  %.3g B/step  %.3g GB/s (triad %.3g)%s\n", "",
+                        eff, bytes_per_step, gbps, stream[j], memory_bound ? "  memory-bound" : "");
+        }
+    }
+}
+
+/** time モード: 1本の軌道を逐次と時間方向の並列で計算し、逐次に対する効率を params に加える */
+void run_time_mode(itphys::bench::Runner& run, const Config& cfg, const std::vector<int>& thread_counts) {
+    itphys::LangevinParams p;
+    p.n_steps = cfg.time_steps;
+    double t_serial = 0.0;
+    if (itphys::bench::Result* r = run.run("time/serial", "steps/s", [&] {
+            itphys::NormalRng rng(1);
+            itphys::NullSink sink;
+            const itphys::ParticleState s = itphys::run_brownian_motion(p, rng, sink);
+            itphys::bench::do_not_optimize(s.x);
+            return double(p.n_steps);
+        })) {
+        t_serial = r->seconds;
+        r->params = {{"threads", 1.0}, {"steps", double(p.n_steps)}};
+    }
+
+    std::vector<double> out;
+    for (int with_out = 0; with_out < 2; with_out++) {
+        for (const int th : thread_counts) {
+            const std::string name = std::string(with_out ? "time/scan+out/t" : "time/scan/t") +
+                                     std::to_string(th);
+            if (with_out && out.empty()) {
+                out.assign(static_cast<std::size_t>(p.n_steps + 1) * itphys::kStateFields, 0.0);
+            }
+            itphys::bench::Result* r = run.run(name, "steps/s", [&] {
+                itphys::TimeParallelOptions opt;
+                opt.n_threads = th;
+                const itphys::ParticleState s =
+                    itphys::run_time_parallel(p, opt, with_out ? out.data() : nullptr);
+                itphys::bench::do_not_optimize(s.x);
+                return double(p.n_steps);
+            });
+            if (!r) continue;
+            const double eff = t_serial > 0.0 ? t_serial / (th * r->seconds) : 0.0;
+            r->params = {{"threads", double(th)}, {"steps", double(p.n_steps)}, {"efficiency", eff}};
+            std::printf("  %-40s eff %5.2f (vs serial)\n", "", eff);
+        }
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Config cfg;
+    cfg.max_threads = itphys::max_threads();
+    bool quick = false;
+    bool have_strong = false, have_weak = false, have_steps = false, have_time_steps = false;
+    std::vector<char*> rest = {argv[0]};
+    for (int i = 1; i < argc; i++) {
+        const bool v = i + 1 < argc;
+        if (std::strcmp(argv[i], "--threads") == 0 && v) {
+            cfg.max_threads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--particles") == 0 && v) {
+            cfg.strong_particles = std::strtoull(argv[++i], nullptr, 10);
+            have_strong = true;
+        } else if (std::strcmp(argv[i], "--weak-particles") == 0 && v) {
+            cfg.weak_particles = std::strtoull(argv[++i], nullptr, 10);
+            have_weak = true;
+        } else if (std::strcmp(argv[i], "--steps") == 0 && v) {
+            cfg.steps = std::atoll(argv[++i]);
+            have_steps = true;
+        } else if (std::strcmp(argv[i], "--time-steps") == 0 && v) {
+            cfg.time_steps = std::atoll(argv[++i]);
+            have_time_steps = true;
+        } else if (std::strcmp(argv[i], "--schedule") == 0 && v) {
+            const char* s = argv[++i];
+            cfg.step_major = std::strcmp(s, "block") != 0;
+            cfg.block_major = std::strcmp(s, "step") != 0;
+        } else {
+            if (std::strcmp(argv[i], "--quick") == 0) quick = true;
+            rest.push_back(argv[i]);
+        }
+    }
+    itphys::bench::Options opt;
+    opt.reps = 3;
+    if (opt.parse(static_cast<int>(rest.size()), rest.data()) != static_cast<int>(rest.size())) {
+        std::fprintf(stderr,
+                     "usage: %s [--threads P] [--particles N] [--weak-particles N] [--steps S]\n"
+                     "          [--schedule step|block|both] [--time-steps S] [--quick] [--reps N] [--warmup N]\n"
+                     "          [--filter S] [--json PATH] [--csv PATH]\n", argv[0]);
+        return 1;
+    }
+    if (quick) {
+        if (!have_strong) cfg.strong_particles = 1 << 16;
+        if (!have_weak) cfg.weak_particles = 1 << 14;
+        if (!have_steps) cfg.steps = 20;
+        if (!have_time_steps) cfg.time_steps = 1 << 18;
+    }
+
+    std::vector<int> threads;
+    for (int t = 1; t < cfg.max_threads; t *= 2) threads.push_back(t);
+    threads.push_back(cfg.max_threads);
+
+    std::printf("# threads up to %d, LLC %.3g MiB, strong N = %zu, weak N/thread = %zu, %lld steps\n",
+                cfg.max_threads, llc_bytes() / 1048576.0, cfg.strong_particles, cfg.weak_particles,
+                cfg.steps);
+    itphys::bench::Runner run("scaling", opt);
+    run_mode(run, "strong", cfg, false, threads, opt.reps);
+    run_mode(run, "weak", cfg, true, threads, opt.reps);
+    run_time_mode(run, cfg, threads);
+    return run.finish();
+}
@@ -0,0 +1,44 @@
+# 2段階 PGO ビルド（CMakeLists.txt の pgo ターゲットから cmake -P で実行する）
+#
+# 1. WORK_DIR/pgo に -fprofile-generate 付きでビルド
+# 2. 代表的なランジュバン計算（brownian_motion を 2×10^6 ステップ、langevin を既定条件）で学習
+# 3. 同じディレクトリを -fprofile-use で再構成して再ビルド
+#    （GCC はオブジェクトのパスでプロファイルを探すので、2段階とも同じディレクトリを使う）
+set(pgo_dir "${WORK_DIR}/pgo")
+set(profile_dir "${WORK_DIR}/pgo-profile")
+
+file(REMOVE_RECURSE "${profile_dir}")
+
+function(run_checked)
+  execute_process(COMMAND ${ARGN} RESULT_VARIABLE rc)
+  if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "PGO step failed (${rc}): ${ARGN}")
+  endif()
+endfunction()
+
+set(common_args
+  -DCMAKE_BUILD_TYPE=${BUILD_TYPE}
+  -DCMAKE_C_COMPILER=${C_COMPILER}
+  -DCMAKE_CXX_COMPILER=${CXX_COMPILER}
+  -DITPHYS_NATIVE=${NATIVE}
+  -DITPHYS_LTO=${LTO}
+  -DITPHYS_PGO_DIR=${profile_dir})
+
+message(STATUS "PGO stage 1: instrumented build in ${pgo_dir}")
+run_checked("${CMAKE_COMMAND}" -S "${SOURCE_DIR}" -B "${pgo_dir}" ${common_args} -DITPHYS_PGO=GENERATE)
+run_checked("${CMAKE_COMMAND}" --build "${pgo_dir}" --parallel)
+
+message(STATUS "PGO training: representative Langevin runs")
+run_checked("${pgo_dir}/bin/brownian_motion" 1.0 1.0 1.0 0.01 2000000 OUTPUT_FILE /dev/null)
+run_checked("${pgo_dir}/bin/langevin" 1 OUTPUT_FILE /dev/null)
+run_checked("${pgo_dir}/bin/normal_rand" 1000000 OUTPUT_FILE /dev/null)
+
+if(C_COMPILER MATCHES "clang")
+  file(GLOB raw_profiles "${profile_dir}/*.profraw")
+  find_program(LLVM_PROFDATA NAMES llvm-profdata REQUIRED)
+  run_checked("${LLVM_PROFDATA}" merge -output=${profile_dir}/default.profdata ${raw_profiles})
+endif()
+
+message(STATUS "PGO stage 2: optimized build in ${pgo_dir}")
+run_checked("${CMAKE_COMMAND}" -S "${SOURCE_DIR}" -B "${pgo_dir}" ${common_args} -DITPHYS_PGO=USE)
+run_checked("${CMAKE_COMMAND}" --build "${pgo_dir}" --parallel)
@@ -0,0 +1,31 @@
+/*
+ * 問題1 (2): ランジュバン方程式に基づく2次元軌道の計算（C++、libitphys を使用）
+ *
+ * m dv/dt = -γv + ξ(t),  dr/dt = v
+ * 初期条件: r0=(0,0), v0=(0,0)
+ * 1000 ステップ, Δt=0.01, γ=kB=T=m=1
+ * Box-Muller で正規乱数生成（itphys::NormalRng）
+ * 出力: t, x, y, vx, vy を標準出力へ
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "itphys/io.hpp"
+#include "itphys/langevin.hpp"
+#include "itphys/rng.hpp"
+
+int main(int argc, char **argv) {
+    itphys::LangevinParams p;  /* γ=kB=T=m=1, Δt=0.01, 1000 ステップ */
+
+    /* シード: 省略時または0なら固定のシード（毎回同じ軌道） */
+    std::uint64_t seed = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 0;
+    itphys::NormalRng rng(seed);
+
+    /* ヘッダ行と小数点以下6桁の5列 */
+    itphys::TextSink out(stdout, 6, true);
+    out.header();
+    itphys::run_brownian_motion(p, rng, out);
+    out.flush();
+    return 0;
+}
@@ -13,10 +13,15 @@ from _font_setup import setup_japanese_font
 setup_japanese_font()
 
 def run_langevin_c(seed):
-    """langevin.c を実行し、データを返す。seed=0 のときはC側の乱数に任せる。"""
-    cmd = ["./langevin", str(seed)] if seed != 0 else ["./langevin"]
+    """langevin を実行し、データを返す。seed=0 のときはC側の乱数に任せる。"""
+    here = os.path.dirname(os.path.abspath(__file__))
+    # CMake でビルドした実行ファイル（build/release/bin/langevin）を優先し、なければ同じディレクトリのものを使う
+    exe = os.path.join(here, "..", "..", "build", "release", "bin", "langevin")
+    if not os.path.exists(exe):
+        exe = "./langevin"
+    cmd = [exe, str(seed)] if seed != 0 else [exe]
     try:
-        out = subprocess.check_output(cmd, cwd=os.path.dirname(os.path.abspath(__file__)), text=True)
+        out = subprocess.check_output(cmd, cwd=here, text=True)
     except FileNotFoundError:
         # C が未コンパイルの場合は Python で同じシミュレーション
         return run_langevin_python(seed)
@@ -0,0 +1,99 @@
+/*
+ * itphys/active.hpp
+ *
+ * 自己推進する粒子（アクティブ・ブラウン粒子、2次元）
+ *
+ * 並進は run_brownian_motion と同じランジュバン方程式（オイラー法、EulerIntegrator）に、向き θ の方向の
+ * 推進力 γ v0 (cos θ, sin θ) を加えたもの（摩擦と釣り合うと速さ v0 で進む）。向きは回転拡散する:
+ *   m dv = (-γ v + γ v0 e(θ) + F(r)) dt + sqrt(2γkBT) dW,   dθ = sqrt(2 D_r) dW_θ      （τ_r = 1/D_r）
+ * 長時間の拡散係数は D_eff = kBT/γ + v0² τ_r / 2 になる（2次元）。
+ *
+ * 向きは回転数 u = θ/2π で持ち、毎ステップ [-1/2, 1/2] に戻す。cos θ, sin θ は force.hpp の
+ * sincos_2pi（分岐のない多項式）で計算するので、推進力のループは libm を呼ばずにSIMD化される。
+ * ブロック（EulerIntegrator::kNoiseBlock 粒子）ごとに推進力と外力を配列に書いてから
+ * EulerIntegrator::step_block(x, y, vx, vy, fx, fy, eta, b) で進める（並進の式は Suspension と同じ）。
+ * 乱数はブロックごとに (seed, ブロック番号) の列で、1粒子・1ステップに x, y, θ の3個。
+ * 初期状態は原点で静止、向きは一様分布。
+ *
+ * 理論値（外力がないとき、静止状態から。a = γ/m）:
+ *   MSD(t) = theoretical_msd_from_rest(t) + 2 v0² I(t)
+ *   ⟨v²⟩(t) = theoretical_v2_from_rest(t) + 2 a² v0² J(t)
+ * I, J は e^{-a t}, e^{-D_r t} などの積分の閉じた式（active.cpp）。a → ∞ で過減衰の
+ * MSD = 4Dt + (2v0²/D_r²)(D_r t - 1 + e^{-D_r t}) に、t → ∞ で ⟨v²⟩ → 2kBT/m + v0² a/(a + D_r) になる。
+ */
+
+#ifndef ITPHYS_ACTIVE_HPP
+#define ITPHYS_ACTIVE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "itphys/ensemble.hpp"
+#include "itphys/force.hpp"
+#include "itphys/langevin.hpp"
+#include "itphys/rng.hpp"
+
+namespace itphys {
+
+struct ActiveOptions {
+    std::size_t n_particles = 10000;
+    double v0 = 1.0;             // 自己推進の速さ
+    double rot_diffusion = 1.0;  // 回転拡散係数 D_r
+    Noise noise = Noise::kGaussian;
+    ForceField force;            // 外力（理論値は力のないときだけ）
+    std::uint64_t seed = 1;
+    int n_threads = 0;           // 0 なら OpenMP の既定（OMP_NUM_THREADS）
+};
+
+class ActiveBrownian {
+public:
+    /** @throw std::invalid_argument 粒子がない、m, γ が正でない、v0 や D_r が負のとき */
+    ActiveBrownian(const LangevinParams& p, const ActiveOptions& opt);
+
+    /** n ステップ進める */
+    void step(long long n = 1);
+
+    std::size_t size() const { return x_.size(); }
+    double time() const { return t_; }
+    const std::vector<double>& x() const { return x_; }
+    const std::vector<double>& y() const { return y_; }
+    const std::vector<double>& vx() const { return vx_; }
+    const std::vector<double>& vy() const { return vy_; }
+    /** 向き θ/2π（[-1/2, 1/2]） */
+    const std::vector<double>& turns() const { return u_; }
+
+    /** 1粒子あたりの平均二乗変位 */
+    double msd() const;
+    /** 1粒子あたりの運動エネルギー */
+    double kinetic_energy() const;
+
+private:
+    template <class Rng, class Force>
+    void advance(std::vector<Rng>& rngs, const Force& force, long long n_steps);
+
+    LangevinParams p_;
+    ActiveOptions opt_;
+    EulerIntegrator integ_;
+    int n_threads_;
+    double t_ = 0.0;
+    double push_;  // 推進力の大きさ γ v0
+    double turn_;  // 1ステップの向きの変化の標準偏差 sqrt(2 D_r Δt)/2π（回転数）
+
+    std::vector<double> x_, y_, vx_, vy_, u_;
+    std::vector<NormalRng> normal_;    // ブロックごとの乱数列（noise = gaussian）
+    std::vector<UniformNoise> uniform_;  // （noise = uniform）
+};
+
+/** 長時間の拡散係数 D_eff = kBT/γ + v0²/(2 D_r)（2次元） */
+double active_effective_diffusion(const LangevinParams& p, double v0, double rot_diffusion);
+
+/** 外力がないときの静止状態からの MSD(t)（向きは一様分布） */
+double active_theoretical_msd(double t, const LangevinParams& p, double v0, double rot_diffusion);
+
+/** 外力がないときの静止状態からの ⟨v²⟩(t) */
+double active_theoretical_v2(double t, const LangevinParams& p, double v0, double rot_diffusion);
+
+}  // namespace itphys
+
+#endif  // ITPHYS_ACTIVE_HPP
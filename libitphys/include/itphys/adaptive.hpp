@@ -0,0 +1,109 @@
+/*
+ * itphys/adaptive.hpp
+ *
+ * 収束するまで試行を足していくアンサンブル計算
+ *
+ * 粒子の本数を先に決めず、opt.ensemble.n_particles 個ずつのバッチを run_ensemble で計算しては集計に
+ * 足していき、目標量の標準誤差が許容値以下になるか、計算時間の予算を使い切ったところで止める。
+ * 目標量（AdaptiveTarget）:
+ *   kDiffusion  D_fit（後半の時刻の MSD/(2·dim·t) の平均。report1_haruki の msd モードと同じ）
+ *   kMsd        ⟨r²(t_end)⟩
+ *   kEnergy     ⟨E_kin(t_end)⟩
+ *
+ * 集計はバッチ単位のオンライン計算: バッチごとの各時刻の ⟨r²⟩, ⟨E_kin⟩ と目標量を RunningStats に
+ * 足すだけで、粒子ごとの値は持たない。D_fit は MSD の線形な関数なので、バッチの D_fit の平均は
+ * 全粒子の MSD から求めた D_fit に等しく、その標準誤差はバッチ間のばらつきから求まる
+ * （粒子ごとに D_fit を持たなくても誤差がわかる）。分散低減を使うと、バッチの値は
+ * EnsembleObservables::msd_reduced の推定値になる。
+ *
+ * 止める条件（バッチごとに判定する）:
+ * - min_batches 個以上のバッチがあり、標準誤差 <= max(tolerance, rel_tolerance·|推定値|)
+ * - max_batches 個のバッチを計算した
+ * - time_budget > 0 で、これまでのバッチの平均の時間だけもう1バッチ計算すると予算を超える
+ *   （誤差を求めるため、最初の2バッチは予算に関わらず計算する）
+ *
+ * バッチ b のブロック k の乱数列は (seed, first_stream + b·ブロック数 + k) なので、バッチの粒子数が
+ * kNoiseBlock の倍数なら、バッチの分け方に依らず同じ粒子の列を使う（N バッチで止まったときの
+ * 粒子は、N·n_particles 個を1回の run_ensemble で計算したときと同じ）。
+ *
+ *   itphys::AdaptiveOptions opt;
+ *   opt.ensemble.n_particles = 4096;
+ *   opt.rel_tolerance = 0.005;
+ *   const itphys::AdaptiveResult r = itphys::run_adaptive(p, opt);
+ *   std::printf("D = %g +- %g (%zu particles)\n", r.target.mean(), r.target.std_error(), r.particles);
+ */
+
+#ifndef ITPHYS_ADAPTIVE_HPP
+#define ITPHYS_ADAPTIVE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "itphys/ensemble.hpp"
+#include "itphys/langevin.hpp"
+#include "itphys/observables.hpp"
+
+namespace itphys {
+
+enum class AdaptiveTarget { kDiffusion, kMsd, kEnergy };
+
+inline const char* adaptive_target_name(AdaptiveTarget t) {
+    return t == AdaptiveTarget::kMsd ? "msd" : t == AdaptiveTarget::kEnergy ? "energy" : "diffusion";
+}
+
+/** "diffusion" / "msd" / "energy" を読む。知らない名前なら false */
+inline bool parse_adaptive_target(const std::string& name, AdaptiveTarget& out) {
+    for (AdaptiveTarget t : {AdaptiveTarget::kDiffusion, AdaptiveTarget::kMsd, AdaptiveTarget::kEnergy}) {
+        if (name == adaptive_target_name(t)) {
+            out = t;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** 止まった理由 */
+enum class AdaptiveStop { kTolerance, kTimeBudget, kMaxBatches };
+
+inline const char* adaptive_stop_name(AdaptiveStop s) {
+    return s == AdaptiveStop::kTimeBudget   ? "time_budget"
+           : s == AdaptiveStop::kMaxBatches ? "max_batches"
+                                            : "tolerance";
+}
+
+struct AdaptiveOptions {
+    EnsembleOptions ensemble;          // n_particles は1バッチの粒子数
+    AdaptiveTarget target = AdaptiveTarget::kDiffusion;
+    double tolerance = 0.0;            // 目標量の標準誤差の許容値（絶対）
+    double rel_tolerance = 0.01;       // 標準誤差 / |推定値| の許容値
+    double time_budget = 0.0;          // 計算時間の予算（秒、0 なら制限なし）
+    std::size_t min_batches = 8;       // 標準誤差を信用するのに要るバッチ数（2 未満は 2 とする）
+    std::size_t max_batches = 1 << 20;
+};
+
+struct AdaptiveResult {
+    std::vector<double> time;          // 各時刻（添字 0..n_steps）
+    std::vector<RunningStats> msd;     // バッチごとの ⟨r²⟩ の集計（mean が推定値、std_error はバッチ間の誤差）
+    std::vector<RunningStats> energy;  // バッチごとの ⟨E_kin⟩ の集計
+    RunningStats target;               // バッチごとの目標量
+    std::size_t batches = 0;
+    std::size_t particles = 0;
+    double seconds = 0.0;              // run_ensemble に掛かった時間の合計
+    AdaptiveStop stop = AdaptiveStop::kMaxBatches;
+};
+
+/**
+ * 止める条件を満たすまでバッチを足していく
+ *
+ * @param progress 各バッチの後に呼ぶ（途中経過の表示用。空なら呼ばない）
+ * @throw std::invalid_argument バッチの粒子数か max_batches が 0 のとき、その他 run_ensemble が
+ *                              投げるとき
+ */
+AdaptiveResult run_adaptive(const LangevinParams& p, const AdaptiveOptions& opt,
+                            const std::function<void(const AdaptiveResult&)>& progress = nullptr);
+
+}  // namespace itphys
+
+#endif  // ITPHYS_ADAPTIVE_HPP
@@ -0,0 +1,119 @@
+/*
+ * itphys/cache.hpp
+ *
+ * シミュレーション結果のキャッシュ（内容アドレス方式）
+ *
+ * 結果を一意に決める入力（パラメータ、シード、積分器、エンジンのバージョン）を文字列のキーにし、
+ * そのハッシュをファイル名にしてディレクトリに保存する。同じキーの2回目以降は再計算せず、
+ * ファイルを mmap して返す。キーの作り方は使う側が決める（server.hpp の cache_key()）。
+ *
+ * ファイル <dir>/<ハッシュ16桁>.itc の形式:
+ *   "ITPHYSC1" + キーの長さ (uint32) + 予約 (uint32)
+ *   キー（8バイト境界まで 0 で埋める。ハッシュの衝突はキーの比較で見分ける）
+ *   BinarySink と同じ形式の結果（16バイトのヘッダー + double × fields のレコード）
+ *
+ * 書き込みは一時ファイルに書いてから rename するので、複数のプロセス・スレッドから同時に
+ * 使ってよい。max_bytes を超えると、最後に使った時刻（mtime、ヒットのたびに更新する）が
+ * 古いものから消して max_bytes の 3/4 まで減らす。
+ */
+
+#ifndef ITPHYS_CACHE_HPP
+#define ITPHYS_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "itphys/io.hpp"
+
+namespace itphys {
+
+/** 数値結果が変わる変更（積分器・乱数・初期条件など）をしたら上げる。古いキャッシュは使われなくなる */
+constexpr std::uint32_t kEngineVersion = 1;
+
+/** mmap したキャッシュのエントリ（読み取り専用） */
+class CacheEntry {
+public:
+    CacheEntry() = default;
+    ~CacheEntry() { reset(); }
+
+    CacheEntry(CacheEntry&& o) noexcept { *this = std::move(o); }
+    CacheEntry& operator=(CacheEntry&& o) noexcept;
+    CacheEntry(const CacheEntry&) = delete;
+    CacheEntry& operator=(const CacheEntry&) = delete;
+
+    /** mmap したファイルを検査して持つ。形式が違えば false */
+    bool map(const std::string& path);
+    void reset();
+
+    bool mapped() const { return base_ != nullptr; }
+    std::string key() const;
+    /** BinarySink と同じ形式のバイト列（そのままファイルに書けば read_binary で読める） */
+    const char* binary() const { return base_ + payload_; }
+    std::size_t binary_size() const { return size_ - payload_; }
+    const double* records() const {
+        return reinterpret_cast<const double*>(base_ + payload_ + kBinaryHeaderSize);
+    }
+    std::size_t n_records() const { return n_records_; }
+    std::uint32_t n_fields() const { return n_fields_; }
+
+private:
+    char* base_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t payload_ = 0;
+    std::size_t n_records_ = 0;
+    std::uint32_t n_fields_ = 0;
+};
+
+class ResultCache {
+public:
+    /**
+     * @param dir       保存先（なければ作る）。作れなければ std::system_error
+     * @param max_bytes 合計の上限（0 なら無制限）
+     * @param verify    検証モード（ヒットしても再計算して一致を確かめる。判断は使う側が verify() を見て行う）
+     */
+    explicit ResultCache(std::string dir, std::uint64_t max_bytes = 0, bool verify = false);
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    /** key のエントリを探す。見つかれば out に mmap して true（最終使用時刻も更新する） */
+    bool find(const std::string& key, CacheEntry& out) const;
+
+    /** n_records × n_fields の結果を key で保存する（同じキーがあれば置き換える） */
+    void store(const std::string& key, const double* records, std::size_t n_records,
+               std::uint32_t n_fields = kStateFields);
+
+    /** 合計が max_bytes 以下になるまで古いものから消す。@return 消したバイト数 */
+    std::uint64_t evict(std::uint64_t max_bytes);
+
+    struct Stats {
+        std::size_t entries = 0;
+        std::uint64_t bytes = 0;
+    };
+    Stats stats() const;
+
+    /** 全エントリのパスについて f を呼ぶ */
+    void for_each(const std::function<void(const std::string& path)>& f) const;
+
+    bool verify() const { return verify_; }
+    const std::string& dir() const { return dir_; }
+
+    /** キーのハッシュ（64ビット FNV-1a） */
+    static std::uint64_t hash(const std::string& key);
+    std::string path_of(const std::string& key) const;
+
+private:
+    std::string dir_;
+    std::uint64_t max_bytes_;
+    bool verify_;
+    std::mutex mu_;
+    std::uint64_t approx_bytes_ = 0;  // 前回数えてから store した分を足した合計の見積もり
+};
+
+}  // namespace itphys
+
+#endif  // ITPHYS_CACHE_HPP
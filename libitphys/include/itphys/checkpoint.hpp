@@ -0,0 +1,107 @@
+/*
+ * itphys/checkpoint.hpp
+ *
+ * 計算の途中の状態の保存と復元（チェックポイント）
+ *
+ * Checkpoint は名前付きのバイト列（セクション）の集まりで、粒子の状態・乱数生成器の状態・
+ * 集計器・出力ファイルの位置などを入れて1つのファイルに保存する。復元した状態から続けると、
+ * 中断せずに計算した場合とビット単位で同じ結果になる。
+ *
+ *   itphys::Checkpoint ck;
+ *   itphys::save_state(ck, "rng", rng);
+ *   ck.put("step", step);
+ *   ck.save("run.ckpt");
+ *
+ *   const itphys::Checkpoint ck = itphys::Checkpoint::load("run.ckpt");
+ *   itphys::load_state(ck, "rng", rng);
+ *   const long long step = ck.get<long long>("step");
+ *
+ * ファイルの形式: "ITPHYSK1" + kEngineVersion (uint32) + セクション数 (uint32) の後に、
+ * セクションごとに 名前の長さ (uint32) + 予約 (uint32) + データの長さ (uint64) + 名前 + データ。
+ * 書き込みは一時ファイルに書いて fsync してから rename するので、途中で止まっても前の
+ * チェックポイントは壊れない。読めない・セクションがない・バージョンが違うときは
+ * std::runtime_error（ファイルの入出力の失敗は std::system_error）を投げる。
+ */
+
+#ifndef ITPHYS_CHECKPOINT_HPP
+#define ITPHYS_CHECKPOINT_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "itphys/langevin.hpp"
+#include "itphys/observables.hpp"
+#include "itphys/rng.hpp"
+
+namespace itphys {
+
+class Checkpoint {
+public:
+    void put_bytes(const std::string& name, const void* data, std::size_t n) {
+        sections_[name].assign(static_cast<const char*>(data), n);
+    }
+    void put(const std::string& name, const std::string& s) { put_bytes(name, s.data(), s.size()); }
+    template <class T>
+    void put(const std::string& name, const T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "put() needs a trivially copyable type");
+        put_bytes(name, &v, sizeof(T));
+    }
+    template <class T>
+    void put(const std::string& name, const std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "put() needs a trivially copyable type");
+        put_bytes(name, v.data(), v.size() * sizeof(T));
+    }
+
+    bool has(const std::string& name) const { return sections_.count(name) != 0; }
+    const std::string& get_bytes(const std::string& name) const;
+    std::string get_string(const std::string& name) const { return get_bytes(name); }
+    template <class T>
+    T get(const std::string& name) const {
+        static_assert(std::is_trivially_copyable<T>::value, "get() needs a trivially copyable type");
+        const std::string& b = get_bytes(name);
+        if (b.size() != sizeof(T)) throw std::runtime_error("checkpoint: bad size of " + name);
+        T v;
+        std::memcpy(&v, b.data(), sizeof(T));
+        return v;
+    }
+    template <class T>
+    std::vector<T> get_vector(const std::string& name) const {
+        static_assert(std::is_trivially_copyable<T>::value, "get() needs a trivially copyable type");
+        const std::string& b = get_bytes(name);
+        if (b.size() % sizeof(T) != 0) throw std::runtime_error("checkpoint: bad size of " + name);
+        std::vector<T> v(b.size() / sizeof(T));
+        if (!v.empty()) std::memcpy(v.data(), b.data(), b.size());
+        return v;
+    }
+
+    /** path に保存する（一時ファイル + fsync + rename） */
+    void save(const std::string& path) const;
+    static Checkpoint load(const std::string& path);
+
+private:
+    std::map<std::string, std::string> sections_;
+};
+
+// 各クラスの状態の保存と復元（セクション名は prefix + "." + 項目名）
+
+void save_state(Checkpoint& ck, const std::string& prefix, const NormalRng& rng);
+void load_state(const Checkpoint& ck, const std::string& prefix, NormalRng& rng);
+
+void save_state(Checkpoint& ck, const std::string& prefix, const Ensemble& e);
+void load_state(const Checkpoint& ck, const std::string& prefix, Ensemble& e);
+
+void save_state(Checkpoint& ck, const std::string& prefix, const MsdAccumulator& msd);
+/** msd は保存したときと同じ大きさで作っておく */
+void load_state(const Checkpoint& ck, const std::string& prefix, MsdAccumulator& msd);
+
+void save_state(Checkpoint& ck, const std::string& prefix, const EnergyHistogram& hist);
+void load_state(const Checkpoint& ck, const std::string& prefix, EnergyHistogram& hist);
+
+}  // namespace itphys
+
+#endif  // ITPHYS_CHECKPOINT_HPP
@@ -0,0 +1,200 @@
+/*
+ * itphys/ensemble.hpp
+ *
+ * 独立な多数の粒子（アンサンブル）の並列計算
+ *
+ * 粒子を EulerIntegrator::kNoiseBlock 個ずつのブロックに分け、ブロックごとに
+ * 独立な乱数列 NormalRng(seed, ブロック番号) を持たせる。そのため結果はスレッド数にも
+ * ループの順番（Schedule）にも依らない（集計の足し合わせの順番による丸め誤差を除く）。
+ *
+ * - kStepMajor:  全粒子を1ステップずつ進める（run_brownian_motion と同じ順番。
+ *                粒子数が多いと毎ステップ全粒子の状態をメモリから読み書きする）
+ * - kBlockMajor: 1ブロックを最後のステップまで進めてから次のブロックへ移る
+ *                （状態がキャッシュに収まり、粒子数に比例するメモリも不要）
+ *
+ * 積分器は EnsembleOptions::integrator で選ぶ（langevin.hpp の Integrator）。
+ * EnsembleOptions::force で外力（force.hpp の ForceField）を掛けられる（Euler と BAOAB のみ）。
+ * 力は使う項の組み合わせごとにインスタンス化した積分器のステップの中で計算するので、
+ * トラップの中の粒子も自由粒子とほぼ同じ速さで計算できる。
+ *
+ * 空間の次元 EnsembleOptions::dim（1〜3）とノイズ EnsembleOptions::noise（正規乱数か、分散の同じ
+ * 一様乱数 UniformNoise）もテンプレート引数で、run_ensemble() は最初に一度だけ
+ * 次元 × 積分器 × ノイズ × 外力の項の組み合わせを選んで、その組み合わせ専用の計算を呼ぶ。
+ * ⟨r²⟩ と運動エネルギーは全成分の和（2次元以外では理論値の係数も変わる。observables.hpp の dim）。
+ * EnergyHistogram のブロッキング解析は、ブロックごとの粒子の平均の運動エネルギーの系列（1ステップに1標本、
+ * 時刻の順）をブロックごとに別の BlockingStats で集計し、最後にレベルごとに足し合わせる
+ * （schedule に依らず τ_int の単位はステップ）。
+ *
+ * EnsembleOptions::precision = kMixed は単精度の混合精度モード: 速度と乱数を float で持って計算し
+ * （SIMD の幅が倍、1粒子・1成分の状態と乱数のメモリは 24 → 12 バイト）、位置は float と
+ * カハンの補償項の和で足していく（langevin.hpp の ParticleBlock<Dim, float>）。集計は double。
+ * 精度の損失（Δt = 0.01、γ = m = kBT = 1 で測った値）:
+ * - 2次元・2^16 粒子・t = 100 の ⟨r²⟩, ⟨E_kin⟩ は double との差が統計誤差（0.4%）の中に入る
+ * - 同じ乱数で進めた軌道の位置のずれ（1024 本の RMS）は t = 100, 10^3, 10^4 で 5e-6, 2e-5, 5e-5
+ *   （|r| の 3e-7 倍程度で、float の速度の丸めによる）。補償なしの float の位置では同じ時刻に
+ *   4e-5, 4e-4, 4e-3 と t に比例して広がる（|r| が大きくなると v Δt の下の桁が落ちるため）
+ *
+ * ⟨r²(t)⟩ の分散低減（EnsembleOptions::variance_reduction、組み合わせてよい）:
+ * - antithetic:      ブロックの後半の粒子に前半と符号を反転した乱数を使い、対の平均を1標本とする
+ *                    （力のない粒子では r² が乱数の符号に対して偶関数なので効かない。奇関数の量や
+ *                    非線形な外力があるときのためのもの）
+ * - control_variate: 各粒子に同じ乱数で動く厳密な OU 過程（ExactOuIntegrator）の影の粒子を付け、
+ *                    その r² を制御変量にする。期待値は theoretical_msd_from_rest で厳密にわかるので
+ *                    ⟨r²⟩ - β(⟨r²_影⟩ - 理論値) は不偏で、β は時刻ごとに Cov/Var で推定する
+ *                    （外力があっても影の粒子は自由粒子のままなので不偏だが、力が強いと相関が弱まる）
+ *                    （Euler・BAOAB では影のために1成分・1ステップあたり正規乱数が1個増える）
+ * - stratified:      各ステップ・各成分の乱数をブロック内でラテン超方格にする
+ * 分散低減を使うと、推定値・標準誤差・分散の低減率（同じ粒子数で独立に計算した場合の分散との比）を
+ * EnsembleObservables::msd_reduced に返す。層別ではブロック内の粒子が独立でないので、標準誤差は
+ * ブロックごとの平均のばらつきから求める（ブロックが2個以上必要）。
+ * 分散低減のときは schedule に依らずブロックごとに全ステップを計算する（乱数の使い方は別になる）。
+ * 分散低減は2次元・正規乱数・倍精度のときだけ使える。
+ */
+
+#ifndef ITPHYS_ENSEMBLE_HPP
+#define ITPHYS_ENSEMBLE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "itphys/langevin.hpp"
+#include "itphys/observables.hpp"
+
+namespace itphys {
+
+enum class Schedule { kStepMajor, kBlockMajor };
+
+/** 分散低減の方法（ensemble.hpp の先頭を参照） */
+struct VarianceReduction {
+    bool antithetic = false;
+    bool control_variate = false;
+    bool stratified = false;
+
+    bool any() const { return antithetic || control_variate || stratified; }
+};
+
+/** "antithetic,control,stratified" のような並び（"none" は何もしない）にする */
+inline std::string variance_reduction_name(const VarianceReduction& vr) {
+    std::string s;
+    if (vr.antithetic) s += "antithetic,";
+    if (vr.control_variate) s += "control,";
+    if (vr.stratified) s += "stratified,";
+    return s.empty() ? "none" : s.substr(0, s.size() - 1);
+}
+
+/** variance_reduction_name() の形式を読む。知らない名前があれば false */
+inline bool parse_variance_reduction(const std::string& list, VarianceReduction& out) {
+    VarianceReduction vr;
+    std::size_t pos = 0;
+    while (pos <= list.size()) {
+        const std::size_t end = std::min(list.find(',', pos), list.size());
+        const std::string name = list.substr(pos, end - pos);
+        if (name == "antithetic") {
+            vr.antithetic = true;
+        } else if (name == "control") {
+            vr.control_variate = true;
+        } else if (name == "stratified") {
+            vr.stratified = true;
+        } else if (name != "none") {
+            return false;
+        }
+        pos = end + 1;
+    }
+    out = vr;
+    return true;
+}
+
+/** 積分器に入れるノイズ（Gaussian は NormalRng、Uniform は UniformNoise） */
+enum class Noise { kGaussian, kUniform };
+
+inline const char* noise_name(Noise k) {
+    return k == Noise::kUniform ? "uniform" : "gaussian";
+}
+
+/** "gaussian" / "uniform" を読む。知らない名前なら false */
+inline bool parse_noise(const std::string& name, Noise& out) {
+    for (Noise k : {Noise::kGaussian, Noise::kUniform}) {
+        if (name == noise_name(k)) {
+            out = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** 状態と乱数の精度（kMixed は float ＋位置の補償項、ensemble.hpp の先頭を参照） */
+enum class Precision { kDouble, kMixed };
+
+inline const char* precision_name(Precision k) {
+    return k == Precision::kMixed ? "mixed" : "double";
+}
+
+/** "double" / "mixed" を読む。知らない名前なら false */
+inline bool parse_precision(const std::string& name, Precision& out) {
+    for (Precision k : {Precision::kDouble, Precision::kMixed}) {
+        if (name == precision_name(k)) {
+            out = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct EnsembleOptions {
+    std::size_t n_particles = 1000;
+    std::uint64_t seed = 1;
+    std::uint64_t first_stream = 0;  // ブロック k の乱数列は (seed, first_stream + k)（バッチごとに別の列を使うため）
+    int n_threads = 0;  // 0 なら OpenMP の既定（OMP_NUM_THREADS）
+    Schedule schedule = Schedule::kBlockMajor;
+    Integrator integrator = Integrator::kEuler;
+    VarianceReduction variance_reduction;
+    ForceField force;  // 外力（既定は力なし）
+    int dim = 2;       // 空間の次元（1, 2, 3）
+    Noise noise = Noise::kGaussian;
+    Precision precision = Precision::kDouble;
+};
+
+/** 分散低減した ⟨r²(t)⟩ の推定値 */
+struct ReducedEstimate {
+    double mean = 0.0;
+    double std_error = 0.0;
+    double factor = 1.0;  // 分散の低減率（独立な粒子の標本平均の分散 / この推定値の分散）
+};
+
+/** 各時刻（添字 0..n_steps）の ⟨r²⟩ と ⟨E_kin⟩（どちらも全成分の和） */
+struct EnsembleObservables {
+    explicit EnsembleObservables(std::size_t n_times) : msd(n_times), energy(n_times) {}
+
+    void merge(const EnsembleObservables& o) {
+        msd.merge(o.msd);
+        for (std::size_t i = 0; i < energy.size() && i < o.energy.size(); i++) {
+            energy[i].merge(o.energy[i]);
+        }
+    }
+
+    MsdAccumulator msd;
+    std::vector<RunningStats> energy;
+    std::vector<ReducedEstimate> msd_reduced;  // 分散低減を使ったときだけ（各時刻）
+};
+
+/**
+ * 初期条件 r = v = 0 の粒子 opt.n_particles 個を p.n_steps ステップ並列に計算する
+ *
+ * @param obs  各時刻の集計先（nullptr なら集計しない）。大きさは p.n_steps + 1 以上
+ * @param hist 全粒子・全時刻の運動エネルギーのヒストグラム（nullptr なら集計しない）
+ * @return 実際に使ったスレッド数
+ * @throw std::invalid_argument 外力があり積分器が ExactOu のとき、dim が 1〜3 でないとき、
+ *                              分散低減を2次元以外か一様乱数のノイズか混合精度で使おうとしたとき
+ */
+int run_ensemble(const LangevinParams& p, const EnsembleOptions& opt,
+                 EnsembleObservables* obs = nullptr, EnergyHistogram* hist = nullptr);
+
+/** 使えるスレッド数の上限（OpenMP なしなら 1） */
+int max_threads();
+
+}  // namespace itphys
+
+#endif  // ITPHYS_ENSEMBLE_HPP
@@ -0,0 +1,124 @@
+/*
+ * itphys/first_passage.hpp
+ *
+ * 初通過時間（FPT）の分布
+ *
+ * 原点（または start_x, start_y）に静止した粒子を run_brownian_motion と同じオイラー法（外力も同じ
+ * force.hpp の ForceField）で進め、吸収条件
+ *   kRadius   |r| >= R                （円の外に出る）
+ *   kBarrier  x >= X                  （障壁を越える。2重井戸なら Kramers の脱出時間）
+ * を初めて満たしたステップの時刻を記録して、その粒子の計算をやめる。t_max までに出なかった粒子は
+ * 打ち切り（censored）として数える。
+ *
+ * 粒子は kNoiseBlock（1024）本のレーンのブロックにまとめ、ブロックごとに1スレッドで進める。
+ * レーンの扱い（FptLanes）:
+ * - kRefill: 吸収された粒子のレーンにすぐ次の粒子を入れる（同じステップから始める）。ブロックの
+ *   受け持ちの粒子を全て入れ終わったら、空いたレーンに最後の使用中のレーンを移して詰め、
+ *   ステップのループは使用中のレーン [0, active) だけを回す。レーンは常に詰まっているので
+ *   積分と吸収の判定のループは最後までSIMDの幅いっぱいで動き、乱数も使用中のレーンの分だけ作る
+ * - kMask: 比較用。1024 個ずつ一斉に始め、全員が吸収されるか t_max になるまで全レーンを進める
+ *   （吸収された粒子も進め続ける。固定ステップで計算して後から初通過を探すのと同じ仕事量）
+ * 乱数はブロックごとに NormalRng(seed, ブロック番号)、粒子はブロックに番号順に均等に割り当てるので、
+ * 結果はスレッド数に依らない（レーン数とレーンの扱いを変えると乱数の使い方が変わる）。
+ *
+ *   itphys::FptOptions opt;
+ *   opt.condition = itphys::FptCondition::kRadius;
+ *   opt.threshold = 5.0;
+ *   const itphys::FptResult r = itphys::run_first_passage(p, opt);
+ *   for (std::size_t i = 0; i < r.n_bins(); i++) std::printf("%g %g %g\n", r.bin_center(i), r.density(i), r.density_error(i));
+ */
+
+#ifndef ITPHYS_FIRST_PASSAGE_HPP
+#define ITPHYS_FIRST_PASSAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "itphys/force.hpp"
+#include "itphys/langevin.hpp"
+#include "itphys/observables.hpp"
+
+namespace itphys {
+
+enum class FptCondition { kRadius, kBarrier };
+
+inline const char* fpt_condition_name(FptCondition c) {
+    return c == FptCondition::kBarrier ? "barrier" : "radius";
+}
+
+/** "radius" / "barrier" を読む。知らない名前なら false */
+inline bool parse_fpt_condition(const std::string& name, FptCondition& out) {
+    for (FptCondition c : {FptCondition::kRadius, FptCondition::kBarrier}) {
+        if (name == fpt_condition_name(c)) {
+            out = c;
+            return true;
+        }
+    }
+    return false;
+}
+
+enum class FptLanes { kRefill, kMask };
+
+inline const char* fpt_lanes_name(FptLanes l) {
+    return l == FptLanes::kMask ? "mask" : "refill";
+}
+
+/** "refill" / "mask" を読む。知らない名前なら false */
+inline bool parse_fpt_lanes(const std::string& name, FptLanes& out) {
+    for (FptLanes l : {FptLanes::kRefill, FptLanes::kMask}) {
+        if (name == fpt_lanes_name(l)) {
+            out = l;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct FptOptions {
+    std::size_t n_walkers = 100000;      // 粒子の総数
+    std::size_t n_lanes = 16 * 1024;     // 同時に進める粒子の数（kNoiseBlock の倍数に切り上げる）
+    FptCondition condition = FptCondition::kRadius;
+    double threshold = 3.0;              // R または X
+    double start_x = 0.0, start_y = 0.0;
+    double t_max = 100.0;                // これより長くかかる粒子は打ち切る
+    std::size_t n_bins = 100;            // [0, t_max) のヒストグラムのビン数
+    FptLanes lanes = FptLanes::kRefill;
+    ForceField force;
+    std::uint64_t seed = 1;
+    int n_threads = 0;                   // 0 なら OpenMP の既定（OMP_NUM_THREADS）
+};
+
+struct FptResult {
+    std::vector<unsigned long long> counts;  // ビンごとの吸収された粒子の数
+    double t_max = 0.0;
+    unsigned long long walkers = 0;          // 粒子の総数（打ち切りを含む）
+    unsigned long long censored = 0;         // t_max までに吸収されなかった粒子
+    unsigned long long lane_steps = 0;       // 進めたレーン・ステップの総数（仕事量）
+    RunningStats times;                      // 吸収された粒子の初通過時間
+
+    std::size_t n_bins() const { return counts.size(); }
+    double bin_width() const { return t_max / counts.size(); }
+    double bin_center(std::size_t i) const { return (i + 0.5) * bin_width(); }
+    /** 初通過時間の確率密度（打ち切られた粒子も全体数に含めて規格化する） */
+    double density(std::size_t i) const {
+        return walkers > 0 ? counts[i] / (walkers * bin_width()) : 0.0;
+    }
+    /** density(i) の標準誤差（ビンの数は二項分布: sqrt(n p (1 - p))） */
+    double density_error(std::size_t i) const;
+    /** レーン・ステップのうち、まだ吸収されていない粒子を進めた割合 */
+    double lane_utilization(double dt) const;
+};
+
+/**
+ * 初通過時間の分布を求める
+ *
+ * @throw std::invalid_argument 粒子やビンがない、t_max や dt が正でない、kRadius で threshold <= 0、
+ *                              出発点がすでに吸収条件を満たすとき
+ */
+FptResult run_first_passage(const LangevinParams& p, const FptOptions& opt);
+
+}  // namespace itphys
+
+#endif  // ITPHYS_FIRST_PASSAGE_HPP
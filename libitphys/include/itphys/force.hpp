@@ -0,0 +1,247 @@
+/*
+ * itphys/force.hpp
+ *
+ * 外部ポテンシャルによる力
+ *
+ * 組み込みのポテンシャル（それぞれ力 F = -∇U を (fx, fy) に足す関数オブジェクト）:
+ *   HarmonicForce    U = (kx/2)(x - x0)² + (ky/2)(y - y0)²               （調和トラップ）
+ *   WashboardForce   U = -V0 cos(2πx/L) - F x                           （傾いた周期ポテンシャル、x 方向）
+ *   DoubleWellForce  U = ΔU ((x/a)² - 1)²                                 （x = ±a に極小、x 方向）
+ *
+ * どれも分岐のない数式だけで書いてあり、積分器の step_block のループの中でインライン展開されて
+ * 粒子についてのループごとSIMD化される（sin は libm を呼ばずに sin_2pi の多項式で計算する）。
+ * 力は積分器のステップの中で位置を読んだその場で計算するので、力のための配列もメモリの往復もない。
+ *
+ * 合成は SumForce<A, B>（静的、項ごとにインライン展開）と、実行時に選ぶ ForceField
+ * （3つの項のそれぞれを使うかどうか）の2通り。ForceField は visit_force() で使う項だけを
+ * SumForce にまとめた型に変換してから積分器に渡すので、使わない項の計算は入らない:
+ *
+ *   itphys::ForceField ff;
+ *   itphys::parse_force_field("harmonic:k=2+washboard:v0=1,period=1,tilt=0.5", ff);
+ *   itphys::visit_force(ff, [&](const auto& force) { integ.step_block(x, y, vx, vy, eta, b, force); });
+ *
+ * 文字列の形式（force_field_name() / parse_force_field()）: 項を '+' でつなぎ、各項は
+ * "名前:キー=値,..."（省略したキーは既定値）。"none" は力なし。
+ *   harmonic:k=,kx=,ky=,x0=,y0=     （k は kx = ky = k の略記）
+ *   washboard:v0=,period=,tilt=
+ *   double_well:barrier=,a=
+ */
+
+#ifndef ITPHYS_FORCE_HPP
+#define ITPHYS_FORCE_HPP
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace itphys {
+
+/**
+ * 最も近い整数（|u| < 2^51、丸めは偶数への丸め）
+ * 1.5 × 2^52 を足して引くと小数部が丸めで落ちる。std::nearbyint と違って SSE4.1 がなくてもSIMD化される
+ */
+inline double nearest_integer(double u) {
+    constexpr double kRound = 6755399441055744.0;  // 1.5 × 2^52
+    return (u + kRound) - kRound;
+}
+
+/**
+ * sin(2πu)（|u| < 2^51）
+ * u を [-1/2, 1/2] に、さらに sin(π - θ) = sin θ と奇関数であることで [0, π/2] に畳んでから 21 次の
+ * テイラー多項式で計算する（相対誤差 1e-15 程度）。分岐がないのでループの中でSIMD化される
+ */
+inline double sin_2pi(double u) {
+    u -= nearest_integer(u);
+    const double w = 2.0 * u;  // [-1, 1]、sin(πw) = sign(w) sin(π min(|w|, 1 - |w|))
+    const double a = std::fabs(w);
+    const double r = a < 1.0 - a ? a : 1.0 - a;
+    const double x = 3.141592653589793 * r;
+    const double x2 = x * x;
+    double s = 1.0 / 51090942171709440000.0;  // 1/21!
+    s = s * x2 - 1.0 / 121645100408832000.0;  // 1/19!
+    s = s * x2 + 1.0 / 355687428096000.0;
+    s = s * x2 - 1.0 / 1307674368000.0;
+    s = s * x2 + 1.0 / 6227020800.0;
+    s = s * x2 - 1.0 / 39916800.0;
+    s = s * x2 + 1.0 / 362880.0;
+    s = s * x2 - 1.0 / 5040.0;
+    s = s * x2 + 1.0 / 120.0;
+    s = s * x2 - 1.0 / 6.0;
+    return std::copysign(x + x * x2 * s, w);
+}
+
+/**
+ * sin(2πu) と cos(2πu) を同時に（|u| < 2^49）
+ * 最も近い四分円 q = round(4u) で x = 2π(u - q/4) ∈ [-π/4, π/4] に縮め、sin x（17 次）と cos x（16 次）の
+ * テイラー多項式を1回ずつ計算して sin(x + kπ/2), cos(x + kπ/2)（k = q mod 4）に回す（相対誤差 1e-15 程度）。
+ * 縮約を共有するので sin_2pi を2回呼ぶより軽く、分岐も比較もないのでループの中でSIMD化される
+ */
+inline void sincos_2pi(double u, double& s, double& c) {
+    const double q = nearest_integer(4.0 * u);
+    const double x = 6.283185307179586 * (u - 0.25 * q);
+    const double x2 = x * x;
+    double ps = 1.0 / 355687428096000.0;  // 1/17!
+    ps = ps * x2 - 1.0 / 1307674368000.0;
+    ps = ps * x2 + 1.0 / 6227020800.0;
+    ps = ps * x2 - 1.0 / 39916800.0;
+    ps = ps * x2 + 1.0 / 362880.0;
+    ps = ps * x2 - 1.0 / 5040.0;
+    ps = ps * x2 + 1.0 / 120.0;
+    ps = ps * x2 - 1.0 / 6.0;
+    ps = x + x * x2 * ps;
+    double pc = 1.0 / 20922789888000.0;  // 1/16!
+    pc = pc * x2 - 1.0 / 87178291200.0;
+    pc = pc * x2 + 1.0 / 479001600.0;
+    pc = pc * x2 - 1.0 / 3628800.0;
+    pc = pc * x2 + 1.0 / 40320.0;
+    pc = pc * x2 - 1.0 / 720.0;
+    pc = pc * x2 + 1.0 / 24.0;
+    pc = pc * x2 - 0.5;
+    pc = 1.0 + x2 * pc;
+    // k = q mod 4 ∈ {-2, ..., 2} の cos(kπ/2), sin(kπ/2) は整数 k の多項式で厳密に求まる（選択の命令がいらない）
+    const double k = q - 4.0 * nearest_integer(0.25 * q);
+    const double k2 = k * k;
+    const double ck = 1.0 + k2 * (k2 - 7.0) / 6.0;
+    const double sk = k * (4.0 - k2) / 3.0;
+    s = ck * ps + sk * pc;
+    c = ck * pc - sk * ps;
+}
+
+/** 力なし（積分器は力のない場合と同じ計算をする） */
+struct NoForce {
+    void operator()(double, double, double&, double&) const {}
+    double potential(double, double) const { return 0.0; }
+};
+
+/** 調和トラップ U = (kx/2)(x - x0)² + (ky/2)(y - y0)² */
+struct HarmonicForce {
+    double kx = 1.0, ky = 1.0;
+    double x0 = 0.0, y0 = 0.0;
+
+    void operator()(double x, double y, double& fx, double& fy) const {
+        fx -= kx * (x - x0);
+        fy -= ky * (y - y0);
+    }
+    double potential(double x, double y) const {
+        return 0.5 * kx * (x - x0) * (x - x0) + 0.5 * ky * (y - y0) * (y - y0);
+    }
+};
+
+/** 傾いた周期ポテンシャル U = -V0 cos(2πx/L) - F x（x 方向だけ） */
+struct WashboardForce {
+    double v0 = 1.0;
+    double period = 1.0;
+    double tilt = 0.0;
+
+    void operator()(double x, double, double& fx, double&) const {
+        fx += tilt - v0 * (6.283185307179586 / period) * sin_2pi(x / period);
+    }
+    double potential(double x, double) const {
+        return -v0 * std::cos(6.283185307179586 * x / period) - tilt * x;
+    }
+};
+
+/** 2重井戸 U = ΔU ((x/a)² - 1)²（x 方向だけ、障壁の高さ ΔU、極小 x = ±a） */
+struct DoubleWellForce {
+    double barrier = 1.0;
+    double a = 1.0;
+
+    void operator()(double x, double, double& fx, double&) const {
+        const double u = x / a;
+        fx -= 4.0 * barrier / a * u * (u * u - 1.0);
+    }
+    double potential(double x, double) const {
+        const double u = x / a;
+        return barrier * (u * u - 1.0) * (u * u - 1.0);
+    }
+};
+
+/** 2つの力の和（どちらもインライン展開される） */
+template <class A, class B>
+struct SumForce {
+    A a;
+    B b;
+
+    void operator()(double x, double y, double& fx, double& fy) const {
+        a(x, y, fx, fy);
+        b(x, y, fx, fy);
+    }
+    double potential(double x, double y) const { return a.potential(x, y) + b.potential(x, y); }
+};
+
+/** 実行時に組み合わせを選ぶ力（使う項の on を true にする） */
+struct ForceField {
+    bool harmonic_on = false;
+    HarmonicForce harmonic;
+    bool washboard_on = false;
+    WashboardForce washboard;
+    bool double_well_on = false;
+    DoubleWellForce double_well;
+
+    bool any() const { return harmonic_on || washboard_on || double_well_on; }
+};
+
+namespace detail {
+
+template <class Acc, class Term, class Next>
+decltype(auto) visit_term(bool on, const Acc& acc, const Term& term, Next&& next) {
+    if (on) return next(SumForce<Acc, Term>{acc, term});
+    return next(acc);
+}
+
+}  // namespace detail
+
+/**
+ * ff で使う項だけをまとめた力の関数オブジェクトで body(force) を呼ぶ
+ * （項の組み合わせごとに body がインスタンス化される。力がなければ NoForce）
+ */
+template <class Body>
+decltype(auto) visit_force(const ForceField& ff, Body&& body) {
+    if (!ff.any()) return body(NoForce());
+    // 最初の項は NoForce と組み合わせずにそのまま使う
+    const auto rest = [&](const auto& first) {
+        return detail::visit_term(ff.washboard_on, first, ff.washboard, [&](const auto& f) {
+            return detail::visit_term(ff.double_well_on, f, ff.double_well, body);
+        });
+    };
+    if (ff.harmonic_on) return rest(ff.harmonic);
+    if (ff.washboard_on) {
+        return detail::visit_term(ff.double_well_on, ff.washboard, ff.double_well, body);
+    }
+    return body(ff.double_well);
+}
+
+/** parse_force_field() で読める形式（実数は %a で正確に書く。力がなければ "none"） */
+inline std::string force_field_name(const ForceField& ff) {
+    char buf[512];
+    std::string s;
+    if (ff.harmonic_on) {
+        const HarmonicForce& h = ff.harmonic;
+        std::snprintf(buf, sizeof(buf), "harmonic:kx=%a,ky=%a,x0=%a,y0=%a", h.kx, h.ky, h.x0, h.y0);
+        s += buf;
+    }
+    if (ff.washboard_on) {
+        const WashboardForce& w = ff.washboard;
+        std::snprintf(buf, sizeof(buf), "%swashboard:v0=%a,period=%a,tilt=%a", s.empty() ? "" : "+",
+                      w.v0, w.period, w.tilt);
+        s += buf;
+    }
+    if (ff.double_well_on) {
+        const DoubleWellForce& d = ff.double_well;
+        std::snprintf(buf, sizeof(buf), "%sdouble_well:barrier=%a,a=%a", s.empty() ? "" : "+",
+                      d.barrier, d.a);
+        s += buf;
+    }
+    return s.empty() ? "none" : s;
+}
+
+/**
+ * force_field_name() の形式を読む
+ *
+ * @return 知らない名前・キー、読めない値、period <= 0 や a <= 0、同じ項の重複があれば false
+ */
+bool parse_force_field(const std::string& spec, ForceField& out);
+
+}  // namespace itphys
+
+#endif  // ITPHYS_FORCE_HPP
@@ -0,0 +1,140 @@
+/*
+ * itphys/gle.hpp
+ *
+ * 記憶のある摩擦の一般化ランジュバン方程式（GLE、粘弾性の媒質の中の2次元の粒子）
+ *
+ *   m dv/dt = F(r) - γ0 v - ∫_0^t K(t - s) v(s) ds + ξ(t) + sqrt(2γ0 kBT) η(t)
+ *   ⟨ξ(t) ξ(s)⟩ = kBT K(|t - s|)                                        （揺動散逸定理）
+ *
+ * 記憶の核はプロニー級数（指数関数の和） K(t) = Σ_k (γ_k/τ_k) e^{-t/τ_k} で表す（γ_k はモード k の
+ * 静的な摩擦 ∫K dt への寄与、τ_k は緩和時間）。各モードに補助変数 z_k（記憶の力と色のついたノイズの和）を
+ * 1つずつ持たせると、履歴の畳み込みなしのマルコフ過程になる:
+ *   m dv = (F + Σ_k z_k - γ0 v) dt + sqrt(2γ0 kBT) dW_0
+ *   dz_k = -(z_k/τ_k + c_k v) dt + sqrt(2 c_k kBT/τ_k) dW_k              （c_k = γ_k/τ_k）
+ * 平衡分布は v ~ N(0, kBT/m), z_k ~ N(0, c_k kBT)（全て独立）で、z_k の相関がちょうど kBT K(t) になる。
+ *
+ * 積分は BAOAB と同じ B-A-O-A-B 分割で、O（v と z_k の線形な部分）をさらにモードごとの (v, z_k) の
+ * 2変数の OU 過程と γ0 の部分に分け、それぞれを厳密な遷移（2×2 の行列の指数関数と、残りの共分散の
+ * コレスキー分解。係数はコンストラクタで一度だけ計算する）で進める。どの部分も平衡分布を厳密に保つので、
+ * 外力がなければ Δt によらず ⟨v²⟩ = kBT/m, ⟨z_k²⟩ = c_k kBT のまま（揺動散逸定理が離散化でも成り立つ）。
+ * 1ステップの費用はモード数に比例する（1粒子・1成分あたり乱数 2 個 × モード数、γ0 > 0 なら +1）。
+ *
+ * 初期状態は原点で、v と z_k は平衡分布から引く（平衡状態の速度自己相関と MSD を理論値と比べられる）。
+ * 自由粒子の理論値は、スケールした変数 (v/σ_v, z_k/σ_k) のドリフト行列 A（(1+モード数) 次の正方行列）から
+ *   ⟨v(t)·v(0)⟩ = 2 (kBT/m) [e^{-At}]_00,   MSD(t) = 4 (kBT/m) [A^{-1} t - A^{-2} (I - e^{-At})]_00
+ * で計算する（長時間で MSD → 4 D t、D = kBT/(γ0 + Σ γ_k)）。
+ *
+ *   itphys::GleOptions opt;
+ *   itphys::parse_memory_kernel("1:0.1,4:2", opt.kernel);   // γ_k:τ_k をカンマで並べる
+ *   itphys::GleEnsemble g(p, opt);                          // p.gamma は記憶のない摩擦 γ0（0 でもよい）
+ *   g.step(1000);
+ *   std::printf("%g %g\n", g.msd(), itphys::gle_theoretical_msd(p, opt.kernel, g.time()));
+ */
+
+#ifndef ITPHYS_GLE_HPP
+#define ITPHYS_GLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "itphys/force.hpp"
+#include "itphys/langevin.hpp"
+#include "itphys/rng.hpp"
+
+namespace itphys {
+
+/** プロニー級数の1項 (γ_k/τ_k) e^{-t/τ_k} */
+struct PronyMode {
+    double gamma = 1.0;  // ∫ K dt への寄与
+    double tau = 1.0;    // 緩和時間
+};
+
+/** 記憶の核 K(t) = Σ_k (γ_k/τ_k) e^{-t/τ_k} */
+struct MemoryKernel {
+    std::vector<PronyMode> modes;
+
+    /** K(t) */
+    double operator()(double t) const;
+    /** ∫_0^∞ K dt = Σ γ_k */
+    double static_friction() const;
+};
+
+/** parse_memory_kernel() で読める形式（"γ:τ,γ:τ,..."。モードがなければ "none"） */
+std::string memory_kernel_name(const MemoryKernel& k);
+
+/**
+ * "γ_1:τ_1,γ_2:τ_2,..." を読む（"none" はモードなし）
+ *
+ * @return 読めない値、γ_k や τ_k が正でないものがあれば false
+ */
+bool parse_memory_kernel(const std::string& spec, MemoryKernel& out);
+
+struct GleOptions {
+    std::size_t n_particles = 10000;
+    MemoryKernel kernel;
+    ForceField force;  // 外力（理論値は力のないときだけ）
+    std::uint64_t seed = 1;
+    int n_threads = 0;  // 0 なら OpenMP の既定（OMP_NUM_THREADS）
+};
+
+class GleEnsemble {
+public:
+    /**
+     * p.T, p.kB, p.m, p.dt と記憶のない摩擦 γ0 = p.gamma を使う
+     *
+     * @throw std::invalid_argument 粒子がない、m や τ_k, γ_k が正でない、γ0 < 0、摩擦の合計が 0 のとき
+     */
+    GleEnsemble(const LangevinParams& p, const GleOptions& opt);
+
+    /** n ステップ進める */
+    void step(long long n = 1);
+
+    std::size_t size() const { return x_.size(); }
+    std::size_t n_modes() const { return modes_.size(); }
+    double time() const { return t_; }
+    const std::vector<double>& x() const { return x_; }
+    const std::vector<double>& y() const { return y_; }
+    const std::vector<double>& vx() const { return vx_; }
+    const std::vector<double>& vy() const { return vy_; }
+
+    /** 1粒子あたりの平均二乗変位 */
+    double msd() const;
+    /** 1粒子あたりの速度自己相関 ⟨v(t)·v(0)⟩ */
+    double velocity_autocorrelation() const;
+    /** 1粒子あたりの運動エネルギー */
+    double kinetic_energy() const;
+    /** 補助変数の温度 ⟨z_k²⟩ / (c_k kB)（全モード・全成分の平均。揺動散逸定理が成り立てば T） */
+    double auxiliary_temperature() const;
+
+private:
+    /** モード k の (v, z_k) の厳密な遷移 v' = a_vv v + a_vz z + n_v η1, z' = a_zv v + a_zz z + n_zv η1 + n_zz η2 */
+    struct ModeStep {
+        double a_vv, a_vz, a_zv, a_zz;
+        double n_v, n_zv, n_zz;
+    };
+
+    LangevinParams p_;
+    ForceField force_;
+    int n_threads_;
+    double t_ = 0.0;
+    std::vector<PronyMode> modes_;
+    std::vector<ModeStep> steps_;
+    double c0_, noise0_;  // γ0 の部分の v' = c0 v + noise0 η（γ0 = 0 なら使わない）
+    int noise_per_dim_;   // 1粒子・1成分・1ステップの乱数の個数
+
+    std::vector<double> x_, y_, vx_, vy_, vx0_, vy0_;
+    std::vector<double> z_;  // モード k、成分 d の補助変数は z_[(2k + d) n .. (2k + d + 1) n)
+    std::vector<NormalRng> rngs_;  // ブロックごとの乱数列
+};
+
+/** 自由粒子の平衡状態での ⟨v(t)·v(0)⟩（2次元、p.gamma は γ0） */
+double gle_theoretical_vacf(const LangevinParams& p, const MemoryKernel& kernel, double t);
+
+/** 自由粒子の平衡状態から測った MSD(t)（2次元） */
+double gle_theoretical_msd(const LangevinParams& p, const MemoryKernel& kernel, double t);
+
+}  // namespace itphys
+
+#endif  // ITPHYS_GLE_HPP
@@ -0,0 +1,140 @@
+/*
+ * itphys/hydrodynamics.hpp
+ *
+ * 流体力学的相互作用のあるブラウン動力学（BD-HI、過減衰）
+ *
+ * 粒子の速度が他の粒子に働く力にもよる場合、Ermak-McCammon の式
+ *   r_{n+1} = r_n + M F Δt + sqrt(2 kBT Δt) M^{1/2} ξ_n      （ξ_n は 2N 個の独立な N(0,1)）
+ * で進める（M は 2N × 2N の移動度テンソル）。3次元の RPY では ∇·M = 0 だが、平面内の xy 成分だけの M では
+ * M_ij = μ0 (c1 I + c2 r̂r̂ᵀ r²) の発散が ∂_{r_j}·M_ij = μ0 c2(r_ij) (r_i - r_j) になるので、伊藤のドリフト
+ * kBT Δt ∇·M を足す（足さないと力のない分散系がボルツマン分布に緩和しない）。
+ * ノイズは粒子間で相関するので、各軸に独立な normal_rand() を使う過減衰の式はそのままでは使えない。
+ *
+ * 移動度は Rotne-Prager-Yamakawa（半径 a の球が1つの平面内にあるとして、3次元の式の xy 成分を使う。
+ * 正定値な行列の主小行列なので正定値のまま）:
+ *   M_ii = μ0 I,   μ0 = 1/γ（孤立した粒子の拡散係数は D = kBT/γ で、ランジュバン方程式と同じ）
+ *   r >= 2a:  M_ij = μ0 [(3a/4r + a³/2r³) I + (3a/4r - 3a³/2r³) r̂r̂ᵀ]
+ *   r <  2a:  M_ij = μ0 [(1 - 9r/32a) I + (3r/32a) r̂r̂ᵀ]
+ *
+ * 行列は作らない: RpyMobility::apply は M f を粒子の組ごとに直接足す（O(N²)、粒子ごとに
+ * 担当のスレッドが自分の速度だけを書く）。M^{1/2} ξ は krylov_sqrt() のランチョス法で
+ * M の積だけから近似する（Krylov 部分空間 V_m で M^{1/2} ξ ≈ |ξ| V_m T_m^{1/2} e_1、
+ * T_m は m × m の3重対角行列。隣り合う m での近似の差が tolerance 以下になるまで m を増やす）。
+ * 1ステップの費用は (1 + m) 回の M の積と1回の ∇·M（どれも O(N²)）で、m は粒子数にほとんど依らず 10〜30 程度。
+ *
+ * 外力は force.hpp の ForceField（例えば washboard:v0=0,tilt=F で一様な力 F による沈降、
+ * harmonic で粒子の集団を閉じ込める）。初期配置は原点を中心とした間隔 spacing の正方格子。
+ */
+
+#ifndef ITPHYS_HYDRODYNAMICS_HPP
+#define ITPHYS_HYDRODYNAMICS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "itphys/force.hpp"
+#include "itphys/langevin.hpp"
+#include "itphys/rng.hpp"
+
+namespace itphys {
+
+/** Rotne-Prager-Yamakawa の移動度テンソルの積（行列は作らない） */
+class RpyMobility {
+public:
+    /** @param mu0 1粒子の移動度 1/γ  @param radius 流体力学的な半径 a */
+    RpyMobility(double mu0, double radius) : mu0_(mu0), a_(radius) {}
+
+    /**
+     * (ux, uy) = M (fx, fy)（粒子の位置は x, y、各 n 個）
+     */
+    void apply(const double* x, const double* y, std::size_t n, const double* fx, const double* fy,
+               double* ux, double* uy, int n_threads) const;
+
+    /**
+     * (dx, dy) = ∇·M（粒子 i の成分は Σ_j ∂_{r_j}·M_ij = μ0 Σ_j c2(r_ij) (r_i - r_j)、平面内の xy 成分だけを
+     * 使うので 0 にならない）
+     */
+    void divergence(const double* x, const double* y, std::size_t n, double* dx, double* dy, int n_threads) const;
+
+    /** 粒子 i と j（i ≠ j）の 2×2 ブロック (xx, xy, yy) */
+    void pair_block(double dx, double dy, double& mxx, double& mxy, double& myy) const;
+
+    double mu0() const { return mu0_; }
+    double radius() const { return a_; }
+
+private:
+    double mu0_;
+    double a_;
+};
+
+/**
+ * 対称正定値行列 A の積 apply(v, Av)（長さ dim）だけから A^{1/2} z をランチョス法で近似する
+ *
+ * Krylov 基底は毎回全ての前の基底に対して直交化し直す。
+ *
+ * @param out       長さ dim の結果
+ * @param tolerance 隣り合う反復での近似の差（相対）がこれ以下になれば止める
+ * @return 使った反復回数（A の積の回数）
+ */
+int krylov_sqrt(const std::function<void(const double*, double*)>& apply, const double* z, double* out,
+                std::size_t dim, double tolerance, int max_iter);
+
+struct HydroOptions {
+    std::size_t n_particles = 1024;
+    double radius = 0.5;       // 流体力学的な半径 a
+    double spacing = 2.0;      // 初期配置の格子の間隔
+    double tolerance = 1e-4;   // ランチョス法の相対誤差
+    int max_krylov = 64;       // ランチョス法の最大反復回数
+    ForceField force;          // 外力
+    std::uint64_t seed = 1;
+    int n_threads = 0;         // 0 なら OpenMP の既定（OMP_NUM_THREADS）
+};
+
+class HydroBrownian {
+public:
+    /**
+     * p.T, p.kB, p.gamma, p.dt を使う（過減衰なので p.m は使わない）
+     *
+     * @throw std::invalid_argument 粒子がない、radius や spacing が正でないとき
+     */
+    HydroBrownian(const LangevinParams& p, const HydroOptions& opt);
+
+    /** n ステップ進める */
+    void step(long long n = 1);
+
+    std::size_t size() const { return x_.size(); }
+    double time() const { return t_; }
+    const std::vector<double>& x() const { return x_; }
+    const std::vector<double>& y() const { return y_; }
+    const RpyMobility& mobility() const { return mobility_; }
+
+    /** 1粒子あたりの平均二乗変位 ⟨|r - r(0)|²⟩ */
+    double msd() const;
+    /** 重心の位置 */
+    double center_x() const;
+    double center_y() const;
+    /** これまでのステップのランチョス法の反復回数の平均と最大 */
+    double mean_krylov() const { return steps_ > 0 ? double(krylov_total_) / steps_ : 0.0; }
+    int max_krylov() const { return krylov_max_; }
+
+private:
+    LangevinParams p_;
+    HydroOptions opt_;
+    RpyMobility mobility_;
+    int n_threads_;
+    NormalRng rng_;
+    double t_ = 0.0;
+    long long steps_ = 0;
+    long long krylov_total_ = 0;
+    int krylov_max_ = 0;
+
+    std::vector<double> x_, y_, x0_, y0_;
+    // 力・速度・乱数・M^{1/2} z・∇·M（どれも [x 成分 N 個, y 成分 N 個]）
+    std::vector<double> f_, u_, z_, g_, div_;
+};
+
+}  // namespace itphys
+
+#endif  // ITPHYS_HYDRODYNAMICS_HPP
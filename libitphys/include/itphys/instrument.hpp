@@ -0,0 +1,111 @@
+/*
+ * itphys/instrument.hpp
+ *
+ * ホットパスの計測（フェーズごとの時間、処理量のカウンタ、ハードウェアカウンタ）
+ *
+ * CMake の ITPHYS_INSTRUMENT=ON でビルドしたときだけ有効になる。無効のときマクロは
+ * ((void)0) に展開されるので、ホットパスには何も残らない。
+ *
+ *   {
+ *       ITPHYS_PHASE(kRng);          // このスコープの時間を rng に加える
+ *       eta = rng();
+ *   }
+ *   ITPHYS_COUNT(kSteps, 1);        // カウンタに加える
+ *
+ * 時間はスレッドごとに TSC（x86 以外は steady_clock）で測り、終了時に全スレッド分を合計して
+ * 標準エラー出力に表と1行の JSON（"# itphys-json {...}"）を出す。環境変数
+ * ITPHYS_INSTRUMENT_JSON=path を指定すると JSON をそのファイルにも書く。
+ * Linux では perf_event_open でプロセス全体の cycles, instructions, cache-misses,
+ * branch-misses も数える（権限がなければ "unavailable" と表示する）。
+ */
+
+#ifndef ITPHYS_INSTRUMENT_HPP
+#define ITPHYS_INSTRUMENT_HPP
+
+#include <cstdint>
+#include <cstdio>
+
+#ifdef ITPHYS_INSTRUMENT
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace itphys {
+namespace instrument {
+
+enum Phase { kRng, kStep, kObserve, kOutput, kNumPhases };
+enum Counter { kSteps, kSamples, kBytes, kNumCounters };
+
+#ifdef ITPHYS_INSTRUMENT
+
+/** フェーズごとの時間（tick）・呼び出し回数とカウンタ */
+struct Tally {
+    std::uint64_t ticks[kNumPhases] = {};
+    std::uint64_t calls[kNumPhases] = {};
+    std::uint64_t counters[kNumCounters] = {};
+};
+
+/** スレッドごとの集計（スレッドの終了時に全体の集計へ足し込まれる） */
+struct ThreadSlot : Tally {
+    ThreadSlot();
+    ~ThreadSlot();
+};
+
+inline ThreadSlot& slot() {
+    thread_local ThreadSlot s;
+    return s;
+}
+
+inline std::uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/** スコープの実行時間をフェーズに加える */
+class ScopedPhase {
+public:
+    explicit ScopedPhase(Phase p) : p_(p), t0_(ticks()) {}
+    ~ScopedPhase() {
+        ThreadSlot& s = slot();
+        s.ticks[p_] += ticks() - t0_;
+        s.calls[p_]++;
+    }
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    Phase p_;
+    std::uint64_t t0_;
+};
+
+inline void count(Counter c, std::uint64_t n) { slot().counters[c] += n; }
+
+/** ここまでの集計を fp に出力する（終了時にも自動で呼ばれる） */
+void report(std::FILE* fp);
+
+#define ITPHYS_INSTRUMENT_CAT2(a, b) a##b
+#define ITPHYS_INSTRUMENT_CAT(a, b) ITPHYS_INSTRUMENT_CAT2(a, b)
+#define ITPHYS_PHASE(p) \
+    ::itphys::instrument::ScopedPhase ITPHYS_INSTRUMENT_CAT(itphys_phase_, __LINE__)(::itphys::instrument::p)
+#define ITPHYS_COUNT(c, n) ::itphys::instrument::count(::itphys::instrument::c, (n))
+
+#else
+
+inline void report(std::FILE*) {}
+
+#define ITPHYS_PHASE(p) ((void)0)
+#define ITPHYS_COUNT(c, n) ((void)0)
+
+#endif  // ITPHYS_INSTRUMENT
+
+}  // namespace instrument
+}  // namespace itphys
+
+#endif  // ITPHYS_INSTRUMENT_HPP
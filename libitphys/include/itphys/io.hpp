@@ -0,0 +1,164 @@
+/*
+ * itphys/io.hpp
+ *
+ * シミュレーション結果の出力先（sink）
+ *
+ * どの sink も write(const ParticleState&) を持ち、run_brownian_motion() にそのまま渡せる。
+ * - TextSink:   "# t x y vx vy" のヘッダー付きテキスト（元のプログラムと同じ形式）
+ * - BinarySink: 16バイトのヘッダーの後に double × 5 のレコードを並べたバイナリ
+ *               （Python では np.fromfile(path, dtype='<f8', offset=16).reshape(-1, 5)）
+ * - MmapSink:   BinarySink と同じ形式を mmap したファイルに直接書く（POSIX）
+ * - NullSink:   何も出力しない（ベンチマーク・統計のみの実行用）
+ * - Tee:        2つの sink に同じ状態を渡す
+ */
+
+#ifndef ITPHYS_IO_HPP
+#define ITPHYS_IO_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "itphys/instrument.hpp"
+#include "itphys/langevin.hpp"
+
+namespace itphys {
+
+/** バイナリ形式のヘッダー: マジック "ITPHYSB1" + フィールド数 (uint32) + 予約 (uint32) */
+constexpr char kBinaryMagic[8] = {'I', 'T', 'P', 'H', 'Y', 'S', 'B', '1'};
+constexpr std::size_t kBinaryHeaderSize = 16;
+constexpr std::uint32_t kStateFields = 5;
+
+/** テキスト出力。precision 桁の指数表記（fixed = true なら小数点表記） */
+class TextSink {
+public:
+    explicit TextSink(std::FILE* fp, int precision = 15, bool fixed = false);
+    ~TextSink();
+
+    TextSink(const TextSink&) = delete;
+    TextSink& operator=(const TextSink&) = delete;
+
+    /** ヘッダー行 "# t x y vx vy" を出力する */
+    void header();
+    void write(const ParticleState& s);
+    void flush();
+
+    std::uint64_t bytes_written() const { return bytes_; }
+
+private:
+    std::FILE* fp_;
+    std::vector<char> buf_;
+    char fmt_[64];
+    std::uint64_t bytes_ = 0;
+};
+
+/** バイナリ出力（リトルエンディアンの double をそのまま書く） */
+class BinarySink {
+public:
+    explicit BinarySink(std::FILE* fp);
+    ~BinarySink();
+
+    BinarySink(const BinarySink&) = delete;
+    BinarySink& operator=(const BinarySink&) = delete;
+
+    /** ファイル先頭の16バイトのヘッダーを出力する */
+    void header();
+    void write(const ParticleState& s) {
+        ITPHYS_PHASE(kOutput);
+        ITPHYS_COUNT(kBytes, kStateFields * sizeof(double));
+        if (n_ + kStateFields > buf_.size()) flush();
+        double* p = buf_.data() + n_;
+        p[0] = s.t;
+        p[1] = s.x;
+        p[2] = s.y;
+        p[3] = s.vx;
+        p[4] = s.vy;
+        n_ += kStateFields;
+    }
+    void flush();
+
+    std::uint64_t bytes_written() const { return bytes_; }
+
+private:
+    std::FILE* fp_;
+    std::vector<double> buf_;
+    std::size_t n_ = 0;
+    std::uint64_t bytes_ = 0;
+};
+
+/**
+ * BinarySink と同じ形式のファイルを mmap して直接書く（stdio のバッファを経由しない）
+ * ファイルは足りなくなるたびに倍の大きさに伸ばし、デストラクタで実際の長さに切り詰める。
+ * ファイルを開けない・伸ばせないときは std::system_error を投げる（コンストラクタで最初の領域を
+ * 確保できなかったときは、作ったファイルを消してから投げる）
+ */
+class MmapSink {
+public:
+    explicit MmapSink(const std::string& path, std::size_t initial_capacity = 1 << 24);
+    ~MmapSink();
+
+    MmapSink(const MmapSink&) = delete;
+    MmapSink& operator=(const MmapSink&) = delete;
+
+    void header();
+    void write(const ParticleState& s) {
+        constexpr std::size_t kRecord = kStateFields * sizeof(double);
+        ITPHYS_PHASE(kOutput);
+        ITPHYS_COUNT(kBytes, kRecord);
+        if (pos_ + kRecord > cap_) grow(pos_ + kRecord);
+        const double rec[kStateFields] = {s.t, s.x, s.y, s.vx, s.vy};
+        std::memcpy(base_ + pos_, rec, kRecord);
+        pos_ += kRecord;
+    }
+    /**
+     * n レコード分の領域を確保し、その先頭を返す（呼び出し側が t, x, y, vx, vy を直接書く）
+     * 次の write() や reserve() でファイルを伸ばすとポインタは無効になる
+     */
+    double* reserve(std::size_t n);
+    /** 書いた内容をファイルに反映する（msync） */
+    void flush();
+
+    std::uint64_t bytes_written() const { return pos_; }
+
+private:
+    void grow(std::size_t need);
+
+    int fd_ = -1;
+    char* base_ = nullptr;
+    std::size_t cap_ = 0;
+    std::size_t pos_ = 0;
+};
+
+/** 何も出力しない sink */
+struct NullSink {
+    void header() {}
+    void write(const ParticleState&) {}
+    void flush() {}
+};
+
+/** 2つの sink（または集計器）に同じ状態を渡す */
+template <class A, class B>
+class Tee {
+public:
+    Tee(A& a, B& b) : a_(a), b_(b) {}
+    void write(const ParticleState& s) {
+        a_.write(s);
+        b_.write(s);
+    }
+
+private:
+    A& a_;
+    B& b_;
+};
+
+/**
+ * BinarySink で書いたファイルを読み込む
+ * @return 成功したら true。out には t, x, y, vx, vy の順に全レコードが入る
+ */
+bool read_binary(const std::string& path, std::vector<double>& out);
+
+}  // namespace itphys
+
+#endif  // ITPHYS_IO_HPP
@@ -0,0 +1,559 @@
+/*
+ * itphys/langevin.hpp
+ *
+ * ランジュバン方程式の積分器と2次元ブラウン運動のシミュレーション
+ *
+ * 物理モデル:
+ * - 速度の時間発展: dv/dt = -(γ/m)v + sqrt(2γkBT/m) * η(t)
+ * - 位置の時間発展: dr/dt = v
+ *
+ * 離散化は元の brownian_motion.c と同じオイラー法（速度を先に更新し、新しい速度で位置を進める）:
+ *   v_{n+1} = v_n - (γ/m) v_n Δt + sqrt(2γkBT/m) sqrt(Δt) η_n
+ *   r_{n+1} = r_n + v_{n+1} Δt
+ * ほかに BAOAB 分割（BaoabIntegrator）と厳密解（ExactOuIntegrator）がある。
+ * どの積分器も step_block(x, y, vx, vy, eta, b) と kNoisePerDim（1成分・1ステップの乱数の個数）を持つ
+ *
+ * 1〜3次元は ParticleBlock<Dim>（成分ごとの配列）を取る step_block<Dim>(s, eta, b, force) で計算する。
+ * 次元・積分器・外力はどれもテンプレート引数なので、組み合わせごとに分岐のないループが
+ * インスタンス化される（2次元の step_block はこれを呼ぶだけで、計算の順番も結果も同じ）。
+ * 外力は force.hpp の平面の力で、1次元では y = 0 の x 成分だけを使い、3次元の z には掛からない
+ *
+ * ParticleBlock<Dim, float> は単精度の混合精度モード: 速度と乱数は float で、位置は float の r と
+ * 補償項 r_lo の和（カハンの加算）で持つ。力のない成分は全て float で計算する（SIMD の幅が倍）。
+ * 力のある成分は位置を r + r_lo から double で読んで double で進め、r と r_lo に分けて書き戻す
+ *
+ * 外力 F(r) = -∇U（force.hpp）があるときは、オイラー法は v_{n+1} に (F(r_n)/m) Δt を足し、
+ * BAOAB は速度の半ステップの更新 B（v += (F/m) Δt/2）を前後に置く。力は step_block の粒子の
+ * ループの中で計算する（ExactOuIntegrator は力のない場合だけ）
+ */
+
+#ifndef ITPHYS_LANGEVIN_HPP
+#define ITPHYS_LANGEVIN_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "itphys/force.hpp"
+#include "itphys/instrument.hpp"
+#include "itphys/rng.hpp"
+
+namespace itphys {
+
+/** 物理パラメータと時間刻み（デフォルトは元のプログラムと同じ） */
+struct LangevinParams {
+    double T = 1.0;      // 温度
+    double m = 1.0;      // 粒子の質量
+    double gamma = 1.0;  // 摩擦係数
+    double kB = 1.0;     // ボルツマン定数
+    double dt = 0.01;    // 時間刻み
+    long long n_steps = 1000;  // 時間ステップ数
+};
+
+/** 1粒子の状態（時刻、位置、速度） */
+struct ParticleState {
+    double t = 0.0;
+    double x = 0.0;
+    double y = 0.0;
+    double vx = 0.0;
+    double vy = 0.0;
+};
+
+/**
+ * 多数の粒子をまとめて扱うための SoA（Structure of Arrays）
+ * 成分ごとに連続した配列なので、ステップのループがSIMD化される
+ */
+struct Ensemble {
+    explicit Ensemble(std::size_t n = 0) : x(n, 0.0), y(n, 0.0), vx(n, 0.0), vy(n, 0.0) {}
+
+    std::size_t size() const { return x.size(); }
+
+    double t = 0.0;
+    std::vector<double> x, y, vx, vy;
+};
+
+/**
+ * Dim 次元（1〜3）の b 粒子のブロック: r[d], v[d] が成分 d の位置と速度の配列
+ * 乱数は成分 d に eta[d b .. (d+1) b) を使う（2次元では x, y の順で、step_block(x, y, ...) と同じ並び）
+ * Real = float のときは位置が r[d] + r_lo[d]（double では r_lo は使わない）
+ */
+template <int Dim, class Real = double>
+struct ParticleBlock {
+    static_assert(Dim >= 1 && Dim <= 3, "ParticleBlock: Dim must be 1, 2 or 3");
+    static_assert(std::is_same<Real, double>::value || std::is_same<Real, float>::value,
+                  "ParticleBlock: Real must be double or float");
+    Real* r[Dim];
+    Real* v[Dim];
+    Real* r_lo[Dim] = {};
+};
+
+/** 粒子 i の成分 d の位置（float のときは補償項を足して double にする） */
+template <int Dim, class Real>
+inline double load_position(const ParticleBlock<Dim, Real>& s, int d, std::size_t i) {
+    if constexpr (std::is_same<Real, float>::value) {
+        return static_cast<double>(s.r[d][i]) + static_cast<double>(s.r_lo[d][i]);
+    } else {
+        return s.r[d][i];
+    }
+}
+
+/** 粒子 i の成分 d の位置を r にする（float のときは r の丸め誤差を補償項に入れる） */
+template <int Dim, class Real>
+inline void store_position(const ParticleBlock<Dim, Real>& s, int d, std::size_t i, double r) {
+    if constexpr (std::is_same<Real, float>::value) {
+        const float hi = static_cast<float>(r);
+        s.r[d][i] = hi;
+        s.r_lo[d][i] = static_cast<float>(r - hi);
+    } else {
+        s.r[d][i] = r;
+    }
+}
+
+/**
+ * r[i] += dr（float のときはカハンの加算で、足したときの丸め誤差を lo[i] にためて次に足す。
+ * lo は load_position / store_position と同じく位置が r + lo になる向きに持つ。
+ * 長い時間で小さな Δr を大きな r に足し続けても r + lo は double と同程度に正確）
+ */
+template <class Real>
+inline void add_position(Real* r, Real* lo, std::size_t i, Real dr) {
+    if constexpr (std::is_same<Real, float>::value) {
+        const float y = dr + lo[i];
+        const float t = r[i] + y;
+        lo[i] = y - (t - r[i]);
+        r[i] = t;
+    } else {
+        r[i] += dr;
+    }
+}
+
+/** 外力が掛かる成分の数（力がなければ 0、平面の力なので3次元でも x, y の 2） */
+template <int Dim, class Force>
+constexpr int forced_dims() {
+    return std::is_same<Force, NoForce>::value ? 0 : (Dim < 2 ? Dim : 2);
+}
+
+/** 位置 r（K = 1 なら x だけ、K = 2 なら x, y）での力を f に足す */
+template <int K, class Force>
+inline void apply_force(const Force& force, const double (&r)[K], double (&f)[K]) {
+    if constexpr (K == 1) {
+        double fy = 0.0;
+        force(r[0], 0.0, f[0], fy);
+    } else {
+        force(r[0], r[1], f[0], f[1]);
+    }
+}
+
+/**
+ * オイラー法の積分器
+ * 係数 (γ/m)Δt と sqrt(2γkBT/m)sqrt(Δt) はコンストラクタで一度だけ計算する
+ */
+class EulerIntegrator {
+public:
+    explicit EulerIntegrator(const LangevinParams& p)
+        : dt_(p.dt),
+          damp_(p.gamma / p.m * p.dt),
+          kick_(p.dt / p.m),
+          noise_(std::sqrt(2.0 * p.gamma * p.kB * p.T / p.m) * std::sqrt(p.dt)) {}
+
+    /** 1成分 (r, v) を1ステップ進める（eta は N(0,1) の乱数） */
+    void step(double& r, double& v, double eta) const {
+        v = v - damp_ * v + noise_ * eta;
+        r += v * dt_;
+    }
+
+    /** 1粒子を1ステップ進める */
+    void step(ParticleState& s, double eta_x, double eta_y) const {
+        step(s.x, s.vx, eta_x);
+        step(s.y, s.vy, eta_y);
+        s.t += dt_;
+    }
+
+    /** 力 force（force.hpp の関数オブジェクト）の下で1粒子を1ステップ進める */
+    template <class Force>
+    void step(ParticleState& s, double eta_x, double eta_y, const Force& force) const {
+        if constexpr (std::is_same<Force, NoForce>::value) {
+            step(s, eta_x, eta_y);
+        } else {
+            double fx = 0.0, fy = 0.0;
+            force(s.x, s.y, fx, fy);
+            s.vx = s.vx - damp_ * s.vx + kick_ * fx + noise_ * eta_x;
+            s.vy = s.vy - damp_ * s.vy + kick_ * fy + noise_ * eta_y;
+            s.x += s.vx * dt_;
+            s.y += s.vy * dt_;
+            s.t += dt_;
+        }
+    }
+
+    /** 全粒子を1ステップ進める（eta_x, eta_y は粒子数分の正規乱数） */
+    void step(Ensemble& e, const double* eta_x, const double* eta_y) const {
+        const std::size_t n = e.size();
+        double* x = e.x.data();
+        double* y = e.y.data();
+        double* vx = e.vx.data();
+        double* vy = e.vy.data();
+        for (std::size_t i = 0; i < n; i++) {
+            step(x[i], vx[i], eta_x[i]);
+            step(y[i], vy[i], eta_y[i]);
+        }
+        e.t += dt_;
+    }
+
+    /**
+     * 全粒子を1ステップ進める（正規乱数は kNoiseBlock 粒子分ずつ生成するので、
+     * 粒子数に比例する作業領域を必要としない）
+     */
+    void step(Ensemble& e, NormalRng& rng) const {
+        double eta[2 * kNoiseBlock];
+        const std::size_t n = e.size();
+        for (std::size_t i0 = 0; i0 < n; i0 += kNoiseBlock) {
+            const std::size_t b = n - i0 < kNoiseBlock ? n - i0 : kNoiseBlock;
+            rng.fill(eta, 2 * b);
+            step_block(e.x.data() + i0, e.y.data() + i0, e.vx.data() + i0, e.vy.data() + i0, eta, b);
+        }
+        e.t += dt_;
+    }
+
+    /** b 粒子を1ステップ進める（eta[0..b) が x 方向、eta[b..2b) が y 方向の正規乱数） */
+    void step_block(double* x, double* y, double* vx, double* vy, const double* eta,
+                    std::size_t b) const {
+        step_block(ParticleBlock<2>{{x, y}, {vx, vy}}, eta, b);
+    }
+
+    /** 力 force の下で b 粒子を1ステップ進める（力は各粒子の位置を読んだその場で計算する） */
+    template <class Force>
+    void step_block(double* x, double* y, double* vx, double* vy, const double* eta, std::size_t b,
+                    const Force& force) const {
+        step_block(ParticleBlock<2>{{x, y}, {vx, vy}}, eta, b, force);
+    }
+
+    /**
+     * Dim 次元の b 粒子を力 force の下で1ステップ進める（Real は double か float）
+     * 力の掛かる成分は粒子ごとにまとめて、残りの成分（力がなければ全て）は成分ごとのループで進める
+     */
+    template <int Dim, class Real, class Force = NoForce>
+    void step_block(const ParticleBlock<Dim, Real>& s, const Real* eta, std::size_t b,
+                    const Force& force = Force()) const {
+        constexpr int kForced = forced_dims<Dim, Force>();
+        if constexpr (kForced > 0) {
+            for (std::size_t i = 0; i < b; i++) {
+                double r[kForced], f[kForced] = {};
+                for (int d = 0; d < kForced; d++) r[d] = load_position(s, d, i);
+                apply_force(force, r, f);
+                for (int d = 0; d < kForced; d++) {
+                    double v = s.v[d][i];
+                    v = v - damp_ * v + kick_ * f[d] + noise_ * eta[d * b + i];
+                    s.v[d][i] = static_cast<Real>(v);
+                    store_position(s, d, i, r[d] + v * dt_);
+                }
+            }
+        }
+        const Real damp = static_cast<Real>(damp_);
+        const Real noise = static_cast<Real>(noise_);
+        const Real dt = static_cast<Real>(dt_);
+        for (int d = kForced; d < Dim; d++) {
+            Real* r = s.r[d];
+            Real* lo = s.r_lo[d];
+            Real* v = s.v[d];
+            const Real* e = eta + d * b;
+            for (std::size_t i = 0; i < b; i++) {
+                v[i] = v[i] - damp * v[i] + noise * e[i];
+                add_position(r, lo, i, v[i] * dt);
+            }
+        }
+    }
+
+    /**
+     * 粒子ごとに計算済みの力 fx, fy の下で b 粒子を1ステップ進める（粒子間力、推進力など）
+     * 成分ごとのループにしてあるのでSIMD化される
+     */
+    void step_block(double* x, double* y, double* vx, double* vy, const double* fx, const double* fy,
+                    const double* eta, std::size_t b) const {
+        double* const r[2] = {x, y};
+        double* const v[2] = {vx, vy};
+        const double* const f[2] = {fx, fy};
+        for (int d = 0; d < 2; d++) {
+            double* rd = r[d];
+            double* vd = v[d];
+            const double* fd = f[d];
+            const double* e = eta + d * b;
+            for (std::size_t i = 0; i < b; i++) {
+                vd[i] = vd[i] - damp_ * vd[i] + kick_ * fd[i] + noise_ * e[i];
+                rd[i] += vd[i] * dt_;
+            }
+        }
+    }
+
+    static constexpr std::size_t kNoiseBlock = 1024;
+    /** 1成分・1ステップあたりの正規乱数の個数 */
+    static constexpr int kNoisePerDim = 1;
+
+    double dt() const { return dt_; }
+
+private:
+    double dt_;
+    double damp_;
+    double kick_;  // Δt/m
+    double noise_;
+};
+
+/**
+ * BAOAB 分割の積分器（外力がなければ A-O-A）
+ *   v += (F/m) Δt/2,  r += v Δt/2,  v = c v + sqrt((1 - c²) kBT/m) η,  r += v Δt/2,  v += (F/m) Δt/2
+ *   （c = e^{-γΔt/m}）
+ * 速度の更新（O）が厳密なので、外力がなければ Δt によらず ⟨v²⟩ が平衡値 2kBT/m に一致する。
+ * 外力があるときは、力を1ステップに2回（始めと終わりの位置で）計算する
+ */
+class BaoabIntegrator {
+public:
+    explicit BaoabIntegrator(const LangevinParams& p)
+        : dt_(p.dt),
+          half_(0.5 * p.dt),
+          half_kick_(0.5 * p.dt / p.m),
+          c_(std::exp(-p.gamma / p.m * p.dt)),
+          noise_(std::sqrt(-std::expm1(-2.0 * p.gamma / p.m * p.dt) * p.kB * p.T / p.m)) {}
+
+    void step(double& r, double& v, double eta) const {
+        r += v * half_;
+        v = c_ * v + noise_ * eta;
+        r += v * half_;
+    }
+
+    /** b 粒子を1ステップ進める（乱数の並びは EulerIntegrator::step_block と同じ） */
+    void step_block(double* x, double* y, double* vx, double* vy, const double* eta,
+                    std::size_t b) const {
+        step_block(ParticleBlock<2>{{x, y}, {vx, vy}}, eta, b);
+    }
+
+    /** 力 force の下で b 粒子を1ステップ進める（B-A-O-A-B） */
+    template <class Force>
+    void step_block(double* x, double* y, double* vx, double* vy, const double* eta, std::size_t b,
+                    const Force& force) const {
+        step_block(ParticleBlock<2>{{x, y}, {vx, vy}}, eta, b, force);
+    }
+
+    /** Dim 次元の b 粒子を力 force の下で1ステップ進める（成分の分け方は EulerIntegrator と同じ） */
+    template <int Dim, class Real, class Force = NoForce>
+    void step_block(const ParticleBlock<Dim, Real>& s, const Real* eta, std::size_t b,
+                    const Force& force = Force()) const {
+        constexpr int kForced = forced_dims<Dim, Force>();
+        if constexpr (kForced > 0) {
+            for (std::size_t i = 0; i < b; i++) {
+                double r[kForced], u[kForced], f[kForced] = {};
+                for (int d = 0; d < kForced; d++) r[d] = load_position(s, d, i);
+                apply_force(force, r, f);
+                for (int d = 0; d < kForced; d++) {
+                    u[d] = s.v[d][i] + half_kick_ * f[d];
+                    r[d] += u[d] * half_;
+                    u[d] = c_ * u[d] + noise_ * eta[d * b + i];
+                    r[d] += u[d] * half_;
+                    f[d] = 0.0;
+                }
+                apply_force(force, r, f);
+                for (int d = 0; d < kForced; d++) {
+                    store_position(s, d, i, r[d]);
+                    s.v[d][i] = static_cast<Real>(u[d] + half_kick_ * f[d]);
+                }
+            }
+        }
+        const Real half = static_cast<Real>(half_);
+        const Real c = static_cast<Real>(c_);
+        const Real noise = static_cast<Real>(noise_);
+        for (int d = kForced; d < Dim; d++) {
+            Real* r = s.r[d];
+            Real* lo = s.r_lo[d];
+            Real* v = s.v[d];
+            const Real* e = eta + d * b;
+            for (std::size_t i = 0; i < b; i++) {
+                add_position(r, lo, i, v[i] * half);
+                v[i] = c * v[i] + noise * e[i];
+                add_position(r, lo, i, v[i] * half);
+            }
+        }
+    }
+
+    static constexpr int kNoisePerDim = 1;
+
+    double dt() const { return dt_; }
+
+private:
+    double dt_;
+    double half_;
+    double half_kick_;  // Δt/(2m)
+    double c_;
+    double noise_;
+};
+
+/**
+ * 自由粒子の厳密解（オルンシュタイン・ウーレンベック過程）による積分器
+ * (r, v) の Δt 後の条件付き分布は2変量正規分布なので、2つの正規乱数から厳密にサンプルする:
+ *   v' = v e^{-aΔt} + ξ_v,   r' = r + v (1 - e^{-aΔt})/a + ξ_r      （a = γ/m, σ² = kBT/m）
+ *   Var ξ_v = σ² (1 - e^{-2aΔt}),  Cov(ξ_r, ξ_v) = (σ²/a)(1 - e^{-aΔt})²
+ *   Var ξ_r = (σ²/a²)(2aΔt - 3 + 4e^{-aΔt} - e^{-2aΔt})
+ * 時間刻みによる誤差はない（統計誤差だけが残る）
+ */
+class ExactOuIntegrator {
+public:
+    explicit ExactOuIntegrator(const LangevinParams& p) : dt_(p.dt) {
+        const double a = p.gamma / p.m;
+        const double x = a * p.dt;
+        const double s2 = p.kB * p.T / p.m;
+        const double em1 = std::expm1(-x);  // e^{-x} - 1
+        decay_ = 1.0 + em1;
+        drift_ = -em1 / a;
+        const double var_v = -s2 * std::expm1(-2.0 * x);
+        const double cov = s2 / a * em1 * em1;
+        // 2x - 3 + 4e^{-x} - e^{-2x} は x が小さいと桁落ちするので級数 Σ_{k>=3} (-1)^k (4 - 2^k) x^k / k! を使う
+        double g;
+        if (x < 0.1) {
+            g = 0.0;
+            double term = x * x / 2.0;  // x^k / k! （k = 2）
+            double pow2 = 4.0;          // 2^k
+            for (int k = 3; k <= 14; k++) {
+                term *= x / k;
+                pow2 *= 2.0;
+                g += (k % 2 ? -1.0 : 1.0) * (4.0 - pow2) * term;
+            }
+        } else {
+            g = 2.0 * x + 2.0 * em1 - em1 * em1;
+        }
+        const double var_r = s2 / (a * a) * g;
+        noise_v_ = std::sqrt(var_v);
+        noise_rv_ = cov / noise_v_;
+        noise_r_ = std::sqrt(std::max(0.0, var_r - noise_rv_ * noise_rv_));
+    }
+
+    /** eta1 は速度と位置に共通の乱数、eta2 は位置だけの乱数 */
+    void step(double& r, double& v, double eta1, double eta2) const {
+        r += drift_ * v + noise_rv_ * eta1 + noise_r_ * eta2;
+        v = decay_ * v + noise_v_ * eta1;
+    }
+
+    /** b 粒子を1ステップ進める（eta は [x の eta1, y の eta1, x の eta2, y の eta2] の順に b 個ずつ） */
+    void step_block(double* x, double* y, double* vx, double* vy, const double* eta,
+                    std::size_t b) const {
+        step_block(ParticleBlock<2>{{x, y}, {vx, vy}}, eta, b);
+    }
+
+    /** Dim 次元の b 粒子を1ステップ進める（eta は成分ごとの eta1 を Dim 個、続けて eta2 を Dim 個） */
+    template <int Dim, class Real>
+    void step_block(const ParticleBlock<Dim, Real>& s, const Real* eta, std::size_t b) const {
+        const Real decay = static_cast<Real>(decay_);
+        const Real drift = static_cast<Real>(drift_);
+        const Real noise_v = static_cast<Real>(noise_v_);
+        const Real noise_rv = static_cast<Real>(noise_rv_);
+        const Real noise_r = static_cast<Real>(noise_r_);
+        for (int d = 0; d < Dim; d++) {
+            Real* r = s.r[d];
+            Real* lo = s.r_lo[d];
+            Real* v = s.v[d];
+            const Real* e1 = eta + d * b;
+            const Real* e2 = eta + (Dim + d) * b;
+            for (std::size_t i = 0; i < b; i++) {
+                add_position(r, lo, i, drift * v[i] + noise_rv * e1[i] + noise_r * e2[i]);
+                v[i] = decay * v[i] + noise_v * e1[i];
+            }
+        }
+    }
+
+    static constexpr int kNoisePerDim = 2;
+
+    double dt() const { return dt_; }
+
+private:
+    double dt_;
+    double decay_;
+    double drift_;
+    double noise_v_;
+    double noise_rv_;
+    double noise_r_;
+};
+
+/** 積分器の種類（run_ensemble などで実行時に選ぶ） */
+enum class Integrator { kEuler, kBaoab, kExactOu };
+
+inline const char* integrator_name(Integrator k) {
+    switch (k) {
+        case Integrator::kBaoab: return "baoab";
+        case Integrator::kExactOu: return "exact_ou";
+        default: return "euler";
+    }
+}
+
+/** "euler" / "baoab" / "exact_ou" を読む。知らない名前なら false */
+inline bool parse_integrator(const std::string& name, Integrator& out) {
+    for (Integrator k : {Integrator::kEuler, Integrator::kBaoab, Integrator::kExactOu}) {
+        if (name == integrator_name(k)) {
+            out = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 状態 s から n ステップ進め、各ステップ後の状態を sink.write() に渡す
+ * （s 自体は渡さない。チェックポイントから続きを計算するとき用）
+ *
+ * @param force 外力（force.hpp の関数オブジェクト。省略すると力なし）
+ */
+template <class Sink, class Force = NoForce>
+void advance_brownian_motion(const LangevinParams& p, NormalRng& rng, Sink& sink, ParticleState& s,
+                             long long n, const Force& force = Force()) {
+    const EulerIntegrator integ(p);
+    for (long long k = 0; k < n; k++) {
+        double eta_x, eta_y;
+        {
+            ITPHYS_PHASE(kRng);
+            eta_x = rng();
+            eta_y = rng();
+        }
+        {
+            ITPHYS_PHASE(kStep);
+            integ.step(s, eta_x, eta_y, force);
+        }
+        ITPHYS_COUNT(kSteps, 1);
+        ITPHYS_COUNT(kSamples, 2);
+        sink.write(s);  // 時間は各 sink の中で output / observe として数える
+    }
+}
+
+/** 実行時に選んだ外力 ff の下で advance_brownian_motion する */
+template <class Sink>
+void advance_brownian_motion(const LangevinParams& p, NormalRng& rng, Sink& sink, ParticleState& s,
+                             long long n, const ForceField& ff) {
+    visit_force(ff, [&](const auto& force) { advance_brownian_motion(p, rng, sink, s, n, force); });
+}
+
+/**
+ * 2次元ブラウン運動をシミュレートし、初期状態と各ステップ後の状態を sink.write() に渡す
+ *
+ * Sink は write(const ParticleState&) を持つ型（io.hpp の出力先や observables.hpp の集計器）。
+ * 初期条件は位置(0,0)、速度(0,0)（init で変更できる）
+ *
+ * @return 最終状態
+ */
+template <class Sink>
+ParticleState run_brownian_motion(const LangevinParams& p, NormalRng& rng, Sink& sink,
+                                  ParticleState init = ParticleState()) {
+    ParticleState s = init;
+    sink.write(s);
+    advance_brownian_motion(p, rng, sink, s, p.n_steps);
+    return s;
+}
+
+/** 外力 ff（force.hpp）の下で run_brownian_motion する */
+template <class Sink>
+ParticleState run_brownian_motion(const LangevinParams& p, NormalRng& rng, Sink& sink,
+                                  const ForceField& ff, ParticleState init = ParticleState()) {
+    ParticleState s = init;
+    sink.write(s);
+    advance_brownian_motion(p, rng, sink, s, p.n_steps, ff);
+    return s;
+}
+
+}  // namespace itphys
+
+#endif  // ITPHYS_LANGEVIN_HPP
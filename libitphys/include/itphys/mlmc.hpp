@@ -0,0 +1,90 @@
+/*
+ * itphys/mlmc.hpp
+ *
+ * マルチレベル・モンテカルロ法（MLMC、Giles 2008）による ⟨r²(t)⟩, ⟨E_kin(t)⟩, D の推定
+ *
+ * レベル l の時間刻みを Δt_l = Δt_0 / 2^l として
+ *   E[P_L] = E[P_0] + Σ_{l=1..L} E[P_l - P_{l-1}]
+ * の各項を別々の標本数 N_l で推定する。P_l - P_{l-1} は同じブラウン運動で細かい刻み（Δt_l）と
+ * 粗い刻み（Δt_{l-1}）の軌道を計算した差で、粗い軌道の乱数には細かい2ステップ分の乱数の和
+ * (η_1 + η_2)/√2 を使う（同じ ΔW を共有する）。差の分散 V_l は Δt_l² 程度で小さくなるので、
+ * 細かいレベルほど少ない標本で足りる。
+ *
+ * 標本数は N_l = ⌈2ε⁻² √(V_l/C_l) Σ_k √(V_k C_k)⌉（C_l は1標本の費用）で決め、最も細かいレベルの
+ * 補正 |E[P_L - P_{L-1}]| から推定した時間刻みの誤差が ε/√2 を超えればレベルを足す。
+ * 目標の RMS 誤差 ε に対する費用は O(ε⁻²)（同じ精度を最も細かい刻みの普通のモンテカルロで
+ * 得ると O(ε⁻³)）。
+ *
+ * 観測量（時刻 t_end = n_steps Δt_0 で評価）:
+ *   kMsd        r²(t_end)
+ *   kEnergy     E_kin(t_end)
+ *   kDiffusion  (r²(t_end) - r²(t_h)) / (4 (t_end - t_h))、t_h = (n_steps/2) Δt_0（後半の MSD の
+ *               傾き / 4。静止状態から始めたことによる MSD の定数のずれを含まない）
+ * opt.control で選んだ1つの観測量の分散で標本数とレベル数を決め、残りも同じ標本から推定する。
+ *
+ * 乱数はレベル l の k 番目のブロック（kNoiseBlock 粒子）ごとに NormalRng(seed, (l << 40) + k) なので、
+ * 結果はスレッド数に依らない（集計の足し合わせの順番による丸め誤差を除く）。
+ * 積分器は Euler と BAOAB（ExactOu は時間刻みの誤差がないので MLMC は要らない。
+ * 指定すると std::invalid_argument を投げる）。
+ */
+
+#ifndef ITPHYS_MLMC_HPP
+#define ITPHYS_MLMC_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "itphys/langevin.hpp"
+#include "itphys/observables.hpp"
+
+namespace itphys {
+
+enum MlmcObservable { kMlmcMsd, kMlmcEnergy, kMlmcDiffusion, kMlmcObservables };
+
+inline const char* mlmc_observable_name(int k) {
+    static const char* const kNames[] = {"msd", "energy", "diffusion"};
+    return k >= 0 && k < kMlmcObservables ? kNames[k] : "?";
+}
+
+struct MlmcOptions {
+    double target_rmse = 0.01;         // 目標の RMS 誤差 ε（control の観測量の絶対誤差）
+    MlmcObservable control = kMlmcMsd;
+    Integrator integrator = Integrator::kEuler;
+    int min_levels = 3;                // レベル 0..min_levels-1 から始める（時間刻みの誤差の見積もりに2以上）
+    int max_levels = 12;               // min_levels 以上
+    std::uint64_t pilot = 2048;        // 新しいレベルの最初の標本数
+    std::uint64_t seed = 1;
+    int n_threads = 0;                 // 0 なら OpenMP の既定（OMP_NUM_THREADS）
+};
+
+/** 1つのレベルの集計 */
+struct MlmcLevel {
+    double dt = 0.0;
+    long long n_steps = 0;             // 細かい刻みのステップ数
+    std::uint64_t samples = 0;
+    double cost = 0.0;                 // 1標本の費用（粒子・ステップの数。粗い軌道を含む）
+    RunningStats diff[kMlmcObservables];  // P_l - P_{l-1}（l = 0 では P_0）
+    RunningStats fine[kMlmcObservables];  // P_l（普通のモンテカルロの費用の見積もり用）
+};
+
+struct MlmcResult {
+    double mean[kMlmcObservables] = {};
+    double std_error[kMlmcObservables] = {};  // 統計誤差 √(Σ V_l / N_l)
+    double bias = 0.0;                 // control の時間刻みの誤差の推定値
+    double cost = 0.0;                 // 全レベルの費用の合計（粒子・ステップの数）
+    double cost_mc = 0.0;              // 最も細かいレベルで普通のモンテカルロで同じ統計誤差を得る費用
+    bool converged = false;            // max_levels までに bias <= ε/√2 になったか
+    std::vector<MlmcLevel> levels;
+};
+
+/**
+ * p.dt を最も粗い刻み、p.n_steps をそのステップ数として MLMC で推定する
+ *
+ * @throw std::invalid_argument 積分器が ExactOu のとき、p.n_steps < 2 のとき、
+ *        opt.min_levels < 2 または opt.max_levels < opt.min_levels のとき
+ */
+MlmcResult run_mlmc(const LangevinParams& p, const MlmcOptions& opt);
+
+}  // namespace itphys
+
+#endif  // ITPHYS_MLMC_HPP
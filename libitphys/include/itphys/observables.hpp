@@ -0,0 +1,385 @@
+/*
+ * itphys/observables.hpp
+ *
+ * 物理量の集計（平均二乗変位、運動エネルギー分布）と理論値
+ *
+ * 集計器も write(const ParticleState&) を持つので、run_brownian_motion() の sink として
+ * 直接渡すか、io.hpp の Tee で出力と同時に集計できる。
+ */
+
+#ifndef ITPHYS_OBSERVABLES_HPP
+#define ITPHYS_OBSERVABLES_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "itphys/instrument.hpp"
+#include "itphys/langevin.hpp"
+
+namespace itphys {
+
+/**
+ * 平均と分散の逐次計算（Welford 法）
+ * merge() で別々に集計した結果を足し合わせられる（Chan らの公式）
+ */
+class RunningStats {
+public:
+    void add(double x) {
+        n_ += 1.0;
+        const double d = x - mean_;
+        mean_ += d / n_;
+        m2_ += d * (x - mean_);
+    }
+
+    void merge(const RunningStats& o) {
+        if (o.n_ == 0.0) return;
+        const double n = n_ + o.n_;
+        const double d = o.mean_ - mean_;
+        mean_ += d * o.n_ / n;
+        m2_ += o.m2_ + d * d * n_ * o.n_ / n;
+        n_ = n;
+    }
+
+    /** 個数・平均・偏差平方和から作る（まとめて計算した部分集計を merge() するため） */
+    static RunningStats from_moments(double n, double mean, double m2) {
+        RunningStats r;
+        r.n_ = n;
+        r.mean_ = mean;
+        r.m2_ = m2;
+        return r;
+    }
+
+    double count() const { return n_; }
+    double mean() const { return mean_; }
+    /** 偏差平方和 Σ(x - mean)²（from_moments() で元に戻せる） */
+    double m2() const { return m2_; }
+    /** 不偏分散 */
+    double variance() const { return n_ > 1.0 ? m2_ / (n_ - 1.0) : 0.0; }
+    /** 平均の標準誤差 */
+    double std_error() const { return n_ > 1.0 ? std::sqrt(variance() / n_) : 0.0; }
+
+private:
+    double n_ = 0.0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+};
+
+/**
+ * 相関のある時系列の平均の標準誤差（Flyvbjerg–Petersen のブロッキング法をその場で行う）
+ *
+ * レベル l は長さ 2^l のブロックの平均を RunningStats で集計する。標本を足すたびにレベル 0 に入れ、
+ * 対になる相手を待っているブロックの平均があれば2つの平均をレベル l+1 に送る。持つのはレベルごとの
+ * 集計と待っている平均1個だけなので、メモリは log2(n) に比例し、系列を保存しなくてよい。
+ * レベル l の平均の標準誤差 SE_l = sqrt(Var_l / n_l) は、ブロックが相関時間より長くなると一定になる。
+ * その平坦部（plateau）は Lee, Morales, Umrigar（2011）の基準 (2^l)³ > 2 n (SE_l / SE_0)⁴ を
+ * 満たす最小の l とし、積分自己相関時間は τ_int = SE_l² / (2 SE_0²)（標本の間隔の単位。
+ * 平均の分散が 2 τ_int σ² / n になる定義で、相関がなければ 1/2）とする。
+ * merge() は独立な系列（別の軌道・別のスレッド）の集計をレベルごとに足し合わせる
+ * （どちらも待っている平均は捨てる）。
+ */
+class BlockingStats {
+public:
+    void add(double x) {
+        for (std::size_t l = 0;; l++) {
+            if (l == levels_.size()) {
+                levels_.emplace_back();
+                pending_.push_back(0.0);
+                has_pending_.push_back(0);
+            }
+            levels_[l].add(x);
+            if (!has_pending_[l]) {
+                pending_[l] = x;
+                has_pending_[l] = 1;
+                return;
+            }
+            x = 0.5 * (pending_[l] + x);
+            has_pending_[l] = 0;
+        }
+    }
+
+    void merge(const BlockingStats& o);
+
+    std::size_t n_levels() const { return levels_.size(); }
+    /** レベル l のブロックの平均の集計（レベル 0 は全標本） */
+    const RunningStats& level(std::size_t l) const { return levels_[l]; }
+    /** レベル l のブロックから求めた平均の標準誤差 */
+    double std_error(std::size_t l) const { return levels_[l].std_error(); }
+    /** std_error(l) 自体の誤差 SE_l / sqrt(2 (n_l - 1)) */
+    double std_error_error(std::size_t l) const {
+        const double n = levels_[l].count();
+        return n > 1.0 ? std_error(l) / std::sqrt(2.0 * (n - 1.0)) : 0.0;
+    }
+    /** 平坦部のレベル（見つからない、つまり系列が相関時間に比べて短いときは -1） */
+    int plateau_level() const;
+    /** 平坦部の標準誤差（見つからなければ、ブロックが2個以上あるレベルの最大値） */
+    double plateau_std_error() const;
+    /** 積分自己相関時間 τ_int（標本の間隔の単位） */
+    double autocorrelation_time() const;
+
+    /** レベルごとの集計と待っている平均（無ければ NaN）を置き換える（チェックポイントからの復元用） */
+    void set_state(const std::vector<RunningStats>& levels, const std::vector<double>& pending);
+    /** レベルごとの待っている平均（無ければ NaN） */
+    std::vector<double> pending() const;
+
+private:
+    std::vector<RunningStats> levels_;
+    std::vector<double> pending_;
+    std::vector<unsigned char> has_pending_;
+};
+
+/**
+ * 2つの量 (x, y) の平均・分散・共分散の逐次計算（RunningStats の2変数版）
+ * 制御変量の係数 β = Cov(x, y) / Var(y) を求めるのに使う
+ */
+class CovarianceStats {
+public:
+    void add(double x, double y) {
+        const double dx = x - mx_;
+        const double dy = y - my_;
+        n_ += 1.0;
+        mx_ += dx / n_;
+        my_ += dy / n_;
+        m2x_ += dx * (x - mx_);
+        m2y_ += dy * (y - my_);
+        cxy_ += dx * (y - my_);
+    }
+
+    void merge(const CovarianceStats& o) {
+        if (o.n_ == 0.0) return;
+        const double n = n_ + o.n_;
+        const double dx = o.mx_ - mx_;
+        const double dy = o.my_ - my_;
+        const double w = n_ * o.n_ / n;
+        mx_ += dx * o.n_ / n;
+        my_ += dy * o.n_ / n;
+        m2x_ += o.m2x_ + dx * dx * w;
+        m2y_ += o.m2y_ + dy * dy * w;
+        cxy_ += o.cxy_ + dx * dy * w;
+        n_ = n;
+    }
+
+    /** 個数・平均・偏差平方和・偏差の積の和から作る */
+    static CovarianceStats from_moments(double n, double mx, double my, double m2x, double m2y,
+                                        double cxy) {
+        CovarianceStats r;
+        r.n_ = n;
+        r.mx_ = mx;
+        r.my_ = my;
+        r.m2x_ = m2x;
+        r.m2y_ = m2y;
+        r.cxy_ = cxy;
+        return r;
+    }
+
+    double count() const { return n_; }
+    double mean_x() const { return mx_; }
+    double mean_y() const { return my_; }
+    /** 不偏分散・不偏共分散 */
+    double var_x() const { return n_ > 1.0 ? m2x_ / (n_ - 1.0) : 0.0; }
+    double var_y() const { return n_ > 1.0 ? m2y_ / (n_ - 1.0) : 0.0; }
+    double cov() const { return n_ > 1.0 ? cxy_ / (n_ - 1.0) : 0.0; }
+
+private:
+    double n_ = 0.0;
+    double mx_ = 0.0, my_ = 0.0;
+    double m2x_ = 0.0, m2y_ = 0.0, cxy_ = 0.0;
+};
+
+/** 運動エネルギー E = (1/2) m (vx² + vy²) */
+inline double kinetic_energy(const ParticleState& s, double m) {
+    return 0.5 * m * (s.vx * s.vx + s.vy * s.vy);
+}
+
+/**
+ * 平均二乗変位 ⟨r²(t)⟩ の集計器
+ * 1回の試行ごとに begin_run() を呼び、write() に渡された順番を時刻の添字とみなす
+ */
+class MsdAccumulator {
+public:
+    explicit MsdAccumulator(std::size_t n_times) : r2_(n_times), t_(n_times, 0.0) {}
+
+    void begin_run() { index_ = 0; }
+
+    void write(const ParticleState& s) {
+        ITPHYS_PHASE(kObserve);
+        if (index_ < r2_.size()) {
+            r2_[index_].add(s.x * s.x + s.y * s.y);
+            t_[index_] = s.t;
+        }
+        index_++;
+    }
+
+    /** 時刻の添字 i に、まとめて集計した r² の統計を加える */
+    void add(std::size_t i, double t, const RunningStats& r2) {
+        r2_[i].merge(r2);
+        t_[i] = t;
+    }
+
+    /** 時刻 i の値をそのまま置き換える（チェックポイントからの復元用） */
+    void set(std::size_t i, double t, const RunningStats& r2) {
+        r2_[i] = r2;
+        t_[i] = t;
+    }
+    /** 現在の試行で次に write() される時刻の添字 */
+    std::size_t cursor() const { return index_; }
+    void set_cursor(std::size_t i) { index_ = i; }
+
+    std::size_t size() const { return r2_.size(); }
+    double time(std::size_t i) const { return t_[i]; }
+    const RunningStats& at(std::size_t i) const { return r2_[i]; }
+
+    void merge(const MsdAccumulator& o) {
+        for (std::size_t i = 0; i < r2_.size() && i < o.r2_.size(); i++) {
+            r2_[i].merge(o.r2_[i]);
+            if (t_[i] == 0.0) t_[i] = o.t_[i];
+        }
+    }
+
+private:
+    std::vector<RunningStats> r2_;
+    std::vector<double> t_;
+    std::size_t index_ = 0;
+};
+
+/**
+ * 運動エネルギーのヒストグラム（0 <= E < e_max を n_bins 等分）
+ * 平均・分散も同時に集計する。標本は同じ軌道の毎ステップの値で互いに相関しているので、
+ * 平均の標準誤差は足した順の系列のブロッキング解析（blocking()）から求める
+ */
+class EnergyHistogram {
+public:
+    EnergyHistogram(double m, double e_max, std::size_t n_bins)
+        : m_(m), e_max_(e_max), count_(n_bins, 0) {}
+
+    void write(const ParticleState& s) {
+        ITPHYS_PHASE(kObserve);
+        add(kinetic_energy(s, m_));
+    }
+
+    /** 1本の軌道の時刻の順の値（分布と平均に足し、ブロッキング解析の系列にも足す） */
+    void add(double e) {
+        add_independent(e);
+        blocking_.add(e);
+    }
+
+    /**
+     * 同じ時刻の独立な粒子の値（分布と平均にだけ足す。系列は粒子の平均の時刻の順の系列を
+     * 別の BlockingStats で集計し、merge_series() で足す）
+     */
+    void add_independent(double e) {
+        stats_.add(e);
+        if (e >= 0.0 && e < e_max_) {
+            count_[static_cast<std::size_t>(e / e_max_ * count_.size())]++;
+        } else {
+            overflow_++;
+        }
+    }
+
+    /** 別に集計した独立な系列（時刻の順に足したもの）のブロッキング解析をレベルごとに足し合わせる */
+    void merge_series(const BlockingStats& series) { blocking_.merge(series); }
+
+    /** 同じ範囲・ビン数の空のヒストグラム（スレッドごとの集計用） */
+    EnergyHistogram empty_copy() const { return EnergyHistogram(m_, e_max_, count_.size()); }
+
+    /** 同じ範囲・ビン数のヒストグラムを足し合わせる */
+    void merge(const EnergyHistogram& o) {
+        for (std::size_t i = 0; i < count_.size() && i < o.count_.size(); i++) {
+            count_[i] += o.count_[i];
+        }
+        overflow_ += o.overflow_;
+        stats_.merge(o.stats_);
+        blocking_.merge(o.blocking_);
+    }
+
+    std::size_t n_bins() const { return count_.size(); }
+    double bin_width() const { return e_max_ / count_.size(); }
+    double bin_center(std::size_t i) const { return (i + 0.5) * bin_width(); }
+    unsigned long long count(std::size_t i) const { return count_[i]; }
+    /** 確率密度（範囲外の標本も全体数に含めて規格化する） */
+    double density(std::size_t i) const {
+        const double n = stats_.count();
+        return n > 0.0 ? count_[i] / (n * bin_width()) : 0.0;
+    }
+    unsigned long long overflow() const { return overflow_; }
+    const RunningStats& stats() const { return stats_; }
+    /** 足した順の系列のブロッキング解析（stats().std_error() は標本を独立とみなした値） */
+    const BlockingStats& blocking() const { return blocking_; }
+    double mass() const { return m_; }
+    double e_max() const { return e_max_; }
+
+    /** 各ビンの数・範囲外の数・統計量をそのまま置き換える（チェックポイントからの復元用） */
+    void set_state(const std::vector<unsigned long long>& counts, unsigned long long overflow,
+                   const RunningStats& stats) {
+        count_ = counts;
+        overflow_ = overflow;
+        stats_ = stats;
+    }
+    void set_blocking(const BlockingStats& blocking) { blocking_ = blocking; }
+
+private:
+    double m_;
+    double e_max_;
+    std::vector<unsigned long long> count_;
+    unsigned long long overflow_ = 0;
+    RunningStats stats_;
+    BlockingStats blocking_;
+};
+
+/**
+ * 理論的な平均二乗変位（初速度が熱平衡分布、dim 次元）: report1_haruki.py の theoretical_msd と同じ式
+ * ⟨r²(t)⟩ = (2·dim·kBT/γ) [t - τ(1 - e^{-t/τ})],  τ = m/γ
+ * （以下の理論値は dim 次元では各成分の和で、2次元の係数 4 = 2·2 が 2·dim になる）
+ */
+inline double theoretical_msd(double t, const LangevinParams& p, int dim = 2) {
+    const double tau = p.m / p.gamma;
+    return 2.0 * dim * p.kB * p.T / p.gamma * (t - tau * (1.0 - std::exp(-t / tau)));
+}
+
+/**
+ * 静止状態 (r, v) = (0, 0) から始めたときの厳密な平均二乗変位（2次元）
+ * ⟨r²(t)⟩ = (4kBT/γ) [t - (3/2)τ + 2τ e^{-t/τ} - (τ/2) e^{-2t/τ}]
+ * theoretical_msd は初速度が熱平衡分布のときの式なので、v = 0 から始めるシミュレーションとは
+ * 長時間でも 2kBTτ/γ だけずれる（積分器の精度を測るときはこちらと比べる）
+ */
+inline double theoretical_msd_from_rest(double t, const LangevinParams& p, int dim = 2) {
+    const double tau = p.m / p.gamma;
+    const double x = t / tau;
+    // 小さい t では桁落ちするので展開 (4kBT/γ) τ x³ (1/3 - x/4 + 7x²/60 - x³/24 + 31x⁴/2520) を使う
+    if (x < 1e-2) {
+        const double poly = 1.0 / 3.0 + x * (-0.25 + x * (7.0 / 60.0 + x * (-1.0 / 24.0 + x * 31.0 / 2520.0)));
+        return 2.0 * dim * p.kB * p.T / p.gamma * tau * x * x * x * poly;
+    }
+    return 2.0 * dim * p.kB * p.T / p.gamma *
+           (t - tau * (1.5 - 2.0 * std::exp(-x) + 0.5 * std::exp(-2.0 * x)));
+}
+
+/** 静止状態から始めたときの ⟨v²(t)⟩ = (2kBT/m)(1 - e^{-2t/τ})（2次元） */
+inline double theoretical_v2_from_rest(double t, const LangevinParams& p, int dim = 2) {
+    return -static_cast<double>(dim) * p.kB * p.T / p.m * std::expm1(-2.0 * t * p.gamma / p.m);
+}
+
+/** 拡散係数 D = kBT/γ（アインシュタインの関係式） */
+inline double diffusion_coefficient(const LangevinParams& p) {
+    return p.kB * p.T / p.gamma;
+}
+
+/**
+ * MSD から拡散係数を求める（長時間極限 MSD = 4Dt）: fit_diffusion_coefficient と同じく
+ * 後半の時刻 (t >= t_start) の MSD/(4t) を平均する（dim 次元では MSD = 2·dim·Dt で割る）
+ */
+double fit_diffusion_coefficient(const MsdAccumulator& msd, double t_start, int dim = 2);
+/** 時刻 t[i] の MSD msd[i] から同じように求める（分散低減した推定値など） */
+double fit_diffusion_coefficient(const std::vector<double>& t, const std::vector<double>& msd,
+                                 double t_start, int dim = 2);
+
+/**
+ * t >= t_start の MSD を直線で最小二乗フィットし、傾き / 4（dim 次元では / 2·dim）を返す
+ * MSD/(4t) の平均と違い、長時間での定数のずれ（静止状態から始めたときの -6Dτ など）の影響を受けない
+ */
+double fit_diffusion_slope(const std::vector<double>& t, const std::vector<double>& msd, double t_start,
+                           int dim = 2);
+
+}  // namespace itphys
+
+#endif  // ITPHYS_OBSERVABLES_HPP
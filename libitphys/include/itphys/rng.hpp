@@ -0,0 +1,190 @@
+/*
+ * itphys/rng.hpp
+ *
+ * 乱数生成器（全ての実行ファイルで共有）
+ *
+ * - Xoshiro256ss: 一様乱数の生成器 xoshiro256**。シードとストリーム番号から
+ *   splitmix64 で状態を作るので、粒子・スレッドごとに独立な乱数列を簡単に作れる
+ * - NormalRng: Box-Muller変換による標準正規分布N(0,1)の乱数。
+ *   1回の変換で得られる2つの値（cos と sin）を両方使う
+ * - UniformNoise: 平均 0・分散 1 の一様乱数（正規乱数の代わりに積分器に入れる安いノイズ）
+ * - stratified_normals: ラテン超方格（層別）で n 個の N(0,1) を作る（分散低減用）
+ */
+
+#ifndef ITPHYS_RNG_HPP
+#define ITPHYS_RNG_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace itphys {
+
+/** splitmix64: シードの撹拌に使う */
+inline std::uint64_t splitmix64(std::uint64_t& x) {
+    std::uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+inline std::uint64_t rotl64(std::uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * xoshiro256** 一様乱数生成器（周期 2^256 - 1）
+ * UniformRandomBitGenerator の要件を満たすので <random> の分布にも渡せる
+ */
+class Xoshiro256ss {
+public:
+    using result_type = std::uint64_t;
+
+    /**
+     * @param seed   乱数のシード
+     * @param stream ストリーム番号（同じシードでも番号ごとに独立な乱数列になる）
+     */
+    explicit Xoshiro256ss(std::uint64_t seed = 0, std::uint64_t stream = 0) {
+        std::uint64_t x = seed ^ rotl64(0xD1B54A32D192ED03ULL * (stream + 1), 17);
+        for (auto& w : s_) w = splitmix64(x);
+    }
+
+    result_type operator()() {
+        const std::uint64_t result = rotl64(s_[1] * 5, 7) * 9;
+        const std::uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl64(s_[3], 45);
+        return result;
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    /** 2^128 回分だけ状態を進める（重ならない部分列を作る） */
+    void jump();
+
+    const std::array<std::uint64_t, 4>& state() const { return s_; }
+    void set_state(const std::array<std::uint64_t, 4>& s) { s_ = s; }
+
+private:
+    std::array<std::uint64_t, 4> s_;
+};
+
+/** 64ビット整数から 0 < u < 1 の一様乱数を作る（上位53ビットを使う） */
+inline double to_unit_open(std::uint64_t r) {
+    return ((r >> 11) + 0.5) * 0x1.0p-53;
+}
+
+/** 23ビットの整数 k から単精度の 0 < u < 1 の一様乱数 (k + 1/2) 2^-23 を作る（丸めなしで正確） */
+inline float to_unit_open_float(std::uint32_t k) {
+    return (static_cast<float>(k) + 0.5f) * 0x1.0p-23f;
+}
+
+/**
+ * Box-Muller変換による標準正規分布N(0,1)の乱数
+ * Z0 = sqrt(-2 ln u1) cos(2π u2), Z1 = sqrt(-2 ln u1) sin(2π u2) の2つを順に返す
+ */
+class NormalRng {
+public:
+    explicit NormalRng(std::uint64_t seed = 0, std::uint64_t stream = 0) : eng_(seed, stream) {}
+
+    double operator()() {
+        if (has_spare_) {
+            has_spare_ = false;
+            return spare_;
+        }
+        double z0, z1;
+        box_muller(z0, z1);
+        spare_ = z1;
+        has_spare_ = true;
+        return z0;
+    }
+
+    /** n 個の正規乱数を out に書き込む */
+    void fill(double* out, std::size_t n);
+    /**
+     * 単精度の n 個（1つの64ビット乱数から 23 ビットずつ2つの一様乱数を取り、float の Box-Muller で作る。
+     * u1 >= 2^-24 なので |z| <= 5.77 で切れる（それより外の確率は 8e-9）
+     */
+    void fill(float* out, std::size_t n);
+
+    Xoshiro256ss& engine() { return eng_; }
+    const Xoshiro256ss& engine() const { return eng_; }
+
+    /** 生成器の完全な状態（Box-Muller の残りの1個を含む。チェックポイント用） */
+    struct State {
+        std::array<std::uint64_t, 4> engine;
+        double spare;
+        bool has_spare;
+    };
+    State state() const { return State{eng_.state(), spare_, has_spare_}; }
+    void set_state(const State& s) {
+        eng_.set_state(s.engine);
+        spare_ = s.spare;
+        has_spare_ = s.has_spare;
+    }
+
+private:
+    void box_muller(double& z0, double& z1) {
+        const double u1 = to_unit_open(eng_());
+        const double u2 = to_unit_open(eng_());
+        const double r = std::sqrt(-2.0 * std::log(u1));
+        const double th = 6.283185307179586477 * u2;  // 2π u2
+        z0 = r * std::cos(th);
+        z1 = r * std::sin(th);
+    }
+
+    Xoshiro256ss eng_;
+    double spare_ = 0.0;
+    bool has_spare_ = false;
+};
+
+/**
+ * 平均 0、分散 1 の一様分布 U(-√3, √3) の乱数（NormalRng と同じ使い方のノイズ）
+ *
+ * 1ステップの増分が正規分布でなくなるだけで、時間刻みについての弱い収束の次数は変わらない
+ * （Dünweg-Paul）。自由粒子や調和トラップのような線形の系では、⟨r²⟩ や ⟨v²⟩ のような
+ * 2次のモーメントは乱数の分散だけで決まるので正規乱数と全く同じ期待値になる
+ * （運動エネルギーの分布の形などは Δt → 0 で正しくなる）。
+ * log, sqrt, cos, sin を使わないので Box-Muller より何倍も速い
+ */
+class UniformNoise {
+public:
+    explicit UniformNoise(std::uint64_t seed = 0, std::uint64_t stream = 0) : eng_(seed, stream) {}
+
+    double operator()() { return kScale * (to_unit_open(eng_()) - 0.5); }
+
+    /** n 個の乱数を out に書き込む */
+    void fill(double* out, std::size_t n);
+    /** 単精度の n 個（1つの64ビット乱数から2つ作る） */
+    void fill(float* out, std::size_t n);
+
+    Xoshiro256ss& engine() { return eng_; }
+
+private:
+    static constexpr double kScale = 3.4641016151377546;  // 2√3
+
+    Xoshiro256ss eng_;
+};
+
+/** 標準正規分布の累積分布関数の逆関数 Φ^{-1}(u)（0 < u < 1、相対誤差 ~1e-15） */
+double inverse_normal_cdf(double u);
+
+/**
+ * ラテン超方格（層別）で n 個の N(0,1) を out に書く:
+ * out[i] = Φ^{-1}((π(i) + U_i) / n)（π はランダムな置換、U_i は一様乱数）
+ * [0, 1) を n 等分した各区間からちょうど1個ずつ取るので、標本の分布が N(0,1) に近くなる
+ */
+void stratified_normals(Xoshiro256ss& eng, double* out, std::size_t n);
+
+/** 現在時刻とプロセスIDからシードを作る（元の srand(time(NULL)) の代わり） */
+std::uint64_t seed_from_time();
+
+}  // namespace itphys
+
+#endif  // ITPHYS_RNG_HPP
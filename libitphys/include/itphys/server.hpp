@@ -0,0 +1,121 @@
+/*
+ * itphys/server.hpp
+ *
+ * 常駐するシミュレーションサーバー（1回のプロセス起動で多数の実行をこなす）
+ *
+ * 標準入力または Unix ドメインソケットから1行1ジョブの記述を読み、スレッドプールで
+ * 並行に実行して結果を返す。ジョブは空白区切りの key=value で、省略したキーは
+ * brownian_motion の既定値になる:
+ *
+ *   id=7 T=1.0 m=1.0 gamma=1.0 dt=0.01 n_steps=1000 seed=42 stream=0 output=trajectory
+ *
+ *   output=trajectory  "# t x y vx vy" の軌道（brownian_motion と同じテキスト、format=binary なら
+ *                      BinarySink の形式）
+ *   output=final       最後の状態 "t x y vx vy" の1行だけ
+ *   output=ensemble    particles 個の粒子の各時刻の "# t msd msd_err energy energy_err"
+ *                      （run_ensemble、integrator= で積分器を選べる。variance_reduction=control など
+ *                      （ensemble.hpp の VarianceReduction）を付けると msd, msd_err は分散低減した推定値）
+ *
+ * force=harmonic:k=2+washboard:v0=1 のように外力（force.hpp の parse_force_field の形式）を
+ * 指定できる（どの output でも。output=ensemble で integrator=exact_ou と一緒には使えない）。
+ *
+ * seed を省略するか 0 にすると現在時刻から決める。同じ seed で stream だけを変えると独立な乱数列になる。
+ * どの output の結果も5列の表なので、format=binary なら BinarySink の形式で返す。
+ *
+ * ResultCache を渡すと、seed を指定したジョブの結果をキー cache_key() でキャッシュし、
+ * 同じジョブは再計算せずに返す（検証モードでは再計算して一致を確かめ、違えば標準エラー出力に報告する）。
+ *
+ * 応答はジョブの終わった順に返り、それぞれ次の形で区切られる（id で対応を取る）:
+ *
+ *   # job <id> ok <n_bytes>\n<n_bytes バイトの結果>
+ *   # job <id> error <メッセージ>\n
+ *
+ * そのほかの行: 空行と '#' で始まる行は無視、"ping" には "# pong" を返す、
+ * "quit" でサーバーを終了する（実行中のジョブの結果は返してから終わる）。
+ */
+
+#ifndef ITPHYS_SERVER_HPP
+#define ITPHYS_SERVER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "itphys/cache.hpp"
+#include "itphys/ensemble.hpp"
+#include "itphys/langevin.hpp"
+
+namespace itphys {
+
+enum class JobOutput { kTrajectory, kFinal, kEnsemble };
+
+/** 1つのジョブの記述 */
+struct Job {
+    std::string id = "0";
+    LangevinParams p;
+    std::uint64_t seed = 0;  // 0 なら現在時刻
+    std::uint64_t stream = 0;
+    JobOutput output = JobOutput::kTrajectory;
+    bool binary = false;
+    std::size_t particles = 1000;  // output=ensemble のときの粒子数
+    Integrator integrator = Integrator::kEuler;
+    VarianceReduction variance_reduction;  // output=ensemble のときの分散低減
+    ForceField force;                      // 外力（既定は力なし）
+};
+
+/**
+ * 1行のジョブの記述を読む
+ *
+ * @param err 失敗したときの理由
+ * @return 読めたら true
+ */
+bool parse_job(const std::string& line, Job& job, std::string& err);
+
+/**
+ * キャッシュのキー: "engine=<kEngineVersion> " の後に結果を決めるキーだけを並べたジョブの記述
+ * （実数は %a で正確に書く。id と format は含めない）。"engine=N " を除けば parse_job で読める
+ */
+std::string cache_key(const Job& job);
+
+/** ジョブの結果を n × 5 の表（行優先）として計算する */
+std::vector<double> run_table(const Job& job);
+
+/**
+ * ジョブを（呼び出したスレッドで）実行し、結果の本体を返す。失敗すると std::runtime_error
+ *
+ * @param cache nullptr でなければ、seed を指定したジョブの結果をキャッシュする
+ */
+std::string run_job(const Job& job, ResultCache* cache = nullptr);
+
+/**
+ * in_fd から読んだジョブを n_threads 個のワーカーで実行し、応答を out_fd に書く
+ *
+ * in_fd が EOF になるか "quit" を読むと、実行中のジョブを全て終えてから戻る。
+ * @return "quit" で終わったら true
+ */
+bool serve_stream(int in_fd, int out_fd, int n_threads, ResultCache* cache = nullptr);
+
+/**
+ * Unix ドメインソケット path で待ち受け、接続ごとに serve_stream と同じやり取りをする
+ * （ワーカーは全ての接続で共有する）。どれかの接続で "quit" を受けると終了する。
+ *
+ * @return 0: 正常終了、それ以外: ソケットを作れなかった
+ */
+int serve_unix_socket(const std::string& path, int n_threads, ResultCache* cache = nullptr);
+
+/** キャッシュの検証の結果 */
+struct CacheVerifyResult {
+    std::size_t ok = 0;
+    std::size_t mismatch = 0;  // 再計算と一致しない
+    std::size_t stale = 0;     // エンジンのバージョンが古い
+    std::size_t invalid = 0;   // 読めない
+};
+
+/** キャッシュの全エントリを再計算して一致を確かめる（一致しないものを log に書く） */
+CacheVerifyResult verify_cache(const ResultCache& cache, std::FILE* log);
+
+}  // namespace itphys
+
+#endif  // ITPHYS_SERVER_HPP
@@ -0,0 +1,143 @@
+/*
+ * itphys/suspension.hpp
+ *
+ * 相互作用するブラウン粒子（2次元のコロイド分散系）
+ *
+ * N 個の粒子を一辺 L の周期境界の正方形の箱に入れ、brownian_motion と同じランジュバン方程式
+ * （オイラー法、EulerIntegrator）に粒子間力 Σ_j F(r_ij) を加えて計算する。対ポテンシャルは
+ *   WCA            U = 4ε((σ/r)^12 - (σ/r)^6) + ε        （r < 2^{1/6}σ、斥力だけ）
+ *   Lennard-Jones  U = 4ε((σ/r)^12 - (σ/r)^6) - U(r_c)   （r < r_c、既定 r_c = 2.5σ）
+ *   Yukawa         U = εσ e^{-κ(r-σ)}/r - U(r_c)          （r < r_c、既定 r_c = σ + 5/κ）
+ *
+ * 近傍の探索:
+ * - セルリスト: 箱を一辺 r_c + skin 以上のセルに分け、粒子をセルの順に並べ替える（数え上げソート）。
+ *   近傍は自分と隣の 9 セルにしかいない
+ * - Verlet リスト: セルリストから距離 r_c + skin 以内の粒子の表（CSR 形式）を作り、前回作ったときから
+ *   どれかの粒子が skin/2 以上動くまで使い回す（動いた距離はステップの中で同時に求める）
+ * 表は粒子ごとに全ての近傍を持つ（i と j の両方に載る）ので、力は各粒子が自分の分だけを足す。
+ * 作用・反作用を使う半分の表より計算は2倍だが、スレッドは自分の粒子の力しか書かないので
+ * アトミック操作もスレッドごとの力の配列もいらず、結果はスレッド数に依らない。
+ *
+ * 位置はアンラップした座標（箱の外に出たまま）で持ち、距離は最小像規約で測る。
+ * 乱数は EulerIntegrator::kNoiseBlock 粒子のブロックごとに NormalRng(seed, ブロック番号) で、
+ * 並べ替えの後も配列の添字のブロックで使う（粒子と乱数列の対応は変わるが、結果はスレッド数に依らない）。
+ * 初期配置は正方格子、初速度は 0。
+ *
+ *   itphys::SuspensionOptions opt;
+ *   opt.n_particles = 1 << 20;
+ *   opt.density = 0.5;
+ *   itphys::Suspension s(p, opt);
+ *   s.step(1000);
+ *   std::printf("%g %g\n", s.msd(), s.potential_energy());
+ */
+
+#ifndef ITPHYS_SUSPENSION_HPP
+#define ITPHYS_SUSPENSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "itphys/langevin.hpp"
+#include "itphys/rng.hpp"
+
+namespace itphys {
+
+enum class PairPotential { kWca, kLennardJones, kYukawa };
+
+inline const char* pair_potential_name(PairPotential k) {
+    switch (k) {
+        case PairPotential::kLennardJones: return "lj";
+        case PairPotential::kYukawa: return "yukawa";
+        default: return "wca";
+    }
+}
+
+/** "wca" / "lj" / "yukawa" を読む。知らない名前なら false */
+inline bool parse_pair_potential(const std::string& name, PairPotential& out) {
+    for (PairPotential k : {PairPotential::kWca, PairPotential::kLennardJones, PairPotential::kYukawa}) {
+        if (name == pair_potential_name(k)) {
+            out = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct PairParams {
+    PairPotential kind = PairPotential::kWca;
+    double epsilon = 1.0;  // エネルギーの大きさ（Yukawa では r = σ での値）
+    double sigma = 1.0;    // 粒子の直径
+    double kappa = 1.0;    // Yukawa の遮蔽の逆長さ
+    double cutoff = 0.0;   // カットオフ（0 なら種類ごとの既定値）
+    double skin = 0.3;     // Verlet リストの余白
+
+    /** 実際に使うカットオフ */
+    double cutoff_radius() const;
+};
+
+struct SuspensionOptions {
+    std::size_t n_particles = 1024;
+    double density = 0.5;  // 数密度 N/L²
+    PairParams pair;
+    std::uint64_t seed = 1;
+    int n_threads = 0;  // 0 なら OpenMP の既定（OMP_NUM_THREADS）
+};
+
+class Suspension {
+public:
+    /**
+     * 正方格子に並べた静止状態から始める
+     *
+     * @throw std::invalid_argument 粒子がない、密度・σ が正でない、箱が近傍探索のセル 3 個分より小さいとき
+     */
+    Suspension(const LangevinParams& p, const SuspensionOptions& opt);
+
+    /** n ステップ進める */
+    void step(long long n = 1);
+
+    std::size_t size() const { return x_.size(); }
+    double box() const { return box_; }
+    double time() const { return t_; }
+    long long rebuilds() const { return rebuilds_; }  // 近傍リストを作った回数（最初の1回を含む）
+    std::size_t n_neighbors() const { return neigh_.size(); }  // 近傍リストの長さ（i-j と j-i を別に数える）
+
+    /** 1粒子あたりの平均二乗変位 ⟨|r - r(0)|²⟩（アンラップした座標で） */
+    double msd() const;
+    /** 1粒子あたりの運動エネルギー */
+    double kinetic_energy() const;
+    /** 1粒子あたりのポテンシャルエネルギー（呼ぶたびに近傍リストから計算する） */
+    double potential_energy() const;
+
+    // 粒子の状態（SoA、近傍リストを作るたびにセルの順に並べ替わる。id は最初の番号）
+    const std::vector<double>& x() const { return x_; }
+    const std::vector<double>& y() const { return y_; }
+    const std::vector<double>& vx() const { return vx_; }
+    const std::vector<double>& vy() const { return vy_; }
+    const std::vector<std::uint32_t>& id() const { return id_; }
+
+private:
+    void build_neighbors();
+    void compute_forces();
+
+    LangevinParams p_;
+    PairParams pair_;
+    EulerIntegrator integ_;
+    int n_threads_;
+    double box_;
+    double t_ = 0.0;
+    long long rebuilds_ = 0;
+
+    std::vector<double> x_, y_, vx_, vy_, fx_, fy_;
+    std::vector<double> x0_, y0_;        // 初期位置（MSD 用）
+    std::vector<double> xref_, yref_;    // 近傍リストを作ったときの位置
+    std::vector<std::uint32_t> id_;
+    std::vector<NormalRng> rngs_;        // ブロックごとの乱数列
+    std::vector<std::size_t> start_;     // 粒子 i の近傍は neigh_[start_[i] .. start_[i+1])
+    std::vector<std::uint32_t> neigh_;
+};
+
+}  // namespace itphys
+
+#endif  // ITPHYS_SUSPENSION_HPP
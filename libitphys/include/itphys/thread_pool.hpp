@@ -0,0 +1,96 @@
+/*
+ * itphys/thread_pool.hpp
+ *
+ * 固定数のワーカースレッドで仕事（std::function<void()>）を順に実行するスレッドプール
+ *
+ *   itphys::ThreadPool pool(4);
+ *   for (...) pool.submit([=] { ... });
+ *   pool.wait_idle();   // 投入した仕事が全て終わるまで待つ
+ *
+ * デストラクタは残っている仕事を全て実行してからスレッドを終了させる。
+ */
+
+#ifndef ITPHYS_THREAD_POOL_HPP
+#define ITPHYS_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace itphys {
+
+class ThreadPool {
+public:
+    /** @param n_threads ワーカー数（0 以下なら std::thread::hardware_concurrency()） */
+    explicit ThreadPool(int n_threads) {
+        if (n_threads <= 0) n_threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (n_threads <= 0) n_threads = 1;
+        workers_.reserve(n_threads);
+        for (int i = 0; i < n_threads; i++) workers_.emplace_back([this] { work(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (std::thread& t : workers_) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            queue_.push_back(std::move(task));
+            pending_++;
+        }
+        cv_.notify_one();
+    }
+
+    /** 投入済みの仕事が全て終わるまで待つ */
+    void wait_idle() {
+        std::unique_lock<std::mutex> lock(mu_);
+        idle_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+    int size() const { return static_cast<int>(workers_.size()); }
+
+private:
+    void work() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+                if (queue_.empty()) return;  // stop_ かつ仕事が残っていない
+                task = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            task();
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                if (--pending_ == 0) idle_.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> queue_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::condition_variable idle_;
+    std::size_t pending_ = 0;
+    bool stop_ = false;
+};
+
+}  // namespace itphys
+
+#endif  // ITPHYS_THREAD_POOL_HPP
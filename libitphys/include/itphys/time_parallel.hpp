@@ -0,0 +1,51 @@
+/*
+ * itphys/time_parallel.hpp
+ *
+ * 1本の長い軌道の時間方向の並列計算
+ *
+ * 力のないランジュバン方程式のオイラー法は、各成分 (r, v) について
+ *   (r, v)_{n+1} = A (r, v)_n + b_n,  A = [[1, (1-(γ/m)Δt)Δt], [0, 1-(γ/m)Δt]]
+ * というアフィン漸化式で、b_n はノイズだけで決まる。アフィン写像の合成は結合的なので、
+ * 軌道全体を並列スキャン（ブロックごとに reduce してから scan）で求められる:
+ *
+ *   1. 軌道を opt.chunk ステップずつに分け、各チャンクを自分の乱数列 NormalRng(seed, チャンク番号)
+ *      で並列に計算する。最初のチャンクは初期状態から、それ以外は位置・速度 0 から（局所解）
+ *   2. チャンクの始点の状態を S_{k+1} = A^L S_k + (局所解の終点) で順に求める
+ *      （チャンク数は n_steps / chunk 個なので、ここは逐次でも短い）
+ *   3. out があれば、各時刻の局所解に A^j S_k を並列に足す
+ *
+ * 結果はスレッド数に依らない（chunk で決まる）。最初のチャンクは run_brownian_motion と同じ
+ * 乱数列 NormalRng(seed, 0) を同じ順に使うので、chunk >= n_steps ならビット単位で同じ結果になる。
+ * 2番目以降のチャンクは乱数列が別なので同じ seed でも別の標本路になり、足し算の順番が違うぶん
+ * 同じ乱数で逐次に計算した場合とも丸め誤差の範囲で異なる。
+ * out を書かなければ仕事量は逐次計算とほぼ同じで、書く場合は 3. のメモリ律速の1パスが加わる。
+ */
+
+#ifndef ITPHYS_TIME_PARALLEL_HPP
+#define ITPHYS_TIME_PARALLEL_HPP
+
+#include <cstdint>
+
+#include "itphys/langevin.hpp"
+
+namespace itphys {
+
+struct TimeParallelOptions {
+    std::uint64_t seed = 1;
+    int n_threads = 0;          // 0 なら OpenMP の既定（OMP_NUM_THREADS）
+    long long chunk = 1 << 16;  // 1つの乱数列で計算するステップ数
+};
+
+/**
+ * 初期状態 init から p.n_steps ステップを時間方向に並列に計算する（オイラー法）
+ *
+ * @param out nullptr でなければ (p.n_steps + 1) × 5 の t, x, y, vx, vy を書く
+ *            （BinarySink のレコードと同じ並び。mmap したファイルを渡してもよい）
+ * @return 最終状態
+ */
+ParticleState run_time_parallel(const LangevinParams& p, const TimeParallelOptions& opt,
+                                double* out = nullptr, ParticleState init = ParticleState());
+
+}  // namespace itphys
+
+#endif  // ITPHYS_TIME_PARALLEL_HPP
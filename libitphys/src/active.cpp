@@ -0,0 +1,161 @@
+/*
+ * active.cpp
+ *
+ * 自己推進する粒子（itphys/active.hpp を参照）
+ */
+
+#include "itphys/active.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "itphys/instrument.hpp"
+#include "itphys/observables.hpp"
+
+namespace itphys {
+
+namespace {
+
+constexpr std::size_t kBlock = EulerIntegrator::kNoiseBlock;
+
+/** ∫_0^t e^{-kτ} dτ */
+double exp_integral(double k, double t) {
+    return k > 0.0 ? -std::expm1(-k * t) / k : t;
+}
+
+/**
+ * 推進による変位の2乗の半分 I(t) = ∫_0^t ∫_0^t g(τ) g(τ') e^{-D_r|τ-τ'|} dτ dτ' / 2（g(τ) = 1 - e^{-aτ}）
+ * D_r = a では式が 0/0 になるので、その近くでは D_r ± δ の平均を使う
+ */
+double active_msd_integral(double a, double dr, double t) {
+    if (dr * t < 1e-6) {
+        // 向きが変わらない: r = v0 (t - E(a)) e
+        const double s = t - exp_integral(a, t);
+        return 0.5 * s * s;
+    }
+    const auto eval = [a, t](double d) {
+        const double p = 1.0 / (d - a), q = 1.0 / d;
+        return t * q + exp_integral(d, t) * (p - q) - exp_integral(a, t) * (p + q) -
+               exp_integral(a + d, t) * (p - q) + exp_integral(2.0 * a, t) * p;
+    };
+    if (std::fabs(dr - a) < 1e-4 * a) return 0.5 * (eval(a * (1.0 + 1e-4)) + eval(a * (1.0 - 1e-4)));
+    return eval(dr);
+}
+
+/** 推進による速度の2乗 J(t) = ∫_0^t e^{-aτ} ∫_0^τ e^{-aτ'} e^{-D_r(τ-τ')} dτ' dτ */
+double active_v2_integral(double a, double dr, double t) {
+    const auto eval = [a, t](double d) { return (exp_integral(2.0 * a, t) - exp_integral(a + d, t)) / (d - a); };
+    if (std::fabs(dr - a) < 1e-4 * a) return 0.5 * (eval(a * (1.0 + 1e-4)) + eval(a * (1.0 - 1e-4)));
+    return eval(dr);
+}
+
+}  // namespace
+
+ActiveBrownian::ActiveBrownian(const LangevinParams& p, const ActiveOptions& opt)
+    : p_(p),
+      opt_(opt),
+      integ_(p),
+      n_threads_(opt.n_threads > 0 ? opt.n_threads : max_threads()),
+      push_(p.gamma * opt.v0),
+      turn_(std::sqrt(2.0 * opt.rot_diffusion * p.dt) / 6.283185307179586) {
+    const std::size_t n = opt.n_particles;
+    if (n == 0 || !(p.m > 0.0) || !(p.gamma > 0.0) || !(opt.v0 >= 0.0) || !(opt.rot_diffusion >= 0.0)) {
+        throw std::invalid_argument("active: particles, m and gamma must be positive, v0 and D_r non-negative");
+    }
+    x_.assign(n, 0.0);
+    y_.assign(n, 0.0);
+    vx_.assign(n, 0.0);
+    vy_.assign(n, 0.0);
+    u_.resize(n);
+    // 向きはブロックの乱数列の最初の一様乱数で決める
+    const std::size_t n_blocks = (n + kBlock - 1) / kBlock;
+    for (std::size_t k = 0; k < n_blocks; k++) {
+        Xoshiro256ss* eng;
+        if (opt.noise == Noise::kUniform) {
+            uniform_.emplace_back(opt.seed, k);
+            eng = &uniform_.back().engine();
+        } else {
+            normal_.emplace_back(opt.seed, k);
+            eng = &normal_.back().engine();
+        }
+        for (std::size_t i = k * kBlock; i < std::min(n, (k + 1) * kBlock); i++) {
+            u_[i] = to_unit_open((*eng)()) - 0.5;
+        }
+    }
+}
+
+template <class Rng, class Force>
+void ActiveBrownian::advance(std::vector<Rng>& rngs, const Force& force, long long n_steps) {
+    const std::size_t n = size();
+    for (long long s = 0; s < n_steps; s++) {
+#pragma omp parallel for num_threads(n_threads_) schedule(static)
+        for (std::size_t k = 0; k < rngs.size(); k++) {
+            const std::size_t i0 = k * kBlock;
+            const std::size_t b = std::min(kBlock, n - i0);
+            double eta[3 * kBlock];  // x, y, θ の順に b 個ずつ
+            double fx[kBlock], fy[kBlock];
+            {
+                ITPHYS_PHASE(kRng);
+                rngs[k].fill(eta, 3 * b);
+            }
+            ITPHYS_PHASE(kStep);
+            double* x = x_.data() + i0;
+            double* y = y_.data() + i0;
+            double* u = u_.data() + i0;
+            const double* eu = eta + 2 * b;
+            // 推進力と外力（今の向きと位置で）、向きの回転拡散
+            for (std::size_t i = 0; i < b; i++) {
+                double sn, cs;
+                sincos_2pi(u[i], sn, cs);
+                double f_x = push_ * cs, f_y = push_ * sn;
+                force(x[i], y[i], f_x, f_y);
+                fx[i] = f_x;
+                fy[i] = f_y;
+                const double w = u[i] + turn_ * eu[i];
+                u[i] = w - nearest_integer(w);
+            }
+            integ_.step_block(x, y, vx_.data() + i0, vy_.data() + i0, fx, fy, eta, b);
+            ITPHYS_COUNT(kSteps, b);
+            ITPHYS_COUNT(kSamples, 3 * b);
+        }
+        t_ += p_.dt;
+    }
+}
+
+void ActiveBrownian::step(long long n_steps) {
+    visit_force(opt_.force, [&](const auto& force) {
+        if (opt_.noise == Noise::kUniform) {
+            advance(uniform_, force, n_steps);
+        } else {
+            advance(normal_, force, n_steps);
+        }
+    });
+}
+
+double ActiveBrownian::msd() const {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < size(); i++) sum += x_[i] * x_[i] + y_[i] * y_[i];
+    return sum / size();
+}
+
+double ActiveBrownian::kinetic_energy() const {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < size(); i++) sum += vx_[i] * vx_[i] + vy_[i] * vy_[i];
+    return 0.5 * p_.m * sum / size();
+}
+
+double active_effective_diffusion(const LangevinParams& p, double v0, double rot_diffusion) {
+    return diffusion_coefficient(p) + v0 * v0 / (2.0 * rot_diffusion);
+}
+
+double active_theoretical_msd(double t, const LangevinParams& p, double v0, double rot_diffusion) {
+    return theoretical_msd_from_rest(t, p) + 2.0 * v0 * v0 * active_msd_integral(p.gamma / p.m, rot_diffusion, t);
+}
+
+double active_theoretical_v2(double t, const LangevinParams& p, double v0, double rot_diffusion) {
+    const double a = p.gamma / p.m;
+    return theoretical_v2_from_rest(t, p) + 2.0 * a * a * v0 * v0 * active_v2_integral(a, rot_diffusion, t);
+}
+
+}  // namespace itphys
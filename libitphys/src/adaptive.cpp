@@ -0,0 +1,79 @@
+/*
+ * adaptive.cpp
+ *
+ * 収束するまで試行を足していくアンサンブル計算（itphys/adaptive.hpp を参照）
+ */
+
+#include "itphys/adaptive.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+namespace itphys {
+
+AdaptiveResult run_adaptive(const LangevinParams& p, const AdaptiveOptions& opt,
+                            const std::function<void(const AdaptiveResult&)>& progress) {
+    if (opt.ensemble.n_particles == 0 || opt.max_batches == 0) {
+        throw std::invalid_argument("adaptive: the batch size and max_batches must be positive");
+    }
+    const std::size_t n_times = static_cast<std::size_t>(p.n_steps) + 1;
+    const std::size_t blocks_per_batch =
+        (opt.ensemble.n_particles + EulerIntegrator::kNoiseBlock - 1) / EulerIntegrator::kNoiseBlock;
+    const std::size_t min_batches = std::max<std::size_t>(opt.min_batches, 2);
+    const bool reduced = opt.ensemble.variance_reduction.any();
+
+    AdaptiveResult r;
+    r.time.resize(n_times);
+    r.msd.resize(n_times);
+    r.energy.resize(n_times);
+    std::vector<double> msd(n_times);
+    EnsembleOptions eo = opt.ensemble;
+    for (;;) {
+        eo.first_stream = opt.ensemble.first_stream + r.batches * blocks_per_batch;
+        EnsembleObservables obs(n_times);
+        const auto t0 = std::chrono::steady_clock::now();
+        run_ensemble(p, eo, &obs);
+        r.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        for (std::size_t i = 0; i < n_times; i++) {
+            r.time[i] = obs.msd.time(i);
+            msd[i] = reduced ? obs.msd_reduced[i].mean : obs.msd.at(i).mean();
+            r.msd[i].add(msd[i]);
+            r.energy[i].add(obs.energy[i].mean());
+        }
+        switch (opt.target) {
+            case AdaptiveTarget::kDiffusion:
+                r.target.add(fit_diffusion_coefficient(r.time, msd, r.time[n_times / 2], eo.dim));
+                break;
+            case AdaptiveTarget::kMsd:
+                r.target.add(msd.back());
+                break;
+            case AdaptiveTarget::kEnergy:
+                r.target.add(obs.energy.back().mean());
+                break;
+        }
+        r.batches++;
+        r.particles += eo.n_particles;
+        if (progress) progress(r);
+
+        const double tol = std::max(opt.tolerance, opt.rel_tolerance * std::fabs(r.target.mean()));
+        if (r.batches >= min_batches && r.target.std_error() <= tol) {
+            r.stop = AdaptiveStop::kTolerance;
+            break;
+        }
+        if (r.batches >= opt.max_batches) {
+            r.stop = AdaptiveStop::kMaxBatches;
+            break;
+        }
+        // 次のバッチもこれまでの平均と同じだけ掛かるとして、予算を超えるなら始めない
+        if (opt.time_budget > 0.0 && r.batches >= 2 && r.seconds * (r.batches + 1) / r.batches > opt.time_budget) {
+            r.stop = AdaptiveStop::kTimeBudget;
+            break;
+        }
+    }
+    return r;
+}
+
+}  // namespace itphys
@@ -0,0 +1,234 @@
+/*
+ * cache.cpp
+ *
+ * シミュレーション結果のキャッシュ（itphys/cache.hpp を参照）
+ */
+
+#include "itphys/cache.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace itphys {
+
+namespace {
+
+constexpr char kCacheMagic[8] = {'I', 'T', 'P', 'H', 'Y', 'S', 'C', '1'};
+constexpr std::size_t kCacheHeaderSize = 16;
+constexpr char kSuffix[] = ".itc";
+
+std::size_t padded(std::size_t n) { return (n + 7) & ~std::size_t(7); }
+
+bool has_suffix(const char* name) {
+    const std::size_t n = std::strlen(name), k = sizeof(kSuffix) - 1;
+    return n > k && name[0] != '.' && std::strcmp(name + n - k, kSuffix) == 0;
+}
+
+bool write_all(int fd, const void* data, std::size_t n) {
+    const char* p = static_cast<const char*>(data);
+    while (n > 0) {
+        const ssize_t k = ::write(fd, p, n);
+        if (k < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += k;
+        n -= static_cast<std::size_t>(k);
+    }
+    return true;
+}
+
+}  // namespace
+
+CacheEntry& CacheEntry::operator=(CacheEntry&& o) noexcept {
+    if (this != &o) {
+        reset();
+        base_ = o.base_;
+        size_ = o.size_;
+        payload_ = o.payload_;
+        n_records_ = o.n_records_;
+        n_fields_ = o.n_fields_;
+        o.base_ = nullptr;
+        o.size_ = 0;
+    }
+    return *this;
+}
+
+bool CacheEntry::map(const std::string& path) {
+    reset();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < off_t(kCacheHeaderSize + kBinaryHeaderSize)) {
+        ::close(fd);
+        return false;
+    }
+    const std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+    base_ = static_cast<char*>(p);
+    size_ = size;
+
+    std::uint32_t key_len = 0;
+    std::memcpy(&key_len, base_ + 8, sizeof(key_len));
+    payload_ = kCacheHeaderSize + padded(key_len);
+    bool ok = std::memcmp(base_, kCacheMagic, sizeof(kCacheMagic)) == 0 &&
+              payload_ + kBinaryHeaderSize <= size_ &&
+              std::memcmp(base_ + payload_, kBinaryMagic, sizeof(kBinaryMagic)) == 0;
+    if (ok) {
+        std::memcpy(&n_fields_, base_ + payload_ + 8, sizeof(n_fields_));
+        const std::size_t rec = std::size_t(n_fields_) * sizeof(double);
+        const std::size_t data = size_ - payload_ - kBinaryHeaderSize;
+        ok = n_fields_ > 0 && data % rec == 0;
+        if (ok) n_records_ = data / rec;
+    }
+    if (!ok) reset();
+    return ok;
+}
+
+void CacheEntry::reset() {
+    if (base_) ::munmap(base_, size_);
+    base_ = nullptr;
+    size_ = payload_ = n_records_ = 0;
+    n_fields_ = 0;
+}
+
+std::string CacheEntry::key() const {
+    if (!base_) return std::string();
+    std::uint32_t key_len = 0;
+    std::memcpy(&key_len, base_ + 8, sizeof(key_len));
+    return std::string(base_ + kCacheHeaderSize, key_len);
+}
+
+ResultCache::ResultCache(std::string dir, std::uint64_t max_bytes, bool verify)
+    : dir_(std::move(dir)), max_bytes_(max_bytes), verify_(verify) {
+    while (dir_.size() > 1 && dir_.back() == '/') dir_.pop_back();
+    if (::mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::system_error(errno, std::generic_category(), "mkdir " + dir_);
+    }
+    if (max_bytes_ > 0) approx_bytes_ = stats().bytes;
+}
+
+std::uint64_t ResultCache::hash(const std::string& key) {
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+std::string ResultCache::path_of(const std::string& key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/%016llx%s", (unsigned long long)hash(key), kSuffix);
+    return dir_ + name;
+}
+
+bool ResultCache::find(const std::string& key, CacheEntry& out) const {
+    const std::string path = path_of(key);
+    if (!out.map(path) || out.key() != key) {
+        out.reset();
+        return false;
+    }
+    // 最終使用時刻を更新する（evict は古いものから消す）
+    ::utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+    return true;
+}
+
+void ResultCache::store(const std::string& key, const double* records, std::size_t n_records,
+                        std::uint32_t n_fields) {
+    const std::string path = path_of(key);
+    std::string tmp = path + ".XXXXXX";
+    const int fd = ::mkstemp(&tmp[0]);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "mkstemp " + tmp);
+
+    unsigned char h[kCacheHeaderSize] = {};
+    std::memcpy(h, kCacheMagic, sizeof(kCacheMagic));
+    const std::uint32_t key_len = static_cast<std::uint32_t>(key.size());
+    std::memcpy(h + 8, &key_len, sizeof(key_len));
+    unsigned char bh[kBinaryHeaderSize] = {};
+    std::memcpy(bh, kBinaryMagic, sizeof(kBinaryMagic));
+    std::memcpy(bh + 8, &n_fields, sizeof(n_fields));
+    const char zeros[8] = {};
+    const std::size_t data = n_records * n_fields * sizeof(double);
+
+    const bool ok = write_all(fd, h, sizeof(h)) && write_all(fd, key.data(), key.size()) &&
+                    write_all(fd, zeros, padded(key.size()) - key.size()) &&
+                    write_all(fd, bh, sizeof(bh)) && write_all(fd, records, data) &&
+                    ::fchmod(fd, 0644) == 0;
+    const int err = errno;
+    ::close(fd);
+    if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0) {
+        ::unlink(tmp.c_str());
+        throw std::system_error(ok ? errno : err, std::generic_category(), "store " + path);
+    }
+
+    if (max_bytes_ == 0) return;
+    std::lock_guard<std::mutex> lock(mu_);
+    approx_bytes_ += sizeof(h) + padded(key.size()) + sizeof(bh) + data;
+    if (approx_bytes_ > max_bytes_) {
+        evict(max_bytes_ / 4 * 3);
+        approx_bytes_ = stats().bytes;
+    }
+}
+
+void ResultCache::for_each(const std::function<void(const std::string& path)>& f) const {
+    DIR* d = ::opendir(dir_.c_str());
+    if (!d) return;
+    while (const dirent* e = ::readdir(d)) {
+        if (has_suffix(e->d_name)) f(dir_ + "/" + e->d_name);
+    }
+    ::closedir(d);
+}
+
+ResultCache::Stats ResultCache::stats() const {
+    Stats s;
+    for_each([&](const std::string& path) {
+        struct stat st;
+        if (::stat(path.c_str(), &st) == 0) {
+            s.entries++;
+            s.bytes += static_cast<std::uint64_t>(st.st_size);
+        }
+    });
+    return s;
+}
+
+std::uint64_t ResultCache::evict(std::uint64_t max_bytes) {
+    struct File {
+        std::string path;
+        timespec mtime;
+        std::uint64_t size;
+    };
+    std::vector<File> files;
+    std::uint64_t total = 0;
+    for_each([&](const std::string& path) {
+        struct stat st;
+        if (::stat(path.c_str(), &st) == 0) {
+            files.push_back({path, st.st_mtim, static_cast<std::uint64_t>(st.st_size)});
+            total += files.back().size;
+        }
+    });
+    std::sort(files.begin(), files.end(), [](const File& a, const File& b) {
+        return a.mtime.tv_sec != b.mtime.tv_sec ? a.mtime.tv_sec < b.mtime.tv_sec
+                                                : a.mtime.tv_nsec < b.mtime.tv_nsec;
+    });
+    std::uint64_t removed = 0;
+    for (const File& f : files) {
+        if (total - removed <= max_bytes) break;
+        if (::unlink(f.path.c_str()) == 0) removed += f.size;
+    }
+    return removed;
+}
+
+}  // namespace itphys
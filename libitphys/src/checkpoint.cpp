@@ -0,0 +1,218 @@
+/*
+ * checkpoint.cpp
+ *
+ * 計算の途中の状態の保存と復元（itphys/checkpoint.hpp を参照）
+ */
+
+#include "itphys/checkpoint.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "itphys/cache.hpp"
+
+namespace itphys {
+
+namespace {
+
+constexpr char kCheckpointMagic[8] = {'I', 'T', 'P', 'H', 'Y', 'S', 'K', '1'};
+
+void append(std::string& out, const void* p, std::size_t n) {
+    out.append(static_cast<const char*>(p), n);
+}
+
+/** (n, mean, m2) を3つの double として保存する */
+struct Moments {
+    double n, mean, m2;
+};
+
+Moments to_moments(const RunningStats& s) { return Moments{s.count(), s.mean(), s.m2()}; }
+RunningStats from_moments(const Moments& m) { return RunningStats::from_moments(m.n, m.mean, m.m2); }
+
+}  // namespace
+
+const std::string& Checkpoint::get_bytes(const std::string& name) const {
+    const auto it = sections_.find(name);
+    if (it == sections_.end()) throw std::runtime_error("checkpoint: missing section " + name);
+    return it->second;
+}
+
+void Checkpoint::save(const std::string& path) const {
+    std::string buf;
+    append(buf, kCheckpointMagic, sizeof(kCheckpointMagic));
+    const std::uint32_t version = kEngineVersion;
+    const std::uint32_t n = static_cast<std::uint32_t>(sections_.size());
+    append(buf, &version, sizeof(version));
+    append(buf, &n, sizeof(n));
+    for (const auto& kv : sections_) {
+        const std::uint32_t name_len = static_cast<std::uint32_t>(kv.first.size());
+        const std::uint32_t reserved = 0;
+        const std::uint64_t size = kv.second.size();
+        append(buf, &name_len, sizeof(name_len));
+        append(buf, &reserved, sizeof(reserved));
+        append(buf, &size, sizeof(size));
+        buf += kv.first;
+        buf += kv.second;
+    }
+
+    const std::string tmp = path + ".tmp";
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "open " + tmp);
+    const char* p = buf.data();
+    std::size_t left = buf.size();
+    while (left > 0) {
+        const ssize_t k = ::write(fd, p, left);
+        if (k < 0 && errno == EINTR) continue;
+        if (k < 0) {
+            const int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "write " + tmp);
+        }
+        p += k;
+        left -= static_cast<std::size_t>(k);
+    }
+    if (::fsync(fd) != 0 || ::close(fd) != 0) {
+        throw std::system_error(errno, std::generic_category(), "fsync " + tmp);
+    }
+    if (::rename(tmp.c_str(), path.c_str()) != 0) {
+        throw std::system_error(errno, std::generic_category(), "rename " + path);
+    }
+}
+
+Checkpoint Checkpoint::load(const std::string& path) {
+    std::FILE* fp = std::fopen(path.c_str(), "rb");
+    if (!fp) throw std::system_error(errno, std::generic_category(), "open " + path);
+    std::string buf;
+    char chunk[1 << 16];
+    std::size_t k;
+    while ((k = std::fread(chunk, 1, sizeof(chunk), fp)) > 0) buf.append(chunk, k);
+    std::fclose(fp);
+
+    const auto bad = [&](const char* what) {
+        return std::runtime_error("checkpoint " + path + ": " + what);
+    };
+    std::size_t pos = 0;
+    const auto read = [&](void* out, std::size_t n) {
+        if (pos + n > buf.size()) throw bad("truncated");
+        std::memcpy(out, buf.data() + pos, n);
+        pos += n;
+    };
+    char magic[8];
+    std::uint32_t version = 0, n = 0;
+    read(magic, sizeof(magic));
+    if (std::memcmp(magic, kCheckpointMagic, sizeof(magic)) != 0) throw bad("not a checkpoint");
+    read(&version, sizeof(version));
+    if (version != kEngineVersion) throw bad("written by a different engine version");
+    read(&n, sizeof(n));
+
+    Checkpoint ck;
+    for (std::uint32_t i = 0; i < n; i++) {
+        std::uint32_t name_len = 0, reserved = 0;
+        std::uint64_t size = 0;
+        read(&name_len, sizeof(name_len));
+        read(&reserved, sizeof(reserved));
+        read(&size, sizeof(size));
+        if (pos + name_len + size > buf.size()) throw bad("truncated");
+        std::string name = buf.substr(pos, name_len);
+        pos += name_len;
+        ck.sections_[name] = buf.substr(pos, size);
+        pos += size;
+    }
+    return ck;
+}
+
+void save_state(Checkpoint& ck, const std::string& prefix, const NormalRng& rng) {
+    const NormalRng::State s = rng.state();
+    ck.put(prefix + ".engine", s.engine);
+    ck.put(prefix + ".spare", s.spare);
+    ck.put(prefix + ".has_spare", static_cast<unsigned char>(s.has_spare));
+}
+
+void load_state(const Checkpoint& ck, const std::string& prefix, NormalRng& rng) {
+    NormalRng::State s;
+    s.engine = ck.get<std::array<std::uint64_t, 4>>(prefix + ".engine");
+    s.spare = ck.get<double>(prefix + ".spare");
+    s.has_spare = ck.get<unsigned char>(prefix + ".has_spare") != 0;
+    rng.set_state(s);
+}
+
+void save_state(Checkpoint& ck, const std::string& prefix, const Ensemble& e) {
+    ck.put(prefix + ".t", e.t);
+    ck.put(prefix + ".x", e.x);
+    ck.put(prefix + ".y", e.y);
+    ck.put(prefix + ".vx", e.vx);
+    ck.put(prefix + ".vy", e.vy);
+}
+
+void load_state(const Checkpoint& ck, const std::string& prefix, Ensemble& e) {
+    e.t = ck.get<double>(prefix + ".t");
+    e.x = ck.get_vector<double>(prefix + ".x");
+    e.y = ck.get_vector<double>(prefix + ".y");
+    e.vx = ck.get_vector<double>(prefix + ".vx");
+    e.vy = ck.get_vector<double>(prefix + ".vy");
+    if (e.y.size() != e.x.size() || e.vx.size() != e.x.size() || e.vy.size() != e.x.size()) {
+        throw std::runtime_error("checkpoint: inconsistent ensemble " + prefix);
+    }
+}
+
+void save_state(Checkpoint& ck, const std::string& prefix, const MsdAccumulator& msd) {
+    std::vector<double> t(msd.size());
+    std::vector<Moments> r2(msd.size());
+    for (std::size_t i = 0; i < msd.size(); i++) {
+        t[i] = msd.time(i);
+        r2[i] = to_moments(msd.at(i));
+    }
+    ck.put(prefix + ".t", t);
+    ck.put(prefix + ".r2", r2);
+    ck.put(prefix + ".cursor", static_cast<std::uint64_t>(msd.cursor()));
+}
+
+void load_state(const Checkpoint& ck, const std::string& prefix, MsdAccumulator& msd) {
+    const std::vector<double> t = ck.get_vector<double>(prefix + ".t");
+    const std::vector<Moments> r2 = ck.get_vector<Moments>(prefix + ".r2");
+    if (t.size() != msd.size() || r2.size() != msd.size()) {
+        throw std::runtime_error("checkpoint: size mismatch of " + prefix);
+    }
+    for (std::size_t i = 0; i < msd.size(); i++) msd.set(i, t[i], from_moments(r2[i]));
+    msd.set_cursor(static_cast<std::size_t>(ck.get<std::uint64_t>(prefix + ".cursor")));
+}
+
+void save_state(Checkpoint& ck, const std::string& prefix, const EnergyHistogram& hist) {
+    std::vector<unsigned long long> counts(hist.n_bins());
+    for (std::size_t i = 0; i < counts.size(); i++) counts[i] = hist.count(i);
+    ck.put(prefix + ".mass", hist.mass());
+    ck.put(prefix + ".e_max", hist.e_max());
+    ck.put(prefix + ".counts", counts);
+    ck.put(prefix + ".overflow", hist.overflow());
+    ck.put(prefix + ".stats", to_moments(hist.stats()));
+    const BlockingStats& b = hist.blocking();
+    std::vector<Moments> levels(b.n_levels());
+    for (std::size_t l = 0; l < levels.size(); l++) levels[l] = to_moments(b.level(l));
+    ck.put(prefix + ".blocking", levels);
+    ck.put(prefix + ".blocking_pending", b.pending());
+}
+
+void load_state(const Checkpoint& ck, const std::string& prefix, EnergyHistogram& hist) {
+    const double mass = ck.get<double>(prefix + ".mass");
+    const double e_max = ck.get<double>(prefix + ".e_max");
+    const auto counts = ck.get_vector<unsigned long long>(prefix + ".counts");
+    hist = EnergyHistogram(mass, e_max, counts.size());
+    hist.set_state(counts, ck.get<unsigned long long>(prefix + ".overflow"),
+                   from_moments(ck.get<Moments>(prefix + ".stats")));
+    // ブロッキング解析を入れる前のチェックポイントには無い（続きの標本だけで解析する）
+    if (ck.has(prefix + ".blocking")) {
+        const std::vector<Moments> m = ck.get_vector<Moments>(prefix + ".blocking");
+        std::vector<RunningStats> levels(m.size());
+        for (std::size_t l = 0; l < m.size(); l++) levels[l] = from_moments(m[l]);
+        BlockingStats b;
+        b.set_state(levels, ck.get_vector<double>(prefix + ".blocking_pending"));
+        hist.set_blocking(b);
+    }
+}
+
+}  // namespace itphys
@@ -0,0 +1,482 @@
+/*
+ * ensemble.cpp
+ *
+ * 独立な多数の粒子の並列計算（itphys/ensemble.hpp を参照）
+ */
+
+#include "itphys/ensemble.hpp"
+#include "itphys/instrument.hpp"
+
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace itphys {
+
+namespace {
+
+constexpr std::size_t kBlock = EulerIntegrator::kNoiseBlock;
+
+int thread_id() {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+/** スレッドごとの集計（最後に obs / hist へまとめる） */
+struct LocalObservables {
+    LocalObservables(std::size_t n_times, const EnergyHistogram* hist, std::size_t n_reduced = 0)
+        : obs(n_times),
+          hist(hist ? new EnergyHistogram(hist->empty_copy()) : nullptr),
+          units(n_reduced),
+          blocks(n_reduced) {}
+
+    EnsembleObservables obs;
+    std::unique_ptr<EnergyHistogram> hist;
+    // 分散低減: 各時刻の (r², 制御変量) の標本（対の平均）ごと・ブロックの平均ごとの統計
+    std::vector<CovarianceStats> units;
+    std::vector<CovarianceStats> blocks;
+};
+
+/** 粒子 i の |r|²（全成分の和、float のときは補償項を足した位置で） */
+template <int Dim, class Real>
+inline double r2(const ParticleBlock<Dim, Real>& s, std::size_t i) {
+    double x = load_position(s, 0, i);
+    double sum = x * x;
+    for (int d = 1; d < Dim; d++) {
+        x = load_position(s, d, i);
+        sum += x * x;
+    }
+    return sum;
+}
+
+/** 粒子 i の |v|² */
+template <int Dim, class Real>
+inline double v2(const ParticleBlock<Dim, Real>& s, std::size_t i) {
+    double v = s.v[0][i];
+    double sum = v * v;
+    for (int d = 1; d < Dim; d++) {
+        v = s.v[d][i];
+        sum += v * v;
+    }
+    return sum;
+}
+
+/**
+ * b 粒子の r² と運動エネルギーの統計を時刻の添字 it に加える
+ * ブロック内は2パスで平均と偏差平方和を求め、RunningStats::merge で足し合わせる
+ * ブロックの平均の運動エネルギーは、そのブロックだけの系列 series に時刻の順に足す（hist があるとき）
+ */
+template <int Dim, class Real>
+void observe_block(const ParticleBlock<Dim, Real>& s, std::size_t b, double m, std::size_t it, double t,
+                   LocalObservables& local, BlockingStats* series) {
+    ITPHYS_PHASE(kObserve);
+    double sr = 0.0, sv = 0.0;
+    for (std::size_t i = 0; i < b; i++) {
+        sr += r2(s, i);
+        sv += v2(s, i);
+    }
+    const double mr = sr / b;
+    const double mv = sv / b;
+    double m2r = 0.0, m2v = 0.0;
+    for (std::size_t i = 0; i < b; i++) {
+        const double dr = r2(s, i) - mr;
+        const double dv = v2(s, i) - mv;
+        m2r += dr * dr;
+        m2v += dv * dv;
+    }
+    local.obs.msd.add(it, t, RunningStats::from_moments(b, mr, m2r));
+    local.obs.energy[it].merge(RunningStats::from_moments(b, 0.5 * m * mv, 0.25 * m * m * m2v));
+    if (local.hist) {
+        for (std::size_t i = 0; i < b; i++) {
+            local.hist->add_independent(0.5 * m * v2(s, i));
+        }
+        series->add(0.5 * m * mv);
+    }
+}
+
+}  // namespace
+
+int max_threads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+namespace {
+
+/** ExactOuIntegrator は外力を取らないので、力のない step_block を直接呼ぶ */
+template <int Dim, class Real, class Integ, class Force>
+inline void step_block(const Integ& integ, const Force& force, const ParticleBlock<Dim, Real>& s, const Real* eta,
+                       std::size_t b) {
+    if constexpr (std::is_same<Force, NoForce>::value) {
+        integ.step_block(s, eta, b);
+    } else {
+        integ.step_block(s, eta, b, force);
+    }
+}
+
+/** 乱数（Rng は NormalRng か UniformNoise）を生成して外力 force の下で b 粒子を1ステップ進める */
+template <int Dim, class Real, class Integ, class Rng, class Force>
+inline void advance_block(const Integ& integ, const Force& force, Rng& rng, const ParticleBlock<Dim, Real>& s,
+                          Real* eta, std::size_t b) {
+    constexpr std::size_t kNoise = Dim * Integ::kNoisePerDim;
+    {
+        ITPHYS_PHASE(kRng);
+        rng.fill(eta, kNoise * b);
+    }
+    {
+        ITPHYS_PHASE(kStep);
+        step_block(integ, force, s, eta, b);
+    }
+    ITPHYS_COUNT(kSteps, b);
+    ITPHYS_COUNT(kSamples, kNoise * b);
+}
+
+template <int Dim, class Integ, class Rng, class Real, class Force>
+int run_ensemble_impl(const LangevinParams& p, const EnsembleOptions& opt, const Force& force,
+                      EnsembleObservables* obs, EnergyHistogram* hist) {
+    constexpr std::size_t kNoise = Dim * Integ::kNoisePerDim;  // 1粒子・1ステップの乱数の個数
+    constexpr int kLo = std::is_same<Real, float>::value ? Dim : 0;  // 位置の補償項の配列の数
+    const Integ integ(p);
+    const std::size_t n = opt.n_particles;
+    const std::size_t n_blocks = (n + kBlock - 1) / kBlock;
+    const std::size_t n_times = static_cast<std::size_t>(p.n_steps) + 1;
+    const bool observe = obs != nullptr || hist != nullptr;
+    const int n_threads = opt.n_threads > 0 ? opt.n_threads : max_threads();
+
+    std::vector<std::unique_ptr<LocalObservables>> locals(n_threads);
+    int used = 1;
+
+    if (opt.schedule == Schedule::kStepMajor) {
+        // 成分ごとに n 個ずつ: r[0], …, r[Dim-1], v[0], …, v[Dim-1]（float なら続けて r_lo[0], …）
+        std::vector<Real> state((2 * Dim + kLo) * n, Real(0));
+        std::vector<Rng> rngs;
+        rngs.reserve(n_blocks);
+        for (std::size_t k = 0; k < n_blocks; k++) rngs.emplace_back(opt.seed, opt.first_stream + k);
+        // ブロックごとの運動エネルギーの系列（ステップごとに別のスレッドが受け持ってもよいように共有する）
+        std::vector<BlockingStats> series(hist ? n_blocks : 0);
+
+#pragma omp parallel num_threads(n_threads)
+        {
+            const int tid = thread_id();
+#ifdef _OPENMP
+#pragma omp single
+            used = omp_get_num_threads();
+#endif
+            if (observe) locals[tid].reset(new LocalObservables(n_times, hist));
+            Real eta[kNoise * kBlock];
+            for (long long s = 0; s <= p.n_steps; s++) {
+#pragma omp for schedule(static)
+                for (std::size_t k = 0; k < n_blocks; k++) {
+                    const std::size_t i0 = k * kBlock;
+                    const std::size_t b = n - i0 < kBlock ? n - i0 : kBlock;
+                    ParticleBlock<Dim, Real> blk;
+                    for (int d = 0; d < Dim; d++) {
+                        blk.r[d] = state.data() + d * n + i0;
+                        blk.v[d] = state.data() + (Dim + d) * n + i0;
+                        blk.r_lo[d] = kLo > 0 ? state.data() + (2 * Dim + d) * n + i0 : nullptr;
+                    }
+                    if (s > 0) advance_block(integ, force, rngs[k], blk, eta, b);
+                    if (observe) {
+                        observe_block(blk, b, p.m, s, s * p.dt, *locals[tid], hist ? &series[k] : nullptr);
+                    }
+                }
+            }
+        }
+        if (hist) {
+            for (const BlockingStats& b : series) hist->merge_series(b);
+        }
+    } else {
+#pragma omp parallel num_threads(n_threads)
+        {
+            const int tid = thread_id();
+#ifdef _OPENMP
+#pragma omp single
+            used = omp_get_num_threads();
+#endif
+            if (observe) locals[tid].reset(new LocalObservables(n_times, hist));
+            Real r[Dim][kBlock], v[Dim][kBlock], lo[kLo > 0 ? kLo : 1][kBlock];
+            Real eta[kNoise * kBlock];
+            ParticleBlock<Dim, Real> blk;
+            for (int d = 0; d < Dim; d++) {
+                blk.r[d] = r[d];
+                blk.v[d] = v[d];
+                blk.r_lo[d] = kLo > 0 ? lo[d] : nullptr;
+            }
+#pragma omp for schedule(static)
+            for (std::size_t k = 0; k < n_blocks; k++) {
+                const std::size_t i0 = k * kBlock;
+                const std::size_t b = n - i0 < kBlock ? n - i0 : kBlock;
+                Rng rng(opt.seed, opt.first_stream + k);
+                for (int d = 0; d < Dim; d++) {
+                    std::fill(r[d], r[d] + b, Real(0));
+                    std::fill(v[d], v[d] + b, Real(0));
+                    if (kLo > 0) std::fill(lo[d], lo[d] + b, Real(0));
+                }
+                BlockingStats series;
+                if (observe) observe_block(blk, b, p.m, 0, 0.0, *locals[tid], &series);
+                for (long long s = 1; s <= p.n_steps; s++) {
+                    advance_block(integ, force, rng, blk, eta, b);
+                    if (observe) observe_block(blk, b, p.m, s, s * p.dt, *locals[tid], &series);
+                }
+                if (locals[tid] && locals[tid]->hist) locals[tid]->hist->merge_series(series);
+            }
+        }
+    }
+
+    // スレッド番号の順にまとめる
+    for (const auto& local : locals) {
+        if (!local) continue;
+        if (obs) obs->merge(local->obs);
+        if (hist && local->hist) hist->merge(*local->hist);
+    }
+    return used;
+}
+
+/** n_slots × b 個の乱数を作る（分散低減の指定に従って層別にし、後半を符号反転する） */
+void draw_noise(NormalRng& rng, double* eta, std::size_t n_slots, std::size_t b,
+                const VarianceReduction& vr) {
+    ITPHYS_PHASE(kRng);
+    const std::size_t m = vr.antithetic ? (b + 1) / 2 : b;
+    for (std::size_t slot = 0; slot < n_slots; slot++) {
+        double* e = eta + slot * b;
+        if (vr.stratified) {
+            stratified_normals(rng.engine(), e, m);
+        } else {
+            rng.fill(e, m);
+        }
+        for (std::size_t i = m; i < b; i++) e[i] = -e[i - m];
+    }
+    ITPHYS_COUNT(kSamples, n_slots * m);
+}
+
+/**
+ * b 粒子の r²（y）と制御変量の r²（c）を、標本（antithetic なら対の平均）ごとと
+ * ブロックの平均として時刻の添字 it に加える
+ */
+void observe_reduced(const double* r2, const double* c, std::size_t b, bool antithetic, std::size_t it,
+                     LocalObservables& local) {
+    ITPHYS_PHASE(kObserve);
+    const std::size_t m = antithetic ? (b + 1) / 2 : b;
+    double u[kBlock], v[kBlock];
+    double su = 0.0, sv = 0.0;
+    for (std::size_t j = 0; j < m; j++) {
+        const bool pair = antithetic && j + m < b;
+        u[j] = pair ? 0.5 * (r2[j] + r2[j + m]) : r2[j];
+        v[j] = pair ? 0.5 * (c[j] + c[j + m]) : c[j];
+        su += u[j];
+        sv += v[j];
+    }
+    const double mu = su / m, mv = sv / m;
+    double m2u = 0.0, m2v = 0.0, cuv = 0.0;
+    for (std::size_t j = 0; j < m; j++) {
+        m2u += (u[j] - mu) * (u[j] - mu);
+        m2v += (v[j] - mv) * (v[j] - mv);
+        cuv += (u[j] - mu) * (v[j] - mv);
+    }
+    local.units[it].merge(CovarianceStats::from_moments(m, mu, mv, m2u, m2v, cuv));
+    double sy = 0.0, sc = 0.0;
+    for (std::size_t i = 0; i < b; i++) {
+        sy += r2[i];
+        sc += c[i];
+    }
+    local.blocks[it].add(sy / b, sc / b);
+}
+
+/**
+ * 分散低減を使う run_ensemble（ブロックごとに全ステップ）
+ * 制御変量の影の粒子は ExactOuIntegrator で、x, y の速度の乱数を本体と共有する
+ * （本体が ExactOuIntegrator なら影は本体と同じになるので、本体の r² をそのまま使う）
+ */
+template <class Integ, class Force>
+int run_ensemble_reduced(const LangevinParams& p, const EnsembleOptions& opt, const Force& force,
+                         EnsembleObservables* obs, EnergyHistogram* hist) {
+    constexpr bool kExact = std::is_same<Integ, ExactOuIntegrator>::value;
+    const VarianceReduction& vr = opt.variance_reduction;
+    const bool shadow = vr.control_variate && !kExact;
+    // 本体の乱数の後に、影の位置だけの乱数（ExactOuIntegrator の eta2）を x, y の順に置く
+    const std::size_t n_slots = 2 * Integ::kNoisePerDim + (shadow ? 2 : 0);
+    const Integ integ(p);
+    const ExactOuIntegrator exact(p);
+    const std::size_t n = opt.n_particles;
+    const std::size_t n_blocks = (n + kBlock - 1) / kBlock;
+    const std::size_t n_times = static_cast<std::size_t>(p.n_steps) + 1;
+    const int n_threads = opt.n_threads > 0 ? opt.n_threads : max_threads();
+
+    std::vector<std::unique_ptr<LocalObservables>> locals(n_threads);
+    int used = 1;
+#pragma omp parallel num_threads(n_threads)
+    {
+        const int tid = thread_id();
+#ifdef _OPENMP
+#pragma omp single
+        used = omp_get_num_threads();
+#endif
+        locals[tid].reset(new LocalObservables(n_times, hist, obs ? n_times : 0));
+        LocalObservables& local = *locals[tid];
+        double x[kBlock], y[kBlock], vx[kBlock], vy[kBlock];
+        const ParticleBlock<2> blk{{x, y}, {vx, vy}};
+        double sx[kBlock], sy[kBlock], svx[kBlock], svy[kBlock];
+        double r2[kBlock], c[kBlock];
+        std::vector<double> eta(n_slots * kBlock);
+        BlockingStats series;  // 今のブロックの運動エネルギーの系列
+        const auto observe = [&](std::size_t b, std::size_t it) {
+            if (!obs && !hist) return;
+            observe_block(blk, b, p.m, it, it * p.dt, local, &series);
+            if (!obs) return;
+            for (std::size_t i = 0; i < b; i++) {
+                r2[i] = x[i] * x[i] + y[i] * y[i];
+                c[i] = shadow ? sx[i] * sx[i] + sy[i] * sy[i] : r2[i];
+            }
+            observe_reduced(r2, c, b, vr.antithetic, it, local);
+        };
+#pragma omp for schedule(static)
+        for (std::size_t k = 0; k < n_blocks; k++) {
+            const std::size_t i0 = k * kBlock;
+            const std::size_t b = n - i0 < kBlock ? n - i0 : kBlock;
+            NormalRng rng(opt.seed, opt.first_stream + k);
+            for (std::size_t i = 0; i < b; i++) {
+                x[i] = y[i] = vx[i] = vy[i] = 0.0;
+                sx[i] = sy[i] = svx[i] = svy[i] = 0.0;
+            }
+            series = BlockingStats();
+            observe(b, 0);
+            for (long long s = 1; s <= p.n_steps; s++) {
+                draw_noise(rng, eta.data(), n_slots, b, vr);
+                {
+                    ITPHYS_PHASE(kStep);
+                    step_block(integ, force, blk, eta.data(), b);
+                    if (shadow) {
+                        const double* ex = eta.data();
+                        const double* ey = ex + b;
+                        const double* ex2 = ex + (n_slots - 2) * b;
+                        const double* ey2 = ex + (n_slots - 1) * b;
+                        for (std::size_t i = 0; i < b; i++) {
+                            exact.step(sx[i], svx[i], ex[i], ex2[i]);
+                            exact.step(sy[i], svy[i], ey[i], ey2[i]);
+                        }
+                    }
+                }
+                ITPHYS_COUNT(kSteps, b);
+                observe(b, static_cast<std::size_t>(s));
+            }
+            if (local.hist) local.hist->merge_series(series);
+        }
+    }
+
+    // スレッド番号の順にまとめる
+    std::vector<CovarianceStats> units(obs ? n_times : 0), blocks(obs ? n_times : 0);
+    for (const auto& local : locals) {
+        if (!local) continue;
+        if (obs) {
+            obs->merge(local->obs);
+            for (std::size_t i = 0; i < n_times; i++) {
+                units[i].merge(local->units[i]);
+                blocks[i].merge(local->blocks[i]);
+            }
+        }
+        if (hist && local->hist) hist->merge(*local->hist);
+    }
+    if (!obs) return used;
+
+    // 推定値 ⟨r²⟩ - β(⟨c⟩ - E[c]) とその分散（β は標本ごとの Cov/Var）
+    obs->msd_reduced.assign(n_times, ReducedEstimate());
+    for (std::size_t i = 0; i < n_times && i < obs->msd.size(); i++) {
+        const CovarianceStats& u = units[i];
+        const double beta = vr.control_variate && u.var_y() > 0.0 ? u.cov() / u.var_y() : 0.0;
+        const double expected = theoretical_msd_from_rest(i * p.dt, p);
+        const auto residual_var = [beta](const CovarianceStats& s) {
+            return std::max(0.0, s.var_x() - 2.0 * beta * s.cov() + beta * beta * s.var_y());
+        };
+        double var;
+        if (vr.stratified) {
+            var = blocks[i].count() > 1.0 ? residual_var(blocks[i]) / blocks[i].count()
+                                          : std::numeric_limits<double>::quiet_NaN();
+        } else {
+            var = u.count() > 1.0 ? residual_var(u) / u.count() : 0.0;
+        }
+        const RunningStats& plain = obs->msd.at(i);
+        const double plain_var = plain.count() > 0.0 ? plain.variance() / plain.count() : 0.0;
+        ReducedEstimate& r = obs->msd_reduced[i];
+        r.mean = u.mean_x() - beta * (u.mean_y() - expected);
+        r.std_error = std::sqrt(var);
+        r.factor = plain_var > 0.0 ? plain_var / var : 1.0;
+    }
+    return used;
+}
+
+/**
+ * 次元 Dim・積分器 Integ・乱数 Rng・精度 Real で、opt.force の項の組み合わせごとにインスタンス化した
+ * run_ensemble を呼ぶ（ExactOuIntegrator は力なしだけ、分散低減は2次元・正規乱数・double だけ）
+ */
+template <int Dim, class Integ, class Rng, class Real>
+int run_ensemble_with(const LangevinParams& p, const EnsembleOptions& opt, EnsembleObservables* obs,
+                      EnergyHistogram* hist) {
+    const auto run = [&](const auto& force) {
+        if constexpr (Dim == 2 && std::is_same<Rng, NormalRng>::value && std::is_same<Real, double>::value) {
+            if (opt.variance_reduction.any()) return run_ensemble_reduced<Integ>(p, opt, force, obs, hist);
+        }
+        return run_ensemble_impl<Dim, Integ, Rng, Real>(p, opt, force, obs, hist);
+    };
+    if constexpr (std::is_same<Integ, ExactOuIntegrator>::value) {
+        return run(NoForce());
+    } else {
+        return visit_force(opt.force, run);
+    }
+}
+
+template <int Dim, class Integ, class Real>
+int run_ensemble_noise(const LangevinParams& p, const EnsembleOptions& opt, EnsembleObservables* obs,
+                       EnergyHistogram* hist) {
+    if (opt.noise == Noise::kUniform) return run_ensemble_with<Dim, Integ, UniformNoise, Real>(p, opt, obs, hist);
+    return run_ensemble_with<Dim, Integ, NormalRng, Real>(p, opt, obs, hist);
+}
+
+template <int Dim, class Integ>
+int run_ensemble_precision(const LangevinParams& p, const EnsembleOptions& opt, EnsembleObservables* obs,
+                           EnergyHistogram* hist) {
+    if (opt.precision == Precision::kMixed) return run_ensemble_noise<Dim, Integ, float>(p, opt, obs, hist);
+    return run_ensemble_noise<Dim, Integ, double>(p, opt, obs, hist);
+}
+
+template <int Dim>
+int run_ensemble_dim(const LangevinParams& p, const EnsembleOptions& opt, EnsembleObservables* obs,
+                     EnergyHistogram* hist) {
+    switch (opt.integrator) {
+        case Integrator::kBaoab: return run_ensemble_precision<Dim, BaoabIntegrator>(p, opt, obs, hist);
+        case Integrator::kExactOu: return run_ensemble_precision<Dim, ExactOuIntegrator>(p, opt, obs, hist);
+        default: return run_ensemble_precision<Dim, EulerIntegrator>(p, opt, obs, hist);
+    }
+}
+
+}  // namespace
+
+int run_ensemble(const LangevinParams& p, const EnsembleOptions& opt, EnsembleObservables* obs,
+                 EnergyHistogram* hist) {
+    if (opt.integrator == Integrator::kExactOu && opt.force.any()) {
+        throw std::invalid_argument("run_ensemble: exact_ou has no external force");
+    }
+    if (opt.dim < 1 || opt.dim > 3) throw std::invalid_argument("run_ensemble: dim must be 1, 2 or 3");
+    if (opt.variance_reduction.any() &&
+        (opt.dim != 2 || opt.noise != Noise::kGaussian || opt.precision != Precision::kDouble)) {
+        throw std::invalid_argument("run_ensemble: variance reduction needs dim 2, gaussian noise and double precision");
+    }
+    // 次元 × 積分器 × 精度 × ノイズ × 外力の組み合わせをここで一度だけ選ぶ
+    switch (opt.dim) {
+        case 1: return run_ensemble_dim<1>(p, opt, obs, hist);
+        case 3: return run_ensemble_dim<3>(p, opt, obs, hist);
+        default: return run_ensemble_dim<2>(p, opt, obs, hist);
+    }
+}
+
+}  // namespace itphys
@@ -0,0 +1,223 @@
+/*
+ * first_passage.cpp
+ *
+ * 初通過時間の分布（itphys/first_passage.hpp を参照）
+ */
+
+#include "itphys/first_passage.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "itphys/ensemble.hpp"
+#include "itphys/instrument.hpp"
+#include "itphys/rng.hpp"
+
+namespace itphys {
+
+namespace {
+
+constexpr std::size_t kBlock = EulerIntegrator::kNoiseBlock;
+
+/** k Δt < t_max となる最大のステップ数 k（これより後に吸収されるものは打ち切り） */
+long long last_step(double t_max, double dt) {
+    return static_cast<long long>(std::ceil(t_max / dt * (1.0 - 1e-12))) - 1;
+}
+
+/** 1ブロック分のレーンの状態と集計 */
+struct Lanes {
+    double x[kBlock], y[kBlock], vx[kBlock], vy[kBlock];
+    long long birth[kBlock];      // 粒子を入れたステップ
+    unsigned char hit[kBlock];    // このステップで吸収条件を満たしたか
+    double eta[2 * kBlock];
+
+    std::vector<unsigned long long> counts;
+    unsigned long long censored = 0;
+    unsigned long long lane_steps = 0;
+    RunningStats times;
+};
+
+struct Setup {
+    const EulerIntegrator& integ;
+    const FptOptions& opt;
+    double dt;
+    long long last;  // このステップ数までに吸収されなければ打ち切り
+    double bin_width;
+};
+
+/** レーン [0, b) の吸収条件を hit に書き、満たしたレーンの数を返す（分岐のないループ） */
+std::size_t check_hits(const Setup& s, Lanes& l, std::size_t b) {
+    std::size_t n_hit = 0;
+    const double th = s.opt.threshold;
+    if (s.opt.condition == FptCondition::kRadius) {
+        const double r2 = th * th;
+        for (std::size_t i = 0; i < b; i++) {
+            const unsigned char h = l.x[i] * l.x[i] + l.y[i] * l.y[i] >= r2;
+            l.hit[i] = h;
+            n_hit += h;
+        }
+    } else {
+        for (std::size_t i = 0; i < b; i++) {
+            const unsigned char h = l.x[i] >= th;
+            l.hit[i] = h;
+            n_hit += h;
+        }
+    }
+    return n_hit;
+}
+
+void start_walker(const Setup& s, Lanes& l, std::size_t i, long long step) {
+    l.x[i] = s.opt.start_x;
+    l.y[i] = s.opt.start_y;
+    l.vx[i] = 0.0;
+    l.vy[i] = 0.0;
+    l.birth[i] = step;
+}
+
+void record(const Setup& s, Lanes& l, long long age) {
+    const double t = age * s.dt;
+    l.times.add(t);
+    l.counts[std::min(l.counts.size() - 1, static_cast<std::size_t>(t / s.bin_width))]++;
+}
+
+/** 積分器で使用中のレーン [0, b) を1ステップ進める */
+template <class Force>
+void advance(const Setup& s, const Force& force, NormalRng& rng, Lanes& l, std::size_t b) {
+    {
+        ITPHYS_PHASE(kRng);
+        rng.fill(l.eta, 2 * b);
+    }
+    ITPHYS_PHASE(kStep);
+    s.integ.step_block(ParticleBlock<2>{{l.x, l.y}, {l.vx, l.vy}}, l.eta, b, force);
+    l.lane_steps += b;
+    ITPHYS_COUNT(kSteps, b);
+    ITPHYS_COUNT(kSamples, 2 * b);
+}
+
+/** 吸収されたレーンにすぐ次の粒子を入れ、入れる粒子がなくなったら使用中のレーンを前に詰める */
+template <class Force>
+void run_block_refill(const Setup& s, const Force& force, NormalRng& rng, Lanes& l, std::size_t n_walkers) {
+    std::size_t active = std::min(kBlock, n_walkers);
+    std::size_t next = active;  // 次に入れる粒子の番号
+    for (std::size_t i = 0; i < active; i++) start_walker(s, l, i, 0);
+    long long oldest = 0;  // 使用中のレーンの birth の最小値
+    for (long long step = 1; active > 0; step++) {
+        advance(s, force, rng, l, active);
+        const std::size_t n_hit = check_hits(s, l, active);
+        if (n_hit == 0 && step - oldest < s.last) continue;
+        // 後ろから見るので、詰めるときに移してくるレーンはもう調べてある
+        for (std::size_t i = active; i-- > 0;) {
+            const long long age = step - l.birth[i];
+            if (!l.hit[i] && age < s.last) continue;
+            if (l.hit[i]) {
+                record(s, l, age);
+            } else {
+                l.censored++;
+            }
+            if (next < n_walkers) {
+                start_walker(s, l, i, step);
+                next++;
+            } else {
+                active--;
+                l.x[i] = l.x[active];
+                l.y[i] = l.y[active];
+                l.vx[i] = l.vx[active];
+                l.vy[i] = l.vy[active];
+                l.birth[i] = l.birth[active];
+            }
+        }
+        oldest = step;
+        for (std::size_t i = 0; i < active; i++) oldest = std::min(oldest, l.birth[i]);
+    }
+}
+
+/** 比較用: b 個ずつ一斉に始め、全員が吸収されるまで全レーンを進める */
+template <class Force>
+void run_block_mask(const Setup& s, const Force& force, NormalRng& rng, Lanes& l, std::size_t n_walkers) {
+    unsigned char done[kBlock];
+    for (std::size_t first = 0; first < n_walkers; first += kBlock) {
+        const std::size_t b = std::min(kBlock, n_walkers - first);
+        for (std::size_t i = 0; i < b; i++) {
+            start_walker(s, l, i, 0);
+            done[i] = 0;
+        }
+        std::size_t remaining = b;
+        for (long long step = 1; remaining > 0 && step <= s.last; step++) {
+            advance(s, force, rng, l, b);
+            if (check_hits(s, l, b) == 0) continue;
+            for (std::size_t i = 0; i < b; i++) {
+                if (l.hit[i] && !done[i]) {
+                    record(s, l, step);
+                    done[i] = 1;
+                    remaining--;
+                }
+            }
+        }
+        l.censored += remaining;
+    }
+}
+
+}  // namespace
+
+double FptResult::density_error(std::size_t i) const {
+    if (walkers == 0) return 0.0;
+    const double n = static_cast<double>(walkers);
+    const double p = counts[i] / n;
+    return std::sqrt(n * p * (1.0 - p)) / (n * bin_width());
+}
+
+double FptResult::lane_utilization(double dt) const {
+    if (lane_steps == 0) return 0.0;
+    const double useful = times.mean() * times.count() / dt + static_cast<double>(censored) * last_step(t_max, dt);
+    return useful / lane_steps;
+}
+
+FptResult run_first_passage(const LangevinParams& p, const FptOptions& opt) {
+    if (opt.n_walkers == 0 || opt.n_bins == 0 || !(opt.t_max > 0.0) || !(p.dt > 0.0)) {
+        throw std::invalid_argument("first passage: walkers, bins, t_max and dt must be positive");
+    }
+    const double th = opt.threshold;
+    if (opt.condition == FptCondition::kRadius
+            ? !(th > 0.0) || opt.start_x * opt.start_x + opt.start_y * opt.start_y >= th * th
+            : !(opt.start_x < th)) {
+        throw std::invalid_argument("first passage: the start point already satisfies the absorbing condition");
+    }
+    const EulerIntegrator integ(p);
+    const Setup setup{integ, opt, p.dt, last_step(opt.t_max, p.dt), opt.t_max / opt.n_bins};
+    if (setup.last < 1) throw std::invalid_argument("first passage: t_max must be longer than dt");
+
+    // 粒子をブロックに番号順に均等に割り当てる
+    const std::size_t n_blocks = std::min((std::max<std::size_t>(opt.n_lanes, 1) + kBlock - 1) / kBlock,
+                                          (opt.n_walkers + kBlock - 1) / kBlock);
+    std::vector<Lanes> blocks(n_blocks);
+    for (Lanes& l : blocks) l.counts.assign(opt.n_bins, 0);
+    const int n_threads = opt.n_threads > 0 ? opt.n_threads : max_threads();
+    visit_force(opt.force, [&](const auto& force) {
+        // 吸収までの時間は粒子ごとにばらつくので、ブロックは空いたスレッドから取る
+#pragma omp parallel for num_threads(n_threads) schedule(dynamic, 1)
+        for (std::size_t k = 0; k < n_blocks; k++) {
+            const std::size_t w = opt.n_walkers / n_blocks + (k < opt.n_walkers % n_blocks ? 1 : 0);
+            NormalRng rng(opt.seed, k);
+            if (opt.lanes == FptLanes::kMask) {
+                run_block_mask(setup, force, rng, blocks[k], w);
+            } else {
+                run_block_refill(setup, force, rng, blocks[k], w);
+            }
+        }
+    });
+
+    FptResult r;
+    r.counts.assign(opt.n_bins, 0);
+    r.t_max = opt.t_max;
+    r.walkers = opt.n_walkers;
+    for (const Lanes& l : blocks) {
+        for (std::size_t i = 0; i < opt.n_bins; i++) r.counts[i] += l.counts[i];
+        r.censored += l.censored;
+        r.lane_steps += l.lane_steps;
+        r.times.merge(l.times);
+    }
+    return r;
+}
+
+}  // namespace itphys
@@ -0,0 +1,122 @@
+/*
+ * force.cpp
+ *
+ * 外部ポテンシャルの指定の読み取り（itphys/force.hpp を参照）
+ */
+
+#include "itphys/force.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+
+namespace itphys {
+
+namespace {
+
+bool parse_value(const std::string& s, double& out) {
+    char* end = nullptr;
+    errno = 0;
+    out = std::strtod(s.c_str(), &end);
+    return !s.empty() && *end == '\0' && errno == 0 && std::isfinite(out);
+}
+
+/** "k=v,k=v" の各組を set(key, value) に渡す。set が false を返すか読めなければ false */
+template <class Set>
+bool parse_args(const std::string& args, Set set) {
+    std::size_t pos = 0;
+    while (pos < args.size()) {
+        const std::size_t end = std::min(args.find(',', pos), args.size());
+        const std::string kv = args.substr(pos, end - pos);
+        const std::size_t eq = kv.find('=');
+        double v = 0.0;
+        if (eq == std::string::npos || !parse_value(kv.substr(eq + 1), v) || !set(kv.substr(0, eq), v)) {
+            return false;
+        }
+        pos = end + 1;
+    }
+    return true;
+}
+
+}  // namespace
+
+bool parse_force_field(const std::string& spec, ForceField& out) {
+    ForceField ff;
+    if (spec == "none") {
+        out = ff;
+        return true;
+    }
+    std::size_t pos = 0;
+    while (pos <= spec.size()) {
+        // 項の区切りは英字が続く '+'（"0x1p+1" のような指数の '+' の後は数字）
+        std::size_t end = spec.find('+', pos);
+        while (end != std::string::npos && !(end + 1 < spec.size() &&
+                                              std::isalpha(static_cast<unsigned char>(spec[end + 1])))) {
+            end = spec.find('+', end + 1);
+        }
+        end = std::min(end, spec.size());
+        const std::string term = spec.substr(pos, end - pos);
+        const std::size_t colon = std::min(term.find(':'), term.size());
+        const std::string name = term.substr(0, colon);
+        const std::string args = colon < term.size() ? term.substr(colon + 1) : std::string();
+        bool ok;
+        if (name == "harmonic" && !ff.harmonic_on) {
+            HarmonicForce& h = ff.harmonic;
+            ff.harmonic_on = true;
+            ok = parse_args(args, [&h](const std::string& k, double v) {
+                if (k == "k") {
+                    h.kx = h.ky = v;
+                } else if (k == "kx") {
+                    h.kx = v;
+                } else if (k == "ky") {
+                    h.ky = v;
+                } else if (k == "x0") {
+                    h.x0 = v;
+                } else if (k == "y0") {
+                    h.y0 = v;
+                } else {
+                    return false;
+                }
+                return true;
+            });
+        } else if (name == "washboard" && !ff.washboard_on) {
+            WashboardForce& w = ff.washboard;
+            ff.washboard_on = true;
+            ok = parse_args(args, [&w](const std::string& k, double v) {
+                if (k == "v0") {
+                    w.v0 = v;
+                } else if (k == "period") {
+                    w.period = v;
+                } else if (k == "tilt") {
+                    w.tilt = v;
+                } else {
+                    return false;
+                }
+                return true;
+            }) && w.period > 0.0;
+        } else if (name == "double_well" && !ff.double_well_on) {
+            DoubleWellForce& d = ff.double_well;
+            ff.double_well_on = true;
+            ok = parse_args(args, [&d](const std::string& k, double v) {
+                if (k == "barrier") {
+                    d.barrier = v;
+                } else if (k == "a") {
+                    d.a = v;
+                } else {
+                    return false;
+                }
+                return true;
+            }) && d.a > 0.0;
+        } else {
+            ok = false;
+        }
+        if (!ok) return false;
+        pos = end + 1;
+    }
+    out = ff;
+    return true;
+}
+
+}  // namespace itphys
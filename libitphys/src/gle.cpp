@@ -0,0 +1,368 @@
+/*
+ * gle.cpp
+ *
+ * 一般化ランジュバン方程式（itphys/gle.hpp を参照）
+ */
+
+#include "itphys/gle.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "itphys/ensemble.hpp"
+#include "itphys/instrument.hpp"
+
+namespace itphys {
+
+namespace {
+
+constexpr std::size_t kBlock = EulerIntegrator::kNoiseBlock;
+
+/** 正方行列 a（m × m、行優先）の指数関数（スケーリングと2乗、テイラー展開 20 次） */
+std::vector<double> matrix_exp(std::vector<double> a, int m) {
+    double norm = 0.0;  // 行和の最大
+    for (int i = 0; i < m; i++) {
+        double s = 0.0;
+        for (int j = 0; j < m; j++) s += std::fabs(a[i * m + j]);
+        norm = std::max(norm, s);
+    }
+    int squarings = 0;
+    while (norm > 0.5) {
+        norm *= 0.5;
+        squarings++;
+    }
+    const double scale = std::ldexp(1.0, -squarings);
+    for (double& v : a) v *= scale;
+
+    const auto multiply = [m](const std::vector<double>& x, const std::vector<double>& y) {
+        std::vector<double> z(static_cast<std::size_t>(m) * m, 0.0);
+        for (int i = 0; i < m; i++) {
+            for (int k = 0; k < m; k++) {
+                const double xik = x[i * m + k];
+                for (int j = 0; j < m; j++) z[i * m + j] += xik * y[k * m + j];
+            }
+        }
+        return z;
+    };
+    std::vector<double> e(static_cast<std::size_t>(m) * m, 0.0), term(e);
+    for (int i = 0; i < m; i++) e[i * m + i] = term[i * m + i] = 1.0;
+    for (int k = 1; k <= 20; k++) {
+        term = multiply(term, a);
+        for (std::size_t i = 0; i < term.size(); i++) {
+            term[i] /= k;
+            e[i] += term[i];
+        }
+    }
+    for (int s = 0; s < squarings; s++) e = multiply(e, e);
+    return e;
+}
+
+/** a x = b を解く（a は m × m、行優先。部分ピボット選択のガウスの消去法） */
+std::vector<double> solve(std::vector<double> a, std::vector<double> b, int m) {
+    for (int c = 0; c < m; c++) {
+        int piv = c;
+        for (int r = c + 1; r < m; r++) {
+            if (std::fabs(a[r * m + c]) > std::fabs(a[piv * m + c])) piv = r;
+        }
+        for (int j = 0; j < m; j++) std::swap(a[c * m + j], a[piv * m + j]);
+        std::swap(b[c], b[piv]);
+        for (int r = c + 1; r < m; r++) {
+            const double f = a[r * m + c] / a[c * m + c];
+            for (int j = c; j < m; j++) a[r * m + j] -= f * a[c * m + j];
+            b[r] -= f * b[c];
+        }
+    }
+    for (int r = m - 1; r >= 0; r--) {
+        for (int j = r + 1; j < m; j++) b[r] -= a[r * m + j] * b[j];
+        b[r] /= a[r * m + r];
+    }
+    return b;
+}
+
+/**
+ * スケールした変数 (v/σ_v, z_k/σ_k) のドリフト行列 A（d/dt x = -A x + ノイズ、(1 + モード数) 次）
+ *   A_00 = γ0/m,  A_0k = -ω_k,  A_k0 = ω_k,  A_kk = 1/τ_k      （ω_k = sqrt(c_k/m)）
+ */
+std::vector<double> drift_matrix(const LangevinParams& p, const MemoryKernel& kernel) {
+    const int m = static_cast<int>(kernel.modes.size()) + 1;
+    std::vector<double> a(static_cast<std::size_t>(m) * m, 0.0);
+    a[0] = p.gamma / p.m;
+    for (int k = 1; k < m; k++) {
+        const PronyMode& mode = kernel.modes[k - 1];
+        const double omega = std::sqrt(mode.gamma / mode.tau / p.m);
+        a[k] = -omega;
+        a[k * m] = omega;
+        a[k * m + k] = 1.0 / mode.tau;
+    }
+    return a;
+}
+
+void check_params(const LangevinParams& p, const MemoryKernel& kernel) {
+    if (!(p.m > 0.0) || !(p.gamma >= 0.0) || !(p.gamma + kernel.static_friction() > 0.0)) {
+        throw std::invalid_argument("gle: m must be positive, gamma non-negative and the total friction positive");
+    }
+    for (const PronyMode& mode : kernel.modes) {
+        if (!(mode.gamma > 0.0) || !(mode.tau > 0.0)) {
+            throw std::invalid_argument("gle: memory kernel modes need positive gamma and tau");
+        }
+    }
+}
+
+}  // namespace
+
+double MemoryKernel::operator()(double t) const {
+    double k = 0.0;
+    for (const PronyMode& mode : modes) k += mode.gamma / mode.tau * std::exp(-t / mode.tau);
+    return k;
+}
+
+double MemoryKernel::static_friction() const {
+    double g = 0.0;
+    for (const PronyMode& mode : modes) g += mode.gamma;
+    return g;
+}
+
+std::string memory_kernel_name(const MemoryKernel& k) {
+    if (k.modes.empty()) return "none";
+    std::string s;
+    char buf[64];
+    for (const PronyMode& mode : k.modes) {
+        std::snprintf(buf, sizeof(buf), "%s%.17g:%.17g", s.empty() ? "" : ",", mode.gamma, mode.tau);
+        s += buf;
+    }
+    return s;
+}
+
+bool parse_memory_kernel(const std::string& spec, MemoryKernel& out) {
+    MemoryKernel k;
+    if (spec == "none") {
+        out = k;
+        return true;
+    }
+    std::size_t pos = 0;
+    while (pos <= spec.size()) {
+        const std::size_t end = std::min(spec.find(',', pos), spec.size());
+        const std::string term = spec.substr(pos, end - pos);
+        const std::size_t colon = term.find(':');
+        if (colon == std::string::npos) return false;
+        PronyMode mode;
+        char* e1 = nullptr;
+        char* e2 = nullptr;
+        errno = 0;
+        const std::string g = term.substr(0, colon), tau = term.substr(colon + 1);
+        mode.gamma = std::strtod(g.c_str(), &e1);
+        mode.tau = std::strtod(tau.c_str(), &e2);
+        if (g.empty() || tau.empty() || *e1 != '\0' || *e2 != '\0' || errno != 0 || !(mode.gamma > 0.0) ||
+            !(mode.tau > 0.0) || !std::isfinite(mode.gamma) || !std::isfinite(mode.tau)) {
+            return false;
+        }
+        k.modes.push_back(mode);
+        pos = end + 1;
+    }
+    out = k;
+    return true;
+}
+
+GleEnsemble::GleEnsemble(const LangevinParams& p, const GleOptions& opt)
+    : p_(p),
+      force_(opt.force),
+      n_threads_(opt.n_threads > 0 ? opt.n_threads : max_threads()),
+      modes_(opt.kernel.modes) {
+    const std::size_t n = opt.n_particles;
+    if (n == 0) throw std::invalid_argument("gle: no particles");
+    check_params(p, opt.kernel);
+
+    const double kT = p.kB * p.T;
+    const double sigma_v = std::sqrt(kT / p.m);
+    for (const PronyMode& mode : modes_) {
+        // スケールした (u, w) = (v/σ_v, z/σ_z) の生成子 [[0, ω], [-ω, -1/τ]] の Δt 分の遷移 E と、
+        // 残りの共分散 I - E Eᵀ のコレスキー分解
+        const double omega = std::sqrt(mode.gamma / mode.tau / p.m);
+        const std::vector<double> e =
+            matrix_exp({0.0, omega * p.dt, -omega * p.dt, -p.dt / mode.tau}, 2);
+        const double s00 = 1.0 - e[0] * e[0] - e[1] * e[1];
+        const double s01 = -(e[0] * e[2] + e[1] * e[3]);
+        const double s11 = 1.0 - e[2] * e[2] - e[3] * e[3];
+        const double l00 = std::sqrt(std::max(0.0, s00));
+        const double l10 = l00 > 0.0 ? s01 / l00 : 0.0;
+        const double l11 = std::sqrt(std::max(0.0, s11 - l10 * l10));
+        const double sigma_z = std::sqrt(mode.gamma / mode.tau * kT);
+        steps_.push_back({e[0], e[1] * sigma_v / sigma_z, e[2] * sigma_z / sigma_v, e[3], sigma_v * l00,
+                          sigma_z * l10, sigma_z * l11});
+    }
+    c0_ = std::exp(-p.gamma / p.m * p.dt);
+    noise0_ = sigma_v * std::sqrt(-std::expm1(-2.0 * p.gamma / p.m * p.dt));
+    noise_per_dim_ = 2 * static_cast<int>(modes_.size()) + (p.gamma > 0.0 ? 1 : 0);
+
+    // 原点から、v と z_k は平衡分布から始める
+    x_.assign(n, 0.0);
+    y_.assign(n, 0.0);
+    vx_.resize(n);
+    vy_.resize(n);
+    z_.resize(2 * modes_.size() * n);
+    const std::size_t n_blocks = (n + kBlock - 1) / kBlock;
+    rngs_.reserve(n_blocks);
+    for (std::size_t k = 0; k < n_blocks; k++) rngs_.emplace_back(opt.seed, k);
+    for (std::size_t k = 0; k < n_blocks; k++) {
+        const std::size_t i0 = k * kBlock;
+        const std::size_t b = std::min(kBlock, n - i0);
+        rngs_[k].fill(vx_.data() + i0, b);
+        rngs_[k].fill(vy_.data() + i0, b);
+        for (std::size_t i = i0; i < i0 + b; i++) {
+            vx_[i] *= sigma_v;
+            vy_[i] *= sigma_v;
+        }
+        for (std::size_t m = 0; m < modes_.size(); m++) {
+            const double sigma_z = std::sqrt(modes_[m].gamma / modes_[m].tau * kT);
+            for (int d = 0; d < 2; d++) {
+                double* z = z_.data() + (2 * m + d) * n + i0;
+                rngs_[k].fill(z, b);
+                for (std::size_t i = 0; i < b; i++) z[i] *= sigma_z;
+            }
+        }
+    }
+    vx0_ = vx_;
+    vy0_ = vy_;
+}
+
+void GleEnsemble::step(long long n_steps) {
+    const std::size_t n = size();
+    const std::size_t n_blocks = rngs_.size();
+    const std::size_t n_modes = modes_.size();
+    const double half = 0.5 * p_.dt;
+    const double half_kick = 0.5 * p_.dt / p_.m;
+    const bool markov = p_.gamma > 0.0;
+    visit_force(force_, [&](const auto& force) {
+        for (long long s = 0; s < n_steps; s++) {
+#pragma omp parallel num_threads(n_threads_)
+            {
+                std::vector<double> eta(static_cast<std::size_t>(noise_per_dim_) * 2 * kBlock);
+#pragma omp for schedule(static)
+                for (std::size_t k = 0; k < n_blocks; k++) {
+                    const std::size_t i0 = k * kBlock;
+                    const std::size_t b = std::min(kBlock, n - i0);
+                    {
+                        ITPHYS_PHASE(kRng);
+                        rngs_[k].fill(eta.data(), static_cast<std::size_t>(noise_per_dim_) * 2 * b);
+                    }
+                    ITPHYS_PHASE(kStep);
+                    double* x = x_.data() + i0;
+                    double* y = y_.data() + i0;
+                    double* v[2] = {vx_.data() + i0, vy_.data() + i0};
+                    // B, A（力は始めの位置で）
+                    for (std::size_t i = 0; i < b; i++) {
+                        double fx = 0.0, fy = 0.0;
+                        force(x[i], y[i], fx, fy);
+                        v[0][i] += half_kick * fx;
+                        v[1][i] += half_kick * fy;
+                        x[i] += v[0][i] * half;
+                        y[i] += v[1][i] * half;
+                    }
+                    // O: モードごとの (v, z_k) の厳密な遷移、続けて γ0 の部分
+                    for (std::size_t m = 0; m < n_modes; m++) {
+                        const ModeStep& c = steps_[m];
+                        for (int d = 0; d < 2; d++) {
+                            double* vd = v[d];
+                            double* z = z_.data() + (2 * m + d) * n + i0;
+                            const double* e1 = eta.data() + (4 * m + 2 * d) * b;
+                            const double* e2 = e1 + b;
+                            for (std::size_t i = 0; i < b; i++) {
+                                const double vi = vd[i], zi = z[i];
+                                vd[i] = c.a_vv * vi + c.a_vz * zi + c.n_v * e1[i];
+                                z[i] = c.a_zv * vi + c.a_zz * zi + c.n_zv * e1[i] + c.n_zz * e2[i];
+                            }
+                        }
+                    }
+                    if (markov) {
+                        for (int d = 0; d < 2; d++) {
+                            double* vd = v[d];
+                            const double* e = eta.data() + (4 * n_modes + d) * b;
+                            for (std::size_t i = 0; i < b; i++) vd[i] = c0_ * vd[i] + noise0_ * e[i];
+                        }
+                    }
+                    // A, B（力は終わりの位置で）
+                    for (std::size_t i = 0; i < b; i++) {
+                        x[i] += v[0][i] * half;
+                        y[i] += v[1][i] * half;
+                        double fx = 0.0, fy = 0.0;
+                        force(x[i], y[i], fx, fy);
+                        v[0][i] += half_kick * fx;
+                        v[1][i] += half_kick * fy;
+                    }
+                    ITPHYS_COUNT(kSteps, b);
+                    ITPHYS_COUNT(kSamples, static_cast<std::size_t>(noise_per_dim_) * 2 * b);
+                }
+            }
+            t_ += p_.dt;
+        }
+    });
+}
+
+double GleEnsemble::msd() const {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < size(); i++) sum += x_[i] * x_[i] + y_[i] * y_[i];
+    return sum / size();
+}
+
+double GleEnsemble::velocity_autocorrelation() const {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < size(); i++) sum += vx_[i] * vx0_[i] + vy_[i] * vy0_[i];
+    return sum / size();
+}
+
+double GleEnsemble::kinetic_energy() const {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < size(); i++) sum += vx_[i] * vx_[i] + vy_[i] * vy_[i];
+    return 0.5 * p_.m * sum / size();
+}
+
+double GleEnsemble::auxiliary_temperature() const {
+    if (modes_.empty()) return 0.0;
+    const std::size_t n = size();
+    double sum = 0.0;
+    for (std::size_t m = 0; m < modes_.size(); m++) {
+        const double c = modes_[m].gamma / modes_[m].tau;
+        double s = 0.0;
+        for (std::size_t i = 0; i < 2 * n; i++) {
+            const double z = z_[2 * m * n + i];
+            s += z * z;
+        }
+        sum += s / c;
+    }
+    return sum / (p_.kB * 2.0 * n * modes_.size());
+}
+
+double gle_theoretical_vacf(const LangevinParams& p, const MemoryKernel& kernel, double t) {
+    check_params(p, kernel);
+    std::vector<double> a = drift_matrix(p, kernel);
+    for (double& v : a) v *= -t;
+    const int m = static_cast<int>(kernel.modes.size()) + 1;
+    return 2.0 * p.kB * p.T / p.m * matrix_exp(a, m)[0];
+}
+
+double gle_theoretical_msd(const LangevinParams& p, const MemoryKernel& kernel, double t) {
+    check_params(p, kernel);
+    const int m = static_cast<int>(kernel.modes.size()) + 1;
+    const std::vector<double> a = drift_matrix(p, kernel);
+    // e_0ᵀ A^{-1} と e_0ᵀ A^{-2} は Aᵀ の方程式を2回解いて求める
+    std::vector<double> at(a.size());
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < m; j++) at[i * m + j] = a[j * m + i];
+    }
+    std::vector<double> e0(m, 0.0);
+    e0[0] = 1.0;
+    const std::vector<double> r1 = solve(at, e0, m);
+    const std::vector<double> r2 = solve(at, r1, m);
+    std::vector<double> minus_at(a);
+    for (double& v : minus_at) v *= -t;
+    const std::vector<double> e = matrix_exp(minus_at, m);
+    double tail = 0.0;  // e_0ᵀ A^{-2} (I - e^{-At}) e_0
+    for (int i = 0; i < m; i++) tail += r2[i] * ((i == 0 ? 1.0 : 0.0) - e[i * m]);
+    return 4.0 * p.kB * p.T / p.m * (r1[0] * t - tail);
+}
+
+}  // namespace itphys
@@ -0,0 +1,313 @@
+/*
+ * hydrodynamics.cpp
+ *
+ * 流体力学的相互作用のあるブラウン動力学（itphys/hydrodynamics.hpp を参照）
+ */
+
+#include "itphys/hydrodynamics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "itphys/ensemble.hpp"
+#include "itphys/instrument.hpp"
+
+namespace itphys {
+
+namespace {
+
+/**
+ * 対称行列 a（m × m、行優先）の固有値分解（巡回ヤコビ法）
+ * 終わると a の対角成分が固有値、q の列が固有ベクトルになる
+ */
+void symmetric_eigen(std::vector<double>& a, int m, std::vector<double>& q) {
+    q.assign(static_cast<std::size_t>(m) * m, 0.0);
+    for (int i = 0; i < m; i++) q[i * m + i] = 1.0;
+    for (int sweep = 0; sweep < 64; sweep++) {
+        double off = 0.0, diag = 0.0;
+        for (int i = 0; i < m; i++) {
+            diag += a[i * m + i] * a[i * m + i];
+            for (int j = i + 1; j < m; j++) off += a[i * m + j] * a[i * m + j];
+        }
+        if (off <= 1e-30 * diag) return;
+        for (int p = 0; p < m; p++) {
+            for (int r = p + 1; r < m; r++) {
+                const double apr = a[p * m + r];
+                if (apr == 0.0) continue;
+                // a[p][r] を 0 にする回転
+                const double theta = (a[r * m + r] - a[p * m + p]) / (2.0 * apr);
+                const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                const double c = 1.0 / std::sqrt(t * t + 1.0);
+                const double s = t * c;
+                for (int k = 0; k < m; k++) {
+                    const double akp = a[k * m + p], akr = a[k * m + r];
+                    a[k * m + p] = c * akp - s * akr;
+                    a[k * m + r] = s * akp + c * akr;
+                }
+                for (int k = 0; k < m; k++) {
+                    const double apk = a[p * m + k], ark = a[r * m + k];
+                    a[p * m + k] = c * apk - s * ark;
+                    a[r * m + k] = s * apk + c * ark;
+                }
+                for (int k = 0; k < m; k++) {
+                    const double qkp = q[k * m + p], qkr = q[k * m + r];
+                    q[k * m + p] = c * qkp - s * qkr;
+                    q[k * m + r] = s * qkp + c * qkr;
+                }
+            }
+        }
+    }
+}
+
+/** 3重対角行列 T（対角 alpha、副対角 beta、大きさ m）の T^{1/2} e_1 */
+void tridiagonal_sqrt_e1(const std::vector<double>& alpha, const std::vector<double>& beta, int m,
+                         std::vector<double>& s) {
+    std::vector<double> a(static_cast<std::size_t>(m) * m, 0.0), q;
+    for (int i = 0; i < m; i++) {
+        a[i * m + i] = alpha[i];
+        if (i + 1 < m) a[i * m + i + 1] = a[(i + 1) * m + i] = beta[i];
+    }
+    symmetric_eigen(a, m, q);
+    s.assign(m, 0.0);
+    for (int k = 0; k < m; k++) {
+        const double w = std::sqrt(std::max(0.0, a[k * m + k])) * q[k];  // √λ_k (Q^T e_1)_k
+        for (int i = 0; i < m; i++) s[i] += q[i * m + k] * w;
+    }
+}
+
+double dot(const double* a, const double* b, std::size_t n) {
+    double s = 0.0;
+    for (std::size_t i = 0; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+}  // namespace
+
+void RpyMobility::pair_block(double dx, double dy, double& mxx, double& mxy, double& myy) const {
+    const double r2 = dx * dx + dy * dy;
+    const double r = std::sqrt(r2);
+    const double ir = 1.0 / r;
+    double c1, c2;  // M = μ0 (c1 I + c2 d dᵀ)
+    if (r >= 2.0 * a_) {
+        const double ar3 = a_ * a_ * a_ * ir * ir * ir;
+        c1 = 0.75 * a_ * ir + 0.5 * ar3;
+        c2 = (0.75 * a_ * ir - 1.5 * ar3) * ir * ir;
+    } else {
+        c1 = 1.0 - 9.0 * r / (32.0 * a_);
+        c2 = 3.0 / (32.0 * a_) * ir;
+    }
+    mxx = mu0_ * (c1 + c2 * dx * dx);
+    mxy = mu0_ * c2 * dx * dy;
+    myy = mu0_ * (c1 + c2 * dy * dy);
+}
+
+void RpyMobility::apply(const double* x, const double* y, std::size_t n, const double* fx,
+                        const double* fy, double* ux, double* uy, int n_threads) const {
+    ITPHYS_PHASE(kStep);
+    const double a = a_;
+    const double a3 = a * a * a;
+    const double two_a = 2.0 * a;
+    const double near1 = 9.0 / (32.0 * a);
+    const double near2 = 3.0 / (32.0 * a);
+    // 粒子 i の速度は i を受け持つスレッドだけが書く。j = i（r = 0）の項は係数を 0 にして
+    // 分岐なしで足し（近いときと遠いときの両方の式を計算してから選ぶ）、自分の μ0 f_i は最後に足す
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+    for (std::size_t i = 0; i < n; i++) {
+        const double xi = x[i], yi = y[i];
+        double sx = 0.0, sy = 0.0;
+        for (std::size_t j = 0; j < n; j++) {
+            const double dx = xi - x[j];
+            const double dy = yi - y[j];
+            const double r2 = dx * dx + dy * dy;
+            const double r = std::sqrt(r2);
+            const double ir = 1.0 / (r2 > 0.0 ? r : 1.0);
+            const double ar3 = a3 * ir * ir * ir;
+            const bool far = r >= two_a;
+            const double far1 = 0.75 * a * ir + 0.5 * ar3;
+            const double far2 = (0.75 * a * ir - 1.5 * ar3) * ir * ir;
+            const double c1 = r2 > 0.0 ? (far ? far1 : 1.0 - near1 * r) : 0.0;
+            const double c2 = far ? far2 : near2 * ir;
+            const double d = c2 * (dx * fx[j] + dy * fy[j]);
+            sx += c1 * fx[j] + d * dx;
+            sy += c1 * fy[j] + d * dy;
+        }
+        ux[i] = mu0_ * (fx[i] + sx);
+        uy[i] = mu0_ * (fy[i] + sy);
+    }
+}
+
+void RpyMobility::divergence(const double* x, const double* y, std::size_t n, double* dx, double* dy,
+                             int n_threads) const {
+    ITPHYS_PHASE(kStep);
+    const double a = a_;
+    const double a3 = a * a * a;
+    const double two_a = 2.0 * a;
+    const double near2 = 3.0 / (32.0 * a);
+    // j = i の項は r_i - r_j = 0 なので係数によらず 0（apply と同じく分岐なしで足す）
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+    for (std::size_t i = 0; i < n; i++) {
+        const double xi = x[i], yi = y[i];
+        double sx = 0.0, sy = 0.0;
+        for (std::size_t j = 0; j < n; j++) {
+            const double ex = xi - x[j];
+            const double ey = yi - y[j];
+            const double r2 = ex * ex + ey * ey;
+            const double r = std::sqrt(r2);
+            const double ir = 1.0 / (r2 > 0.0 ? r : 1.0);
+            const double ar3 = a3 * ir * ir * ir;
+            const double c2 = r >= two_a ? (0.75 * a * ir - 1.5 * ar3) * ir * ir : near2 * ir;
+            sx += c2 * ex;
+            sy += c2 * ey;
+        }
+        dx[i] = mu0_ * sx;
+        dy[i] = mu0_ * sy;
+    }
+}
+
+int krylov_sqrt(const std::function<void(const double*, double*)>& apply, const double* z, double* out,
+                std::size_t dim, double tolerance, int max_iter) {
+    const double norm = std::sqrt(dot(z, z, dim));
+    std::fill(out, out + dim, 0.0);
+    if (norm == 0.0 || max_iter < 1) return 0;
+
+    std::vector<double> basis(dim);  // V の列を順に並べる
+    for (std::size_t i = 0; i < dim; i++) basis[i] = z[i] / norm;
+    std::vector<double> alpha, beta, s, prev;
+    std::vector<double> w(dim);
+    int m = 0;
+    for (;;) {
+        const double* v = basis.data() + m * dim;
+        apply(v, w.data());
+        alpha.push_back(dot(v, w.data(), dim));
+        m++;
+        // 全ての前の基底に対して直交化し直す（2回の古典グラム・シュミット）
+        for (int pass = 0; pass < 2; pass++) {
+            for (int j = 0; j < m; j++) {
+                const double* vj = basis.data() + j * dim;
+                const double c = dot(vj, w.data(), dim);
+                for (std::size_t i = 0; i < dim; i++) w[i] -= c * vj[i];
+            }
+        }
+        const double b = std::sqrt(dot(w.data(), w.data(), dim));
+
+        tridiagonal_sqrt_e1(alpha, beta, m, s);
+        // V は正規直交なので、近似の差のノルムは係数の差のノルム
+        double diff = 0.0, size = 0.0;
+        for (int i = 0; i < m; i++) {
+            const double d = s[i] - (i < m - 1 ? prev[i] : 0.0);
+            diff += d * d;
+            size += s[i] * s[i];
+        }
+        const bool done = (m > 1 && diff <= tolerance * tolerance * size) || b <= 1e-14 * std::fabs(alpha[0]) ||
+                          m >= max_iter || static_cast<std::size_t>(m) >= dim;
+        if (done) break;
+        prev = s;
+        beta.push_back(b);
+        basis.resize((m + 1) * dim);
+        double* next = basis.data() + m * dim;
+        for (std::size_t i = 0; i < dim; i++) next[i] = w[i] / b;
+    }
+
+    for (int k = 0; k < m; k++) {
+        const double c = norm * s[k];
+        const double* vk = basis.data() + k * dim;
+        for (std::size_t i = 0; i < dim; i++) out[i] += c * vk[i];
+    }
+    return m;
+}
+
+HydroBrownian::HydroBrownian(const LangevinParams& p, const HydroOptions& opt)
+    : p_(p),
+      opt_(opt),
+      mobility_(1.0 / p.gamma, opt.radius),
+      n_threads_(opt.n_threads > 0 ? opt.n_threads : max_threads()),
+      rng_(opt.seed) {
+    const std::size_t n = opt.n_particles;
+    if (n == 0 || !(opt.radius > 0.0) || !(opt.spacing > 0.0) || !(p.gamma > 0.0)) {
+        throw std::invalid_argument("hydrodynamics: particles, radius, spacing and gamma must be positive");
+    }
+    // 原点を中心とした正方格子
+    const std::size_t nx = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(n))));
+    const std::size_t ny = (n + nx - 1) / nx;
+    x_.resize(n);
+    y_.resize(n);
+    for (std::size_t i = 0; i < n; i++) {
+        x_[i] = (static_cast<double>(i % nx) - 0.5 * (nx - 1)) * opt.spacing;
+        y_[i] = (static_cast<double>(i / nx) - 0.5 * (ny - 1)) * opt.spacing;
+    }
+    x0_ = x_;
+    y0_ = y_;
+    f_.assign(2 * n, 0.0);
+    u_.assign(2 * n, 0.0);
+    z_.assign(2 * n, 0.0);
+    g_.assign(2 * n, 0.0);
+    div_.assign(2 * n, 0.0);
+}
+
+void HydroBrownian::step(long long n_steps) {
+    const std::size_t n = size();
+    const double c = std::sqrt(2.0 * p_.kB * p_.T * p_.dt);
+    const double kT = p_.kB * p_.T;
+    const auto apply = [this, n](const double* in, double* out) {
+        mobility_.apply(x_.data(), y_.data(), n, in, in + n, out, out + n, n_threads_);
+    };
+    for (long long s = 0; s < n_steps; s++) {
+        // ドリフト M F（外力がなければ 0）
+        if (opt_.force.any()) {
+            visit_force(opt_.force, [&](const auto& force) {
+                for (std::size_t i = 0; i < n; i++) {
+                    double fx = 0.0, fy = 0.0;
+                    force(x_[i], y_[i], fx, fy);
+                    f_[i] = fx;
+                    f_[n + i] = fy;
+                }
+            });
+            apply(f_.data(), u_.data());
+        }
+        // 伊藤のドリフト kBT ∇·M（平面内の RPY では 0 にならない）
+        mobility_.divergence(x_.data(), y_.data(), n, div_.data(), div_.data() + n, n_threads_);
+        {
+            ITPHYS_PHASE(kRng);
+            rng_.fill(z_.data(), 2 * n);
+        }
+        const int m = krylov_sqrt(apply, z_.data(), g_.data(), 2 * n, opt_.tolerance, opt_.max_krylov);
+        {
+            ITPHYS_PHASE(kStep);
+            for (std::size_t i = 0; i < n; i++) {
+                x_[i] += (u_[i] + kT * div_[i]) * p_.dt + c * g_[i];
+                y_[i] += (u_[n + i] + kT * div_[n + i]) * p_.dt + c * g_[n + i];
+            }
+        }
+        ITPHYS_COUNT(kSteps, n);
+        ITPHYS_COUNT(kSamples, 2 * n);
+        t_ += p_.dt;
+        steps_++;
+        krylov_total_ += m;
+        krylov_max_ = std::max(krylov_max_, m);
+    }
+}
+
+double HydroBrownian::msd() const {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < size(); i++) {
+        const double dx = x_[i] - x0_[i];
+        const double dy = y_[i] - y0_[i];
+        sum += dx * dx + dy * dy;
+    }
+    return sum / size();
+}
+
+double HydroBrownian::center_x() const {
+    double sum = 0.0;
+    for (double v : x_) sum += v;
+    return sum / size();
+}
+
+double HydroBrownian::center_y() const {
+    double sum = 0.0;
+    for (double v : y_) sum += v;
+    return sum / size();
+}
+
+}  // namespace itphys
@@ -0,0 +1,217 @@
+/*
+ * instrument.cpp
+ *
+ * ホットパスの計測（itphys/instrument.hpp を参照）
+ * ITPHYS_INSTRUMENT が定義されていなければ何もコンパイルしない
+ */
+
+#include "itphys/instrument.hpp"
+
+#ifdef ITPHYS_INSTRUMENT
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace itphys {
+namespace instrument {
+
+namespace {
+
+const char* const kPhaseNames[kNumPhases] = {"rng", "step", "observe", "output"};
+const char* const kCounterNames[kNumCounters] = {"steps", "samples", "bytes"};
+
+constexpr int kNumHw = 4;
+const char* const kHwNames[kNumHw] = {"cycles", "instructions", "cache_misses", "branch_misses"};
+
+/** 全スレッドの集計とハードウェアカウンタ */
+class Registry {
+public:
+    Registry() {
+        t0_ = std::chrono::steady_clock::now();
+        tick0_ = ticks();
+        open_hw();
+        std::atexit([] { ::itphys::instrument::report(stderr); });
+    }
+
+    void attach(ThreadSlot* s) {
+        std::lock_guard<std::mutex> lock(mu_);
+        live_.push_back(s);
+    }
+
+    /** 終了するスレッドの値を retired_ に移す */
+    void detach(ThreadSlot* s) {
+        std::lock_guard<std::mutex> lock(mu_);
+        add(retired_, *s);
+        for (auto& p : live_) {
+            if (p == s) p = nullptr;
+        }
+    }
+
+    void report(std::FILE* fp);
+
+private:
+    static void add(Tally& dst, const Tally& src) {
+        for (int i = 0; i < kNumPhases; i++) {
+            dst.ticks[i] += src.ticks[i];
+            dst.calls[i] += src.calls[i];
+        }
+        for (int i = 0; i < kNumCounters; i++) dst.counters[i] += src.counters[i];
+    }
+
+    void open_hw() {
+#ifdef __linux__
+        static const std::uint64_t kConfig[kNumHw] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES};
+        for (int i = 0; i < kNumHw; i++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = kConfig[i];
+            attr.inherit = 1;  // 後から作られるスレッド（OpenMP、スレッドプール）も数える
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            hw_fd_[i] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+    }
+
+    bool read_hw(std::uint64_t* v) const {
+#ifdef __linux__
+        for (int i = 0; i < kNumHw; i++) {
+            if (hw_fd_[i] < 0 || ::read(hw_fd_[i], &v[i], sizeof(v[i])) != sizeof(v[i])) {
+                return false;
+            }
+        }
+        return true;
+#else
+        (void)v;
+        return false;
+#endif
+    }
+
+    std::mutex mu_;
+    std::vector<ThreadSlot*> live_;
+    Tally retired_;
+    std::chrono::steady_clock::time_point t0_;
+    std::uint64_t tick0_ = 0;
+    int hw_fd_[kNumHw] = {-1, -1, -1, -1};
+};
+
+// atexit の report より先に破棄されないよう、意図的に解放しない
+Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+// 最初の計測より前（静的初期化の時点）にハードウェアカウンタを開始しておく
+[[maybe_unused]] const bool kRegistryStarted = (registry(), true);
+
+void Registry::report(std::FILE* fp) {
+    Tally total;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        add(total, retired_);
+        for (ThreadSlot* s : live_) {
+            if (s) add(total, *s);
+        }
+    }
+
+    // TSC の周波数を経過時間から求める
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0_).count();
+    const std::uint64_t dtick = ticks() - tick0_;
+#if defined(__x86_64__) || defined(__i386__)
+    const double sec_per_tick = dtick > 0 && wall > 0.0 ? wall / dtick : 0.0;
+#else
+    (void)dtick;
+    const double sec_per_tick = double(std::chrono::steady_clock::period::num) /
+                                std::chrono::steady_clock::period::den;
+#endif
+
+    double phase_total = 0.0;
+    for (int i = 0; i < kNumPhases; i++) phase_total += total.ticks[i] * sec_per_tick;
+
+    std::fprintf(fp, "# itphys instrumentation: wall %.6f s\n", wall);
+    std::fprintf(fp, "# %-8s %12s %7s %14s %10s\n", "phase", "seconds", "share", "calls", "ns/call");
+    for (int i = 0; i < kNumPhases; i++) {
+        const double sec = total.ticks[i] * sec_per_tick;
+        std::fprintf(fp, "# %-8s %12.6f %6.1f%% %14llu %10.1f\n", kPhaseNames[i], sec,
+                     phase_total > 0.0 ? 100.0 * sec / phase_total : 0.0,
+                     (unsigned long long)total.calls[i],
+                     total.calls[i] ? 1e9 * sec / total.calls[i] : 0.0);
+    }
+    std::fprintf(fp, "# counters:");
+    for (int i = 0; i < kNumCounters; i++) {
+        std::fprintf(fp, " %s=%llu", kCounterNames[i], (unsigned long long)total.counters[i]);
+    }
+    std::fprintf(fp, "\n");
+
+    std::uint64_t hw[kNumHw] = {};
+    const bool have_hw = read_hw(hw);
+    if (have_hw) {
+        std::fprintf(fp, "# hw: cycles=%llu instructions=%llu ipc=%.3f cache_misses=%llu branch_misses=%llu\n",
+                     (unsigned long long)hw[0], (unsigned long long)hw[1],
+                     hw[0] ? double(hw[1]) / hw[0] : 0.0, (unsigned long long)hw[2],
+                     (unsigned long long)hw[3]);
+    } else {
+        std::fprintf(fp, "# hw: unavailable (perf_event_open failed; see /proc/sys/kernel/perf_event_paranoid)\n");
+    }
+
+    // 機械可読な1行（JSON）
+    auto write_json = [&](std::FILE* out, const char* prefix) {
+        std::fprintf(out, "%s{\"wall_seconds\": %.9g, \"phases\": {", prefix, wall);
+        for (int i = 0; i < kNumPhases; i++) {
+            std::fprintf(out, "%s\"%s\": {\"seconds\": %.9g, \"calls\": %llu}", i ? ", " : "",
+                         kPhaseNames[i], total.ticks[i] * sec_per_tick,
+                         (unsigned long long)total.calls[i]);
+        }
+        std::fprintf(out, "}, \"counters\": {");
+        for (int i = 0; i < kNumCounters; i++) {
+            std::fprintf(out, "%s\"%s\": %llu", i ? ", " : "", kCounterNames[i],
+                         (unsigned long long)total.counters[i]);
+        }
+        std::fprintf(out, "}, \"hw\": ");
+        if (have_hw) {
+            std::fprintf(out, "{");
+            for (int i = 0; i < kNumHw; i++) {
+                std::fprintf(out, "%s\"%s\": %llu", i ? ", " : "", kHwNames[i],
+                             (unsigned long long)hw[i]);
+            }
+            std::fprintf(out, "}");
+        } else {
+            std::fprintf(out, "null");
+        }
+        std::fprintf(out, "}\n");
+    };
+    write_json(fp, "# itphys-json ");
+    std::fflush(fp);
+
+    if (const char* path = std::getenv("ITPHYS_INSTRUMENT_JSON")) {
+        if (std::FILE* out = std::fopen(path, "w")) {
+            write_json(out, "");
+            std::fclose(out);
+        }
+    }
+}
+
+}  // namespace
+
+ThreadSlot::ThreadSlot() { registry().attach(this); }
+
+ThreadSlot::~ThreadSlot() { registry().detach(this); }
+
+void report(std::FILE* fp) { registry().report(fp); }
+
+}  // namespace instrument
+}  // namespace itphys
+
+#endif  // ITPHYS_INSTRUMENT
@@ -0,0 +1,165 @@
+/*
+ * io.cpp
+ *
+ * シミュレーション結果の出力先（itphys/io.hpp を参照）
+ */
+
+#include "itphys/io.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace itphys {
+
+namespace {
+
+// 出力バッファの大きさ（テキストは約 64 KiB ごと、バイナリは 8192 レコードごとに書き出す）
+constexpr std::size_t kTextBufferSize = 1 << 16;
+constexpr std::size_t kBinaryRecords = 8192;
+// 1行の最大長（%.17e × 5 でも 130 文字程度）
+constexpr std::size_t kMaxLine = 256;
+
+}  // namespace
+
+TextSink::TextSink(std::FILE* fp, int precision, bool fixed) : fp_(fp) {
+    buf_.reserve(kTextBufferSize);
+    const char c = fixed ? 'f' : 'e';
+    std::snprintf(fmt_, sizeof(fmt_), "%%.%d%c %%.%d%c %%.%d%c %%.%d%c %%.%d%c\n", precision, c,
+                  precision, c, precision, c, precision, c, precision, c);
+}
+
+TextSink::~TextSink() { flush(); }
+
+void TextSink::header() {
+    static const char kHeader[] = "# t x y vx vy\n";
+    buf_.insert(buf_.end(), kHeader, kHeader + sizeof(kHeader) - 1);
+    ITPHYS_COUNT(kBytes, sizeof(kHeader) - 1);
+}
+
+void TextSink::write(const ParticleState& s) {
+    ITPHYS_PHASE(kOutput);
+    if (buf_.size() + kMaxLine > kTextBufferSize) flush();
+    char line[kMaxLine];
+    const int len = std::snprintf(line, sizeof(line), fmt_, s.t, s.x, s.y, s.vx, s.vy);
+    buf_.insert(buf_.end(), line, line + len);
+    ITPHYS_COUNT(kBytes, len);
+}
+
+void TextSink::flush() {
+    if (!buf_.empty()) {
+        std::fwrite(buf_.data(), 1, buf_.size(), fp_);
+        bytes_ += buf_.size();
+        buf_.clear();
+    }
+    std::fflush(fp_);
+}
+
+BinarySink::BinarySink(std::FILE* fp) : fp_(fp), buf_(kBinaryRecords * kStateFields) {}
+
+BinarySink::~BinarySink() { flush(); }
+
+void BinarySink::header() {
+    unsigned char h[kBinaryHeaderSize] = {};
+    std::memcpy(h, kBinaryMagic, sizeof(kBinaryMagic));
+    const std::uint32_t fields = kStateFields;
+    std::memcpy(h + 8, &fields, sizeof(fields));
+    std::fwrite(h, 1, sizeof(h), fp_);
+    bytes_ += sizeof(h);
+    ITPHYS_COUNT(kBytes, sizeof(h));
+}
+
+void BinarySink::flush() {
+    if (n_ > 0) {
+        std::fwrite(buf_.data(), sizeof(double), n_, fp_);
+        bytes_ += n_ * sizeof(double);
+        n_ = 0;
+    }
+    std::fflush(fp_);
+}
+
+MmapSink::MmapSink(const std::string& path, std::size_t initial_capacity) {
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) throw std::system_error(errno, std::generic_category(), "open " + path);
+    try {
+        grow(initial_capacity > 0 ? initial_capacity : kBinaryHeaderSize);
+    } catch (...) {
+        // デストラクタは呼ばれないので、ここで閉じて作りかけのファイルを消す
+        ::close(fd_);
+        fd_ = -1;
+        ::unlink(path.c_str());
+        throw;
+    }
+}
+
+MmapSink::~MmapSink() {
+    if (base_) ::munmap(base_, cap_);
+    if (fd_ >= 0) {
+        // 余分に確保した部分を切り詰める
+        if (::ftruncate(fd_, static_cast<off_t>(pos_)) != 0) std::perror("MmapSink: ftruncate");
+        ::close(fd_);
+    }
+}
+
+void MmapSink::grow(std::size_t need) {
+    std::size_t cap = cap_ > 0 ? cap_ : need;
+    while (cap < need) cap *= 2;
+    if (base_) ::munmap(base_, cap_);
+    base_ = nullptr;
+    if (::ftruncate(fd_, static_cast<off_t>(cap)) != 0) {
+        throw std::system_error(errno, std::generic_category(), "MmapSink: ftruncate");
+    }
+    void* p = ::mmap(nullptr, cap, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "MmapSink: mmap");
+    base_ = static_cast<char*>(p);
+    cap_ = cap;
+}
+
+void MmapSink::header() {
+    if (pos_ + kBinaryHeaderSize > cap_) grow(pos_ + kBinaryHeaderSize);
+    std::memset(base_ + pos_, 0, kBinaryHeaderSize);
+    std::memcpy(base_ + pos_, kBinaryMagic, sizeof(kBinaryMagic));
+    const std::uint32_t fields = kStateFields;
+    std::memcpy(base_ + pos_ + 8, &fields, sizeof(fields));
+    pos_ += kBinaryHeaderSize;
+    ITPHYS_COUNT(kBytes, kBinaryHeaderSize);
+}
+
+double* MmapSink::reserve(std::size_t n) {
+    const std::size_t bytes = n * kStateFields * sizeof(double);
+    if (pos_ + bytes > cap_) grow(pos_ + bytes);
+    double* p = reinterpret_cast<double*>(base_ + pos_);
+    pos_ += bytes;
+    ITPHYS_COUNT(kBytes, bytes);
+    return p;
+}
+
+void MmapSink::flush() {
+    if (base_) ::msync(base_, pos_, MS_ASYNC);
+}
+
+bool read_binary(const std::string& path, std::vector<double>& out) {
+    std::FILE* fp = std::fopen(path.c_str(), "rb");
+    if (!fp) return false;
+    unsigned char h[kBinaryHeaderSize];
+    std::uint32_t fields = 0;
+    bool ok = std::fread(h, 1, sizeof(h), fp) == sizeof(h) &&
+              std::memcmp(h, kBinaryMagic, sizeof(kBinaryMagic)) == 0;
+    if (ok) {
+        std::memcpy(&fields, h + 8, sizeof(fields));
+        ok = fields == kStateFields;
+    }
+    out.clear();
+    double rec[kStateFields];
+    while (ok && std::fread(rec, sizeof(double), kStateFields, fp) == kStateFields) {
+        out.insert(out.end(), rec, rec + kStateFields);
+    }
+    std::fclose(fp);
+    return ok;
+}
+
+}  // namespace itphys
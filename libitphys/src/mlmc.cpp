@@ -0,0 +1,237 @@
+/*
+ * mlmc.cpp
+ *
+ * マルチレベル・モンテカルロ法（itphys/mlmc.hpp を参照）
+ */
+
+#include "itphys/mlmc.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+#include "itphys/ensemble.hpp"
+#include "itphys/instrument.hpp"
+#include "itphys/rng.hpp"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace itphys {
+
+namespace {
+
+constexpr std::size_t kBlock = EulerIntegrator::kNoiseBlock;
+constexpr int kStreamShift = 40;  // 乱数列の番号 = (レベル << 40) + ブロック番号
+
+int thread_id() {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+/** b 粒子の (x, y, vx, vy) */
+struct Block {
+    std::vector<double> x, y, vx, vy, r2_half;
+    explicit Block(std::size_t n) : x(n), y(n), vx(n), vy(n), r2_half(n) {}
+    void reset() {
+        std::fill(x.begin(), x.end(), 0.0);
+        std::fill(y.begin(), y.end(), 0.0);
+        std::fill(vx.begin(), vx.end(), 0.0);
+        std::fill(vy.begin(), vy.end(), 0.0);
+    }
+    template <class Integ>
+    void step(const Integ& integ, const double* eta) {
+        integ.step_block(x.data(), y.data(), vx.data(), vy.data(), eta, x.size());
+    }
+    void mark_half() {
+        for (std::size_t i = 0; i < x.size(); i++) r2_half[i] = x[i] * x[i] + y[i] * y[i];
+    }
+    /** 粒子 i の観測量 */
+    void observe(std::size_t i, double m, double t_end, double t_half, double out[kMlmcObservables]) const {
+        const double r2 = x[i] * x[i] + y[i] * y[i];
+        out[kMlmcMsd] = r2;
+        out[kMlmcEnergy] = 0.5 * m * (vx[i] * vx[i] + vy[i] * vy[i]);
+        out[kMlmcDiffusion] = (r2 - r2_half[i]) / (4.0 * (t_end - t_half));
+    }
+};
+
+/** レベル l の標本をブロック first..first+n_blocks-1 の分だけ計算して lev に加える */
+template <class Integ>
+void sample_level(const LangevinParams& p, const MlmcOptions& opt, int l, std::uint64_t first,
+                  std::uint64_t n_blocks, int n_threads, MlmcLevel& lev) {
+    LangevinParams pf = p, pc = p;
+    pf.dt = p.dt / std::ldexp(1.0, l);
+    pc.dt = 2.0 * pf.dt;
+    const Integ fine(pf), coarse(pc);
+    const long long n_coarse = l == 0 ? p.n_steps : p.n_steps << (l - 1);  // 粗い刻みのステップ数
+    const long long half_coarse = l == 0 ? p.n_steps / 2 : (p.n_steps / 2) << (l - 1);
+    const double t_end = p.n_steps * p.dt;
+    const double t_half = (p.n_steps / 2) * p.dt;
+    const double inv_sqrt2 = 1.0 / std::sqrt(2.0);
+
+    std::vector<std::unique_ptr<MlmcLevel>> locals(n_threads);
+#pragma omp parallel num_threads(n_threads)
+    {
+        const int tid = thread_id();
+        locals[tid].reset(new MlmcLevel());
+        MlmcLevel& local = *locals[tid];
+        Block f(kBlock), c(kBlock);
+        std::vector<double> eta1(2 * kBlock), eta2(2 * kBlock), etac(2 * kBlock);
+#pragma omp for schedule(static)
+        for (std::uint64_t k = 0; k < n_blocks; k++) {
+            NormalRng rng(opt.seed, (static_cast<std::uint64_t>(l) << kStreamShift) + first + k);
+            f.reset();
+            c.reset();
+            // l = 0 は Δt_0 の軌道だけ、l >= 1 は細かい2ステップごとに粗い1ステップ
+            for (long long s = 1; s <= n_coarse; s++) {
+                {
+                    ITPHYS_PHASE(kRng);
+                    rng.fill(eta1.data(), eta1.size());
+                    if (l > 0) rng.fill(eta2.data(), eta2.size());
+                }
+                ITPHYS_PHASE(kStep);
+                if (l == 0) {
+                    f.step(fine, eta1.data());
+                } else {
+                    f.step(fine, eta1.data());
+                    f.step(fine, eta2.data());
+                    for (std::size_t i = 0; i < etac.size(); i++) etac[i] = (eta1[i] + eta2[i]) * inv_sqrt2;
+                    c.step(coarse, etac.data());
+                }
+                if (s == half_coarse) {
+                    f.mark_half();
+                    c.mark_half();
+                }
+            }
+            ITPHYS_COUNT(kSteps, kBlock * static_cast<std::uint64_t>(l == 0 ? n_coarse : 3 * n_coarse));
+            ITPHYS_PHASE(kObserve);
+            for (std::size_t i = 0; i < kBlock; i++) {
+                double pf_obs[kMlmcObservables], pc_obs[kMlmcObservables] = {};
+                f.observe(i, p.m, t_end, t_half, pf_obs);
+                if (l > 0) c.observe(i, p.m, t_end, t_half, pc_obs);
+                for (int q = 0; q < kMlmcObservables; q++) {
+                    local.diff[q].add(pf_obs[q] - pc_obs[q]);
+                    local.fine[q].add(pf_obs[q]);
+                }
+            }
+        }
+    }
+    // スレッド番号の順にまとめる
+    for (const auto& local : locals) {
+        if (!local) continue;
+        for (int q = 0; q < kMlmcObservables; q++) {
+            lev.diff[q].merge(local->diff[q]);
+            lev.fine[q].merge(local->fine[q]);
+        }
+    }
+    lev.samples += n_blocks * kBlock;
+}
+
+/** |E[P_l - P_{l-1}]| ~ 2^{-αl} の α を l >= 1 の回帰で求める（0.5..2 に制限、点が足りなければ 1） */
+double weak_order(const std::vector<MlmcLevel>& levels, int q) {
+    double n = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for (std::size_t l = 1; l < levels.size(); l++) {
+        const double y = std::fabs(levels[l].diff[q].mean());
+        if (y <= 0.0) continue;
+        const double x = static_cast<double>(l);
+        const double ly = -std::log2(y);
+        n += 1.0;
+        sx += x;
+        sy += ly;
+        sxx += x * x;
+        sxy += x * ly;
+    }
+    if (n < 2.0) return 1.0;
+    const double alpha = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+    return std::min(2.0, std::max(0.5, alpha));
+}
+
+template <class Integ>
+MlmcResult run_mlmc_impl(const LangevinParams& p, const MlmcOptions& opt) {
+    const int n_threads = opt.n_threads > 0 ? opt.n_threads : max_threads();
+    const int q = opt.control;
+    const double eps2 = opt.target_rmse * opt.target_rmse;
+    const auto blocks_for = [](std::uint64_t n) { return (n + kBlock - 1) / kBlock; };
+
+    MlmcResult res;
+    std::vector<std::uint64_t> target;
+    const auto add_level = [&]() {
+        const int l = static_cast<int>(res.levels.size());
+        MlmcLevel lev;
+        lev.dt = p.dt / std::ldexp(1.0, l);
+        lev.n_steps = p.n_steps << l;
+        lev.cost = l == 0 ? double(p.n_steps) : 1.5 * double(lev.n_steps);  // 細かい軌道 + 粗い軌道
+        res.levels.push_back(lev);
+        target.push_back(opt.pilot);
+    };
+    for (int l = 0; l < opt.min_levels; l++) add_level();
+
+    for (;;) {
+        // 足りない標本を計算する
+        for (std::size_t l = 0; l < res.levels.size(); l++) {
+            MlmcLevel& lev = res.levels[l];
+            const std::uint64_t have = lev.samples / kBlock;
+            const std::uint64_t want = blocks_for(target[l]);
+            if (want > have) sample_level<Integ>(p, opt, static_cast<int>(l), have, want - have, n_threads, lev);
+        }
+
+        // 最適な標本数 N_l = 2ε⁻² √(V_l/C_l) Σ √(V_k C_k)
+        double sum = 0.0;
+        for (const MlmcLevel& lev : res.levels) sum += std::sqrt(lev.diff[q].variance() * lev.cost);
+        bool more = false;
+        for (std::size_t l = 0; l < res.levels.size(); l++) {
+            const MlmcLevel& lev = res.levels[l];
+            const double n_opt = std::ceil(2.0 / eps2 * std::sqrt(lev.diff[q].variance() / lev.cost) * sum);
+            const std::uint64_t want = std::max<std::uint64_t>(target[l], static_cast<std::uint64_t>(n_opt));
+            if (blocks_for(want) > lev.samples / kBlock) more = true;
+            target[l] = want;
+        }
+        if (more) continue;
+
+        // 時間刻みの誤差 |E[P_L - P_{L-1}]| / (2^α - 1)（最後の2レベルの大きい方から見積もる）
+        const double alpha = weak_order(res.levels, q);
+        const std::size_t L = res.levels.size() - 1;
+        const double y = std::max(std::fabs(res.levels[L].diff[q].mean()),
+                                  std::fabs(res.levels[L - 1].diff[q].mean()) / std::exp2(alpha));
+        res.bias = y / (std::exp2(alpha) - 1.0);
+        res.converged = res.bias <= opt.target_rmse / std::sqrt(2.0);
+        if (res.converged || static_cast<int>(res.levels.size()) >= opt.max_levels) break;
+        add_level();
+    }
+
+    double var[kMlmcObservables] = {};
+    for (const MlmcLevel& lev : res.levels) {
+        for (int k = 0; k < kMlmcObservables; k++) {
+            res.mean[k] += lev.diff[k].mean();
+            var[k] += lev.diff[k].variance() / double(lev.samples);
+        }
+        res.cost += double(lev.samples) * lev.cost;
+    }
+    for (int k = 0; k < kMlmcObservables; k++) res.std_error[k] = std::sqrt(var[k]);
+    // 普通のモンテカルロ（最も細かい刻みだけ）で統計誤差の分散を ε²/2 にする費用
+    const MlmcLevel& finest = res.levels.back();
+    res.cost_mc = 2.0 / eps2 * finest.fine[q].variance() * double(finest.n_steps);
+    return res;
+}
+
+}  // namespace
+
+MlmcResult run_mlmc(const LangevinParams& p, const MlmcOptions& opt) {
+    if (p.n_steps < 2) throw std::invalid_argument("run_mlmc: n_steps must be at least 2");
+    if (opt.min_levels < 2) throw std::invalid_argument("run_mlmc: min_levels must be at least 2");
+    if (opt.max_levels < opt.min_levels) {
+        throw std::invalid_argument("run_mlmc: max_levels must be at least min_levels");
+    }
+    switch (opt.integrator) {
+        case Integrator::kEuler: return run_mlmc_impl<EulerIntegrator>(p, opt);
+        case Integrator::kBaoab: return run_mlmc_impl<BaoabIntegrator>(p, opt);
+        default: throw std::invalid_argument("run_mlmc: the integrator must be euler or baoab");
+    }
+}
+
+}  // namespace itphys
@@ -0,0 +1,121 @@
+/*
+ * observables.cpp
+ *
+ * 物理量の集計（itphys/observables.hpp を参照）
+ */
+
+#include "itphys/observables.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace itphys {
+
+void BlockingStats::merge(const BlockingStats& o) {
+    if (o.levels_.size() > levels_.size()) {
+        levels_.resize(o.levels_.size());
+        pending_.resize(o.levels_.size(), 0.0);
+        has_pending_.resize(o.levels_.size(), 0);
+    }
+    for (std::size_t l = 0; l < o.levels_.size(); l++) levels_[l].merge(o.levels_[l]);
+    // 別の系列の平均どうしは対にしない
+    std::fill(has_pending_.begin(), has_pending_.end(), 0);
+}
+
+int BlockingStats::plateau_level() const {
+    if (levels_.empty() || levels_[0].count() < 2.0) return -1;
+    const double se0 = std_error(0);
+    if (se0 == 0.0) return 0;
+    const double n = levels_[0].count();
+    for (std::size_t l = 0; l < levels_.size() && levels_[l].count() >= 2.0; l++) {
+        const double ratio = std_error(l) / se0;
+        if (std::ldexp(1.0, 3 * static_cast<int>(l)) > 2.0 * n * ratio * ratio * ratio * ratio) {
+            return static_cast<int>(l);
+        }
+    }
+    return -1;
+}
+
+double BlockingStats::plateau_std_error() const {
+    const int l = plateau_level();
+    if (l >= 0) return std_error(l);
+    double se = 0.0;
+    for (std::size_t k = 0; k < levels_.size() && levels_[k].count() >= 2.0; k++) se = std::max(se, std_error(k));
+    return se;
+}
+
+double BlockingStats::autocorrelation_time() const {
+    if (levels_.empty() || std_error(0) == 0.0) return 0.5;
+    const double r = plateau_std_error() / std_error(0);
+    return 0.5 * r * r;
+}
+
+void BlockingStats::set_state(const std::vector<RunningStats>& levels, const std::vector<double>& pending) {
+    levels_ = levels;
+    pending_.assign(levels.size(), 0.0);
+    has_pending_.assign(levels.size(), 0);
+    for (std::size_t l = 0; l < levels.size() && l < pending.size(); l++) {
+        if (!std::isnan(pending[l])) {
+            pending_[l] = pending[l];
+            has_pending_[l] = 1;
+        }
+    }
+}
+
+std::vector<double> BlockingStats::pending() const {
+    std::vector<double> p(levels_.size(), std::numeric_limits<double>::quiet_NaN());
+    for (std::size_t l = 0; l < levels_.size(); l++) {
+        if (has_pending_[l]) p[l] = pending_[l];
+    }
+    return p;
+}
+
+double fit_diffusion_coefficient(const MsdAccumulator& msd, double t_start, int dim) {
+    double sum = 0.0;
+    int n = 0;
+    for (std::size_t i = 0; i < msd.size(); i++) {
+        const double t = msd.time(i);
+        if (t >= t_start && t > 0.0) {
+            sum += msd.at(i).mean() / (2.0 * dim * t);
+            n++;
+        }
+    }
+    return n > 0 ? sum / n : 0.0;
+}
+
+double fit_diffusion_coefficient(const std::vector<double>& t, const std::vector<double>& msd,
+                                 double t_start, int dim) {
+    double sum = 0.0;
+    int n = 0;
+    for (std::size_t i = 0; i < t.size() && i < msd.size(); i++) {
+        if (t[i] >= t_start && t[i] > 0.0) {
+            sum += msd[i] / (2.0 * dim * t[i]);
+            n++;
+        }
+    }
+    return n > 0 ? sum / n : 0.0;
+}
+
+double fit_diffusion_slope(const std::vector<double>& t, const std::vector<double>& msd, double t_start,
+                           int dim) {
+    double n = 0.0, st = 0.0, sm = 0.0;
+    for (std::size_t i = 0; i < t.size() && i < msd.size(); i++) {
+        if (t[i] >= t_start) {
+            n += 1.0;
+            st += t[i];
+            sm += msd[i];
+        }
+    }
+    if (n < 2.0) return 0.0;
+    const double mt = st / n, mm = sm / n;
+    double stt = 0.0, stm = 0.0;
+    for (std::size_t i = 0; i < t.size() && i < msd.size(); i++) {
+        if (t[i] >= t_start) {
+            stt += (t[i] - mt) * (t[i] - mt);
+            stm += (t[i] - mt) * (msd[i] - mm);
+        }
+    }
+    return stt > 0.0 ? stm / stt / (2.0 * dim) : 0.0;
+}
+
+}  // namespace itphys
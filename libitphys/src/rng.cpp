@@ -0,0 +1,130 @@
+/*
+ * rng.cpp
+ *
+ * 乱数生成器（itphys/rng.hpp を参照）
+ */
+
+#include "itphys/rng.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <unistd.h>
+
+namespace itphys {
+
+void Xoshiro256ss::jump() {
+    // xoshiro256 の公式のジャンプ多項式（2^128 ステップ分）
+    static const std::uint64_t kJump[] = {0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+                                          0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+    std::array<std::uint64_t, 4> acc = {0, 0, 0, 0};
+    for (std::uint64_t j : kJump) {
+        for (int b = 0; b < 64; b++) {
+            if (j & (std::uint64_t(1) << b)) {
+                for (int k = 0; k < 4; k++) acc[k] ^= s_[k];
+            }
+            (*this)();
+        }
+    }
+    s_ = acc;
+}
+
+void NormalRng::fill(double* out, std::size_t n) {
+    std::size_t i = 0;
+    if (has_spare_ && n > 0) {
+        out[i++] = spare_;
+        has_spare_ = false;
+    }
+    // 2個ずつ生成する（余った1個は次の呼び出しに回す）
+    for (; i + 1 < n; i += 2) box_muller(out[i], out[i + 1]);
+    if (i < n) out[i] = (*this)();
+}
+
+void NormalRng::fill(float* out, std::size_t n) {
+    std::size_t i = 0;
+    if (has_spare_ && n > 0) {
+        out[i++] = static_cast<float>(spare_);
+        has_spare_ = false;
+    }
+    for (; i + 1 < n; i += 2) {
+        const std::uint64_t r = eng_();
+        const float u1 = to_unit_open_float(static_cast<std::uint32_t>(r >> 41));
+        const float u2 = to_unit_open_float(static_cast<std::uint32_t>(r >> 9) & 0x7FFFFFu);
+        const float rad = std::sqrt(-2.0f * std::log(u1));
+        const float th = 6.28318531f * u2;
+        out[i] = rad * std::cos(th);
+        out[i + 1] = rad * std::sin(th);
+    }
+    if (i < n) out[i] = static_cast<float>((*this)());
+}
+
+void UniformNoise::fill(double* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) out[i] = (*this)();
+}
+
+void UniformNoise::fill(float* out, std::size_t n) {
+    const float scale = static_cast<float>(kScale);
+    std::size_t i = 0;
+    for (; i + 1 < n; i += 2) {
+        const std::uint64_t r = eng_();
+        out[i] = scale * (to_unit_open_float(static_cast<std::uint32_t>(r >> 41)) - 0.5f);
+        out[i + 1] = scale * (to_unit_open_float(static_cast<std::uint32_t>(r >> 9) & 0x7FFFFFu) - 0.5f);
+    }
+    if (i < n) out[i] = static_cast<float>((*this)());
+}
+
+double inverse_normal_cdf(double u) {
+    // Acklam の有理近似（相対誤差 1.15e-9）を Halley 法で1回改良する
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    constexpr double kLow = 0.02425;
+    double x;
+    if (u < kLow) {
+        const double q = std::sqrt(-2.0 * std::log(u));
+        x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+            ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    } else if (u <= 1.0 - kLow) {
+        const double q = u - 0.5;
+        const double r = q * q;
+        x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+            (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+    } else {
+        const double q = std::sqrt(-2.0 * std::log1p(-u));
+        x = -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+            ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    const double e = 0.5 * std::erfc(-x / std::sqrt(2.0)) - u;
+    const double g = e * 2.506628274631000502 * std::exp(0.5 * x * x);  // e / φ(x)
+    return x - g / (1.0 + 0.5 * x * g);
+}
+
+void stratified_normals(Xoshiro256ss& eng, double* out, std::size_t n) {
+    // 層の番号を Fisher-Yates で並べ替えてから、各層の中の一様乱数を変換する
+    for (std::size_t i = 0; i < n; i++) out[i] = static_cast<double>(i);
+    for (std::size_t i = n; i > 1; i--) {
+        std::size_t j = static_cast<std::size_t>(to_unit_open(eng()) * i);
+        if (j >= i) j = i - 1;  // 丸めで i になる場合
+        const double tmp = out[i - 1];
+        out[i - 1] = out[j];
+        out[j] = tmp;
+    }
+    const double inv = 1.0 / static_cast<double>(n);
+    const double u_max = std::nextafter(1.0, 0.0);
+    for (std::size_t i = 0; i < n; i++) {
+        out[i] = inverse_normal_cdf(std::min((out[i] + to_unit_open(eng())) * inv, u_max));
+    }
+}
+
+std::uint64_t seed_from_time() {
+    std::uint64_t x = static_cast<std::uint64_t>(
+        std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    x ^= static_cast<std::uint64_t>(getpid()) << 32;
+    return splitmix64(x);
+}
+
+}  // namespace itphys
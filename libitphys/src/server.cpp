@@ -0,0 +1,490 @@
+/*
+ * server.cpp
+ *
+ * 常駐するシミュレーションサーバー（itphys/server.hpp を参照）
+ */
+
+#include "itphys/server.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "itphys/ensemble.hpp"
+#include "itphys/io.hpp"
+#include "itphys/observables.hpp"
+#include "itphys/rng.hpp"
+#include "itphys/thread_pool.hpp"
+
+namespace itphys {
+
+namespace {
+
+bool write_all(int fd, const char* p, std::size_t n) {
+    while (n > 0) {
+        const ssize_t k = ::write(fd, p, n);
+        if (k < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += k;
+        n -= static_cast<std::size_t>(k);
+    }
+    return true;
+}
+
+/** 1つの接続。複数のワーカーからの応答が混ざらないように書き込みを直列化する */
+class Connection {
+public:
+    Connection(int fd, bool owned) : fd_(fd), owned_(owned) {}
+    ~Connection() {
+        if (owned_) ::close(fd_);
+    }
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    void send(const std::string& s) {
+        std::lock_guard<std::mutex> lock(mu_);
+        write_all(fd_, s.data(), s.size());
+    }
+
+private:
+    int fd_;
+    bool owned_;
+    std::mutex mu_;
+};
+
+/** fd から1行ずつ読む（改行は含めない） */
+class LineReader {
+public:
+    explicit LineReader(int fd) : fd_(fd) {}
+
+    bool next(std::string& line) {
+        for (;;) {
+            const std::size_t nl = buf_.find('\n', pos_);
+            if (nl != std::string::npos) {
+                line.assign(buf_, pos_, nl - pos_);
+                pos_ = nl + 1;
+                return true;
+            }
+            buf_.erase(0, pos_);
+            pos_ = 0;
+            char chunk[1 << 16];
+            const ssize_t k = ::read(fd_, chunk, sizeof(chunk));
+            if (k < 0 && errno == EINTR) continue;
+            if (k <= 0) {
+                // 最後の行に改行がなくても1行として扱う
+                if (buf_.empty()) return false;
+                line.swap(buf_);
+                buf_.clear();
+                return true;
+            }
+            buf_.append(chunk, static_cast<std::size_t>(k));
+        }
+    }
+
+private:
+    int fd_;
+    std::string buf_;
+    std::size_t pos_ = 0;
+};
+
+bool parse_double(const std::string& s, double& out) {
+    char* end = nullptr;
+    errno = 0;
+    out = std::strtod(s.c_str(), &end);
+    return !s.empty() && *end == '\0' && errno == 0;
+}
+
+bool parse_u64(const std::string& s, std::uint64_t& out) {
+    char* end = nullptr;
+    errno = 0;
+    out = std::strtoull(s.c_str(), &end, 10);
+    return !s.empty() && s[0] != '-' && *end == '\0' && errno == 0;
+}
+
+/** open_memstream に書いた内容を文字列として受け取る */
+template <class Body>
+std::string capture(Body body) {
+    char* buf = nullptr;
+    std::size_t len = 0;
+    std::FILE* fp = open_memstream(&buf, &len);
+    if (!fp) throw std::runtime_error("open_memstream failed");
+    try {
+        body(fp);
+    } catch (...) {
+        std::fclose(fp);
+        std::free(buf);
+        throw;
+    }
+    std::fclose(fp);
+    std::string out(buf, len);
+    std::free(buf);
+    return out;
+}
+
+/** 各状態を5列の表に追加する sink */
+struct TableSink {
+    std::vector<double>& out;
+    void write(const ParticleState& s) { out.insert(out.end(), {s.t, s.x, s.y, s.vx, s.vy}); }
+};
+
+std::vector<double> ensemble_table(const Job& job, std::uint64_t seed) {
+    EnsembleOptions eo;
+    eo.n_particles = job.particles;
+    // stream を混ぜてブロックごとの乱数列 NormalRng(seed, ブロック番号) をずらす
+    std::uint64_t x = seed ^ (job.stream * 0x9E3779B97F4A7C15ULL);
+    eo.seed = job.stream ? splitmix64(x) : seed;
+    eo.n_threads = 1;  // 並列性はジョブ単位（スレッドプール）で得る
+    eo.integrator = job.integrator;
+    eo.variance_reduction = job.variance_reduction;
+    eo.force = job.force;
+    EnsembleObservables obs(static_cast<std::size_t>(job.p.n_steps) + 1);
+    run_ensemble(job.p, eo, &obs);
+
+    std::vector<double> out;
+    out.reserve(obs.msd.size() * kStateFields);
+    for (std::size_t i = 0; i < obs.msd.size(); i++) {
+        const bool reduced = i < obs.msd_reduced.size();
+        out.insert(out.end(), {obs.msd.time(i), reduced ? obs.msd_reduced[i].mean : obs.msd.at(i).mean(),
+                               reduced ? obs.msd_reduced[i].std_error : obs.msd.at(i).std_error(),
+                               obs.energy[i].mean(), obs.energy[i].std_error()});
+    }
+    return out;
+}
+
+/** 5列の表を応答の本体（テキストまたは BinarySink の形式）にする */
+std::string render(const Job& job, const double* rec, std::size_t n_records) {
+    return capture([&](std::FILE* fp) {
+        if (job.binary) {
+            BinarySink sink(fp);
+            sink.header();
+            for (std::size_t i = 0; i < n_records; i++, rec += kStateFields) {
+                sink.write(ParticleState{rec[0], rec[1], rec[2], rec[3], rec[4]});
+            }
+            return;
+        }
+        if (job.output == JobOutput::kEnsemble) {
+            std::fprintf(fp, "# t msd msd_err energy energy_err\n");
+        }
+        TextSink sink(fp);
+        if (job.output == JobOutput::kTrajectory) sink.header();
+        for (std::size_t i = 0; i < n_records; i++, rec += kStateFields) {
+            sink.write(ParticleState{rec[0], rec[1], rec[2], rec[3], rec[4]});
+        }
+    });
+}
+
+enum class LineResult { kContinue, kQuit };
+
+/** 1行を処理する。ジョブならプールに投入し、結果は conn に返す */
+LineResult handle_line(const std::string& raw, const std::shared_ptr<Connection>& conn,
+                       ThreadPool& pool, ResultCache* cache) {
+    std::string line = raw;
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    const std::size_t first = line.find_first_not_of(" \t");
+    if (first == std::string::npos || line[first] == '#') return LineResult::kContinue;
+    if (line.compare(first, std::string::npos, "quit") == 0) return LineResult::kQuit;
+    if (line.compare(first, std::string::npos, "ping") == 0) {
+        conn->send("# pong\n");
+        return LineResult::kContinue;
+    }
+
+    Job job;
+    std::string err;
+    if (!parse_job(line, job, err)) {
+        conn->send("# job " + job.id + " error " + err + "\n");
+        return LineResult::kContinue;
+    }
+    pool.submit([job, conn, cache] {
+        std::string reply;
+        try {
+            const std::string body = run_job(job, cache);
+            reply = "# job " + job.id + " ok " + std::to_string(body.size()) + "\n" + body;
+        } catch (const std::exception& e) {
+            reply = "# job " + job.id + " error " + e.what() + "\n";
+        }
+        conn->send(reply);
+    });
+    return LineResult::kContinue;
+}
+
+}  // namespace
+
+bool parse_job(const std::string& line, Job& job, std::string& err) {
+    std::istringstream in(line);
+    std::string tok;
+    while (in >> tok) {
+        const std::size_t eq = tok.find('=');
+        if (eq == std::string::npos) {
+            err = "expected key=value: " + tok;
+            return false;
+        }
+        const std::string key = tok.substr(0, eq);
+        const std::string val = tok.substr(eq + 1);
+        std::uint64_t u = 0;
+        bool ok = true;
+        if (key == "id") {
+            ok = !val.empty();
+            if (ok) job.id = val;
+        } else if (key == "T") {
+            ok = parse_double(val, job.p.T) && job.p.T >= 0.0;
+        } else if (key == "m") {
+            ok = parse_double(val, job.p.m) && job.p.m > 0.0;
+        } else if (key == "gamma") {
+            ok = parse_double(val, job.p.gamma) && job.p.gamma >= 0.0;
+        } else if (key == "kB") {
+            ok = parse_double(val, job.p.kB) && job.p.kB > 0.0;
+        } else if (key == "dt") {
+            ok = parse_double(val, job.p.dt) && job.p.dt > 0.0;
+        } else if (key == "n_steps") {
+            ok = parse_u64(val, u) && u <= (1ULL << 40);
+            job.p.n_steps = static_cast<long long>(u);
+        } else if (key == "seed") {
+            ok = parse_u64(val, job.seed);
+        } else if (key == "stream") {
+            ok = parse_u64(val, job.stream);
+        } else if (key == "particles") {
+            ok = parse_u64(val, u) && u >= 1;
+            job.particles = static_cast<std::size_t>(u);
+        } else if (key == "integrator") {
+            ok = parse_integrator(val, job.integrator);
+        } else if (key == "variance_reduction") {
+            ok = parse_variance_reduction(val, job.variance_reduction);
+        } else if (key == "force") {
+            ok = parse_force_field(val, job.force);
+        } else if (key == "output") {
+            if (val == "trajectory") {
+                job.output = JobOutput::kTrajectory;
+            } else if (val == "final") {
+                job.output = JobOutput::kFinal;
+            } else if (val == "ensemble") {
+                job.output = JobOutput::kEnsemble;
+            } else {
+                ok = false;
+            }
+        } else if (key == "format") {
+            ok = val == "text" || val == "binary";
+            job.binary = val == "binary";
+        } else {
+            err = "unknown key: " + key;
+            return false;
+        }
+        if (!ok) {
+            err = "invalid value: " + tok;
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string cache_key(const Job& job) {
+    static const char* const kOutputs[] = {"trajectory", "final", "ensemble"};
+    char buf[1024];
+    int n = std::snprintf(buf, sizeof(buf),
+                          "engine=%u T=%a m=%a gamma=%a kB=%a dt=%a n_steps=%lld seed=%llu "
+                          "stream=%llu output=%s",
+                          kEngineVersion, job.p.T, job.p.m, job.p.gamma, job.p.kB, job.p.dt,
+                          job.p.n_steps, (unsigned long long)job.seed,
+                          (unsigned long long)job.stream, kOutputs[static_cast<int>(job.output)]);
+    // 粒子数と積分器と分散低減は run_ensemble だけが使う（分散低減なしのキーは前と同じ）
+    if (job.output == JobOutput::kEnsemble) {
+        n += std::snprintf(buf + n, sizeof(buf) - n, " particles=%zu integrator=%s", job.particles,
+                           integrator_name(job.integrator));
+        if (job.variance_reduction.any()) {
+            n += std::snprintf(buf + n, sizeof(buf) - n, " variance_reduction=%s",
+                               variance_reduction_name(job.variance_reduction).c_str());
+        }
+    }
+    // 外力がなければキーは前と同じ
+    if (job.force.any()) {
+        std::snprintf(buf + n, sizeof(buf) - n, " force=%s", force_field_name(job.force).c_str());
+    }
+    return buf;
+}
+
+std::vector<double> run_table(const Job& job) {
+    const std::uint64_t seed = job.seed ? job.seed : seed_from_time();
+    if (job.output == JobOutput::kEnsemble) return ensemble_table(job, seed);
+
+    NormalRng rng(seed, job.stream);
+    std::vector<double> out;
+    if (job.output == JobOutput::kFinal) {
+        NullSink sink;
+        TableSink{out}.write(run_brownian_motion(job.p, rng, sink, job.force));
+    } else {
+        out.reserve((static_cast<std::size_t>(job.p.n_steps) + 1) * kStateFields);
+        TableSink sink{out};
+        run_brownian_motion(job.p, rng, sink, job.force);
+    }
+    return out;
+}
+
+std::string run_job(const Job& job, ResultCache* cache) {
+    // 時刻から決めたシードの結果は再現できないのでキャッシュしない
+    if (!cache || job.seed == 0) {
+        const std::vector<double> t = run_table(job);
+        return render(job, t.data(), t.size() / kStateFields);
+    }
+
+    const std::string key = cache_key(job);
+    CacheEntry hit;
+    if (cache->find(key, hit) && hit.n_fields() == kStateFields && !cache->verify()) {
+        // BinarySink の形式で保存してあるので、バイナリならそのまま返せる
+        if (job.binary) return std::string(hit.binary(), hit.binary_size());
+        return render(job, hit.records(), hit.n_records());
+    }
+
+    const std::vector<double> t = run_table(job);
+    const std::size_t n = t.size() / kStateFields;
+    if (hit.mapped()) {
+        // 検証モード: 保存してある結果とビット単位で比べる
+        if (hit.n_records() == n && std::memcmp(hit.records(), t.data(), t.size() * sizeof(double)) == 0) {
+            return render(job, t.data(), n);
+        }
+        std::fprintf(stderr, "# cache mismatch (replaced): %s\n", key.c_str());
+    }
+    cache->store(key, t.data(), n);
+    return render(job, t.data(), n);
+}
+
+bool serve_stream(int in_fd, int out_fd, int n_threads, ResultCache* cache) {
+    ThreadPool pool(n_threads);
+    auto conn = std::make_shared<Connection>(out_fd, false);
+    LineReader reader(in_fd);
+    std::string line;
+    bool quit = false;
+    while (!quit && reader.next(line)) {
+        quit = handle_line(line, conn, pool, cache) == LineResult::kQuit;
+    }
+    pool.wait_idle();
+    return quit;
+}
+
+int serve_unix_socket(const std::string& path, int n_threads, ResultCache* cache) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::fprintf(stderr, "socket path too long: %s\n", path.c_str());
+        return 1;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    const int lfd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lfd < 0) {
+        std::perror("socket");
+        return 1;
+    }
+    ::unlink(path.c_str());
+    if (::bind(lfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(lfd, 64) < 0) {
+        std::perror(path.c_str());
+        ::close(lfd);
+        return 1;
+    }
+    // 切断したクライアントへの書き込みでプロセスが終了しないようにする
+    std::signal(SIGPIPE, SIG_IGN);
+
+    ThreadPool pool(n_threads);
+    std::atomic<bool> quit(false);
+    std::mutex mu;
+    std::condition_variable readers_done;
+    std::vector<int> open_fds;  // 読み取り中の接続（読み取りのスレッドが終わるときに自分で消す）
+    while (!quit) {
+        const int fd = ::accept(lfd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;  // quit で shutdown された
+        }
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            open_fds.push_back(fd);
+        }
+        // 接続ごとに読み取り用のスレッドを作り、ジョブは共有のプールで実行する。
+        // 接続は最後の応答を書き終えたときに閉じる。長く動かしても終わったスレッドが溜まらないように
+        // detach し、終了時は open_fds が空になるのを待つ
+        std::thread([fd, lfd, cache, &pool, &quit, &mu, &readers_done, &open_fds] {
+            {
+                auto conn = std::make_shared<Connection>(fd, true);
+                LineReader reader(fd);
+                std::string line;
+                while (reader.next(line)) {
+                    if (handle_line(line, conn, pool, cache) == LineResult::kQuit) {
+                        quit = true;
+                        ::shutdown(lfd, SHUT_RDWR);
+                        break;
+                    }
+                }
+            }
+            // これ以降は serve_unix_socket のローカル変数に触らない（待っている側が戻ってよい）
+            std::lock_guard<std::mutex> lock(mu);
+            open_fds.erase(std::find(open_fds.begin(), open_fds.end(), fd));
+            readers_done.notify_all();
+        }).detach();
+    }
+    // 残りの接続の読み取りを止め（書き込みはできるので実行中のジョブの結果は届く）、全て終わるまで待つ
+    {
+        std::unique_lock<std::mutex> lock(mu);
+        for (int fd : open_fds) ::shutdown(fd, SHUT_RD);
+        readers_done.wait(lock, [&open_fds] { return open_fds.empty(); });
+    }
+    pool.wait_idle();
+    ::close(lfd);
+    ::unlink(path.c_str());
+    return 0;
+}
+
+CacheVerifyResult verify_cache(const ResultCache& cache, std::FILE* log) {
+    CacheVerifyResult r;
+    char prefix[32];
+    std::snprintf(prefix, sizeof(prefix), "engine=%u ", kEngineVersion);
+    cache.for_each([&](const std::string& path) {
+        CacheEntry e;
+        if (!e.map(path)) {
+            r.invalid++;
+            std::fprintf(log, "invalid  %s\n", path.c_str());
+            return;
+        }
+        const std::string key = e.key();
+        if (key.compare(0, std::strlen(prefix), prefix) != 0) {
+            r.stale++;
+            std::fprintf(log, "stale    %s  %s\n", path.c_str(), key.c_str());
+            return;
+        }
+        Job job;
+        std::string err;
+        if (!parse_job(key.substr(std::strlen(prefix)), job, err) || job.seed == 0 ||
+            e.n_fields() != kStateFields) {
+            r.invalid++;
+            std::fprintf(log, "invalid  %s  %s\n", path.c_str(), key.c_str());
+            return;
+        }
+        const std::vector<double> t = run_table(job);
+        if (e.n_records() * kStateFields == t.size() &&
+            std::memcmp(e.records(), t.data(), t.size() * sizeof(double)) == 0) {
+            r.ok++;
+        } else {
+            r.mismatch++;
+            std::fprintf(log, "mismatch %s  %s\n", path.c_str(), key.c_str());
+        }
+    });
+    return r;
+}
+
+}  // namespace itphys
@@ -0,0 +1,315 @@
+/*
+ * suspension.cpp
+ *
+ * 相互作用するブラウン粒子（itphys/suspension.hpp を参照）
+ */
+
+#include "itphys/suspension.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "itphys/ensemble.hpp"
+#include "itphys/force.hpp"
+#include "itphys/instrument.hpp"
+
+namespace itphys {
+
+namespace {
+
+constexpr std::size_t kBlock = EulerIntegrator::kNoiseBlock;
+
+/** WCA と Lennard-Jones（カットオフとエネルギーのずらし量だけが違う） */
+struct LjPair {
+    double eps4, sigma2, shift;
+
+    /** |F| / r */
+    double force_over_r(double r2) const {
+        const double s2 = sigma2 / r2;
+        const double s6 = s2 * s2 * s2;
+        return 6.0 * eps4 * s6 * (2.0 * s6 - 1.0) / r2;
+    }
+    double energy(double r2) const {
+        const double s2 = sigma2 / r2;
+        const double s6 = s2 * s2 * s2;
+        return eps4 * s6 * (s6 - 1.0) - shift;
+    }
+};
+
+/** Yukawa U = A e^{-κr}/r（A = εσ e^{κσ}） */
+struct YukawaPair {
+    double amp, kappa, shift;
+
+    double force_over_r(double r2) const {
+        const double r = std::sqrt(r2);
+        return amp * std::exp(-kappa * r) * (1.0 + kappa * r) / (r2 * r);
+    }
+    double energy(double r2) const {
+        const double r = std::sqrt(r2);
+        return amp * std::exp(-kappa * r) / r - shift;
+    }
+};
+
+/** pair.kind に合う対ポテンシャルで body(pair) を呼ぶ */
+template <class Body>
+void visit_pair(const PairParams& pp, Body&& body) {
+    const double rc = pp.cutoff_radius();
+    if (pp.kind == PairPotential::kYukawa) {
+        YukawaPair y{pp.epsilon * pp.sigma * std::exp(pp.kappa * pp.sigma), pp.kappa, 0.0};
+        y.shift = y.energy(rc * rc);
+        body(y);
+    } else {
+        LjPair lj{4.0 * pp.epsilon, pp.sigma * pp.sigma, 0.0};
+        lj.shift = lj.energy(rc * rc);
+        body(lj);
+    }
+}
+
+/** a を a[perm[k]] の順に並べ替える */
+template <class T>
+void permute(std::vector<T>& a, const std::vector<std::size_t>& perm, std::vector<T>& tmp) {
+    tmp.resize(a.size());
+    for (std::size_t k = 0; k < perm.size(); k++) tmp[k] = a[perm[k]];
+    a.swap(tmp);
+}
+
+}  // namespace
+
+double PairParams::cutoff_radius() const {
+    if (cutoff > 0.0) return cutoff;
+    switch (kind) {
+        case PairPotential::kLennardJones: return 2.5 * sigma;
+        case PairPotential::kYukawa: return sigma + 5.0 / kappa;
+        default: return std::pow(2.0, 1.0 / 6.0) * sigma;
+    }
+}
+
+Suspension::Suspension(const LangevinParams& p, const SuspensionOptions& opt)
+    : p_(p),
+      pair_(opt.pair),
+      integ_(p),
+      n_threads_(opt.n_threads > 0 ? opt.n_threads : max_threads()) {
+    const std::size_t n = opt.n_particles;
+    if (n == 0 || n > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::invalid_argument("suspension: bad number of particles");
+    }
+    if (!(opt.density > 0.0) || !(pair_.sigma > 0.0) || !(pair_.skin >= 0.0) ||
+        (pair_.kind == PairPotential::kYukawa && !(pair_.kappa > 0.0))) {
+        throw std::invalid_argument("suspension: density, sigma and kappa must be positive");
+    }
+    box_ = std::sqrt(n / opt.density);
+    if (box_ < 3.0 * (pair_.cutoff_radius() + pair_.skin)) {
+        throw std::invalid_argument("suspension: box is smaller than 3 neighbor cells");
+    }
+
+    // 正方格子に並べる（nx² >= n なので最後の行は埋まらないことがある）
+    const std::size_t nx = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(n))));
+    const double a = box_ / nx;
+    x_.resize(n);
+    y_.resize(n);
+    id_.resize(n);
+    for (std::size_t i = 0; i < n; i++) {
+        x_[i] = (i % nx + 0.5) * a;
+        y_[i] = (i / nx + 0.5) * a;
+        id_[i] = static_cast<std::uint32_t>(i);
+    }
+    vx_.assign(n, 0.0);
+    vy_.assign(n, 0.0);
+    fx_.assign(n, 0.0);
+    fy_.assign(n, 0.0);
+    x0_ = x_;
+    y0_ = y_;
+    const std::size_t n_blocks = (n + kBlock - 1) / kBlock;
+    rngs_.reserve(n_blocks);
+    for (std::size_t k = 0; k < n_blocks; k++) rngs_.emplace_back(opt.seed, k);
+
+    build_neighbors();
+    compute_forces();
+}
+
+void Suspension::build_neighbors() {
+    ITPHYS_PHASE(kStep);
+    const std::size_t n = size();
+    const double rl = pair_.cutoff_radius() + pair_.skin;
+    const double rl2 = rl * rl;
+    const long nc = static_cast<long>(box_ / rl);  // 1辺のセルの数（>= 3）
+    const double inv_cell = nc / box_;
+    const double inv_box = 1.0 / box_;
+
+    // 1. セルの番号で数え上げソートし、全ての配列をその順に並べ替える
+    std::vector<std::uint32_t> cell(n);
+#pragma omp parallel for num_threads(n_threads_) schedule(static)
+    for (std::size_t i = 0; i < n; i++) {
+        const double xw = x_[i] - box_ * std::floor(x_[i] * inv_box);
+        const double yw = y_[i] - box_ * std::floor(y_[i] * inv_box);
+        const long cx = std::min(nc - 1, static_cast<long>(xw * inv_cell));
+        const long cy = std::min(nc - 1, static_cast<long>(yw * inv_cell));
+        cell[i] = static_cast<std::uint32_t>(cy * nc + cx);
+    }
+    std::vector<std::size_t> cell_start(static_cast<std::size_t>(nc * nc) + 1, 0);
+    for (std::size_t i = 0; i < n; i++) cell_start[cell[i] + 1]++;
+    for (std::size_t c = 0; c + 1 < cell_start.size(); c++) cell_start[c + 1] += cell_start[c];
+    std::vector<std::size_t> perm(n);
+    {
+        std::vector<std::size_t> pos(cell_start.begin(), cell_start.end() - 1);
+        for (std::size_t i = 0; i < n; i++) perm[pos[cell[i]]++] = i;
+    }
+    std::vector<double> tmp;
+    for (std::vector<double>* a : {&x_, &y_, &vx_, &vy_, &x0_, &y0_}) permute(*a, perm, tmp);
+    std::vector<std::uint32_t> tmp_id;
+    permute(id_, perm, tmp_id);
+    permute(cell, perm, tmp_id);
+    xref_ = x_;
+    yref_ = y_;
+
+    // 2. 自分と隣の 9 セルから距離 rl 以内の粒子を探す（数えるパスと書くパス）
+    const auto for_each_neighbor = [&](std::size_t i, auto&& visit) {
+        const long cx = cell[i] % nc;
+        const long cy = cell[i] / nc;
+        for (long dy = -1; dy <= 1; dy++) {
+            const long row = (cy + dy + nc) % nc * nc;
+            for (long dx = -1; dx <= 1; dx++) {
+                const std::size_t c = static_cast<std::size_t>(row + (cx + dx + nc) % nc);
+                for (std::size_t j = cell_start[c]; j < cell_start[c + 1]; j++) {
+                    double ddx = x_[i] - x_[j];
+                    double ddy = y_[i] - y_[j];
+                    ddx -= box_ * nearest_integer(ddx * inv_box);
+                    ddy -= box_ * nearest_integer(ddy * inv_box);
+                    if (j != i && ddx * ddx + ddy * ddy < rl2) visit(j);
+                }
+            }
+        }
+    };
+    start_.assign(n + 1, 0);
+#pragma omp parallel for num_threads(n_threads_) schedule(static)
+    for (std::size_t i = 0; i < n; i++) {
+        std::size_t count = 0;
+        for_each_neighbor(i, [&count](std::size_t) { count++; });
+        start_[i + 1] = count;
+    }
+    for (std::size_t i = 0; i < n; i++) start_[i + 1] += start_[i];
+    neigh_.resize(start_[n]);
+#pragma omp parallel for num_threads(n_threads_) schedule(static)
+    for (std::size_t i = 0; i < n; i++) {
+        std::uint32_t* out = neigh_.data() + start_[i];
+        for_each_neighbor(i, [&out](std::size_t j) { *out++ = static_cast<std::uint32_t>(j); });
+    }
+    rebuilds_++;
+}
+
+void Suspension::compute_forces() {
+    ITPHYS_PHASE(kStep);
+    const std::size_t n = size();
+    const double rc = pair_.cutoff_radius();
+    const double rc2 = rc * rc;
+    const double inv_box = 1.0 / box_;
+    visit_pair(pair_, [&](const auto& pair) {
+        // 粒子 i の力は i を受け持つスレッドだけが書く
+#pragma omp parallel for num_threads(n_threads_) schedule(static)
+        for (std::size_t i = 0; i < n; i++) {
+            const double xi = x_[i], yi = y_[i];
+            double fx = 0.0, fy = 0.0;
+            for (std::size_t k = start_[i]; k < start_[i + 1]; k++) {
+                const std::uint32_t j = neigh_[k];
+                double dx = xi - x_[j];
+                double dy = yi - y_[j];
+                dx -= box_ * nearest_integer(dx * inv_box);
+                dy -= box_ * nearest_integer(dy * inv_box);
+                const double r2 = dx * dx + dy * dy;
+                if (r2 < rc2) {
+                    const double f = pair.force_over_r(r2);
+                    fx += f * dx;
+                    fy += f * dy;
+                }
+            }
+            fx_[i] = fx;
+            fy_[i] = fy;
+        }
+    });
+}
+
+void Suspension::step(long long n_steps) {
+    const std::size_t n = size();
+    const std::size_t n_blocks = rngs_.size();
+    const double limit = 0.25 * pair_.skin * pair_.skin;  // (skin/2)²
+    for (long long s = 0; s < n_steps; s++) {
+        double max_d2 = 0.0;
+#pragma omp parallel num_threads(n_threads_) reduction(max : max_d2)
+        {
+            double eta[2 * kBlock];
+#pragma omp for schedule(static)
+            for (std::size_t k = 0; k < n_blocks; k++) {
+                const std::size_t i0 = k * kBlock;
+                const std::size_t b = std::min(kBlock, n - i0);
+                {
+                    ITPHYS_PHASE(kRng);
+                    rngs_[k].fill(eta, 2 * b);
+                }
+                ITPHYS_PHASE(kStep);
+                integ_.step_block(x_.data() + i0, y_.data() + i0, vx_.data() + i0, vy_.data() + i0,
+                                  fx_.data() + i0, fy_.data() + i0, eta, b);
+                // 近傍リストを作ってからの移動距離
+                for (std::size_t i = i0; i < i0 + b; i++) {
+                    const double dx = x_[i] - xref_[i];
+                    const double dy = y_[i] - yref_[i];
+                    max_d2 = std::max(max_d2, dx * dx + dy * dy);
+                }
+                ITPHYS_COUNT(kSteps, b);
+                ITPHYS_COUNT(kSamples, 2 * b);
+            }
+        }
+        t_ += p_.dt;
+        if (max_d2 > limit) build_neighbors();
+        compute_forces();
+    }
+}
+
+double Suspension::msd() const {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < size(); i++) {
+        const double dx = x_[i] - x0_[i];
+        const double dy = y_[i] - y0_[i];
+        sum += dx * dx + dy * dy;
+    }
+    return sum / size();
+}
+
+double Suspension::kinetic_energy() const {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < size(); i++) sum += vx_[i] * vx_[i] + vy_[i] * vy_[i];
+    return 0.5 * p_.m * sum / size();
+}
+
+double Suspension::potential_energy() const {
+    const std::size_t n = size();
+    const double rc = pair_.cutoff_radius();
+    const double rc2 = rc * rc;
+    const double inv_box = 1.0 / box_;
+    // ブロックごとの和を固定した順に足すので、結果はスレッド数に依らない
+    std::vector<double> partial((n + kBlock - 1) / kBlock, 0.0);
+    visit_pair(pair_, [&](const auto& pair) {
+#pragma omp parallel for num_threads(n_threads_) schedule(static)
+        for (std::size_t k = 0; k < partial.size(); k++) {
+            double u = 0.0;
+            for (std::size_t i = k * kBlock; i < std::min(n, (k + 1) * kBlock); i++) {
+                for (std::size_t m = start_[i]; m < start_[i + 1]; m++) {
+                    const std::uint32_t j = neigh_[m];
+                    double dx = x_[i] - x_[j];
+                    double dy = y_[i] - y_[j];
+                    dx -= box_ * nearest_integer(dx * inv_box);
+                    dy -= box_ * nearest_integer(dy * inv_box);
+                    const double r2 = dx * dx + dy * dy;
+                    if (r2 < rc2) u += pair.energy(r2);
+                }
+            }
+            partial[k] = u;
+        }
+    });
+    double sum = 0.0;
+    for (double u : partial) sum += u;
+    return 0.5 * sum / n;  // 各対を i-j と j-i で2回数えている
+}
+
+}  // namespace itphys
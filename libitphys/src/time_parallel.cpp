@@ -0,0 +1,136 @@
+/*
+ * time_parallel.cpp
+ *
+ * 1本の長い軌道の時間方向の並列計算（itphys/time_parallel.hpp を参照）
+ */
+
+#include "itphys/time_parallel.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "itphys/ensemble.hpp"
+#include "itphys/instrument.hpp"
+#include "itphys/io.hpp"
+#include "itphys/rng.hpp"
+
+namespace itphys {
+
+namespace {
+
+constexpr std::size_t kNoise = 2 * EulerIntegrator::kNoiseBlock;  // 一度に作る乱数の個数
+
+/** A^j を (r, v) に掛けたときの係数: r' = r + R v, v' = V v */
+struct Propagator {
+    double R = 0.0, V = 1.0;
+};
+
+/** A^m A^n = A^(m+n): R = R_n + R_m V_n, V = V_m V_n */
+Propagator compose(const Propagator& m, const Propagator& n) { return {n.R + m.R * n.V, m.V * n.V}; }
+
+/** A^j を二乗を繰り返して求める（A はノイズなしで (r, v) = (0, 1) を1ステップ進めたもの） */
+Propagator power(const EulerIntegrator& integ, long long j) {
+    Propagator a;
+    integ.step(a.R, a.V, 0.0);
+    Propagator result;
+    for (; j > 0; j >>= 1) {
+        if (j & 1) result = compose(result, a);
+        a = compose(a, a);
+    }
+    return result;
+}
+
+}  // namespace
+
+ParticleState run_time_parallel(const LangevinParams& p, const TimeParallelOptions& opt,
+                                double* out, ParticleState init) {
+    const EulerIntegrator integ(p);
+    const long long n = p.n_steps;
+    const long long L = std::max(1LL, std::min(opt.chunk, std::max(n, 1LL)));
+    const long long n_chunks = (n + L - 1) / L;
+    const int n_threads = opt.n_threads > 0 ? opt.n_threads : max_threads();
+
+    if (out) {
+        out[0] = init.t;
+        out[1] = init.x;
+        out[2] = init.y;
+        out[3] = init.vx;
+        out[4] = init.vy;
+    }
+    if (n <= 0) return init;
+
+    // 1. 各チャンクを計算する。最初のチャンクは init から（これはそのまま正しい解）、
+    //    それ以外は位置・速度 0 から（局所解）
+    std::vector<ParticleState> local_end(static_cast<std::size_t>(n_chunks));
+#pragma omp parallel num_threads(n_threads)
+    {
+        double eta[kNoise];
+#pragma omp for schedule(static)
+        for (long long k = 0; k < n_chunks; k++) {
+            NormalRng rng(opt.seed, static_cast<std::uint64_t>(k));
+            const long long len = std::min(L, n - k * L);
+            ParticleState s;
+            if (k == 0) {
+                s = init;
+            } else {
+                s.t = init.t + static_cast<double>(k * L) * p.dt;
+            }
+            double* rec = out ? out + (k * L + 1) * kStateFields : nullptr;
+            for (long long j = 0; j < len;) {
+                const long long m = std::min<long long>(len - j, kNoise / 2);
+                {
+                    ITPHYS_PHASE(kRng);
+                    rng.fill(eta, static_cast<std::size_t>(2 * m));
+                }
+                ITPHYS_PHASE(kStep);
+                for (long long i = 0; i < m; i++, j++) {
+                    integ.step(s, eta[2 * i], eta[2 * i + 1]);
+                    if (rec) {
+                        rec[0] = s.t;
+                        rec[1] = s.x;
+                        rec[2] = s.y;
+                        rec[3] = s.vx;
+                        rec[4] = s.vy;
+                        rec += kStateFields;
+                    }
+                }
+            }
+            local_end[k] = s;
+            ITPHYS_COUNT(kSteps, len);
+            ITPHYS_COUNT(kSamples, 2 * len);
+        }
+    }
+
+    // 2. チャンクの始点の状態を順に求める: S_1 = (最初のチャンクの終点),
+    //    S_{k+1} = A^len S_k + (局所解の終点)
+    std::vector<ParticleState> start(static_cast<std::size_t>(n_chunks) + 1);
+    start[1] = local_end[0];
+    for (long long k = 1; k < n_chunks; k++) {
+        const Propagator ak = power(integ, std::min(L, n - k * L));
+        const ParticleState& s = start[k];
+        const ParticleState& e = local_end[k];
+        start[k + 1] = ParticleState{e.t, s.x + ak.R * s.vx + e.x, s.y + ak.R * s.vy + e.y,
+                                     ak.V * s.vx + e.vx, ak.V * s.vy + e.vy};
+    }
+
+    // 3. 2番目以降のチャンクの各時刻の局所解に A^j S_k を足す（A^j は1ステップずつ進めて作る）
+    if (out && n_chunks > 1) {
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+        for (long long k = 1; k < n_chunks; k++) {
+            const ParticleState& s = start[k];
+            const long long len = std::min(L, n - k * L);
+            double* rec = out + (k * L + 1) * kStateFields;
+            Propagator a;
+            for (long long j = 1; j <= len; j++, rec += kStateFields) {
+                integ.step(a.R, a.V, 0.0);
+                rec[1] += s.x + a.R * s.vx;
+                rec[2] += s.y + a.R * s.vy;
+                rec[3] += a.V * s.vx;
+                rec[4] += a.V * s.vy;
+            }
+        }
+    }
+    return start[n_chunks];
+}
+
+}  // namespace itphys
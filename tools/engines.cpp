@@ -0,0 +1,507 @@
+/*
+ * engines.cpp
+ *
+ * libitphys の研究用エンジンを動かすプログラム（問題1のレポートの集計は report1_haruki を使う）
+ *
+ * 使い方:
+ *   マルチレベル・モンテカルロ法で目標の RMS 誤差まで推定（itphys/mlmc.hpp）:
+ *     ./itphys_engines mlmc <rmse> [T] [m] [gamma] [dt0] [n_steps0] [--integrator euler|baoab]
+ *                      [--observable msd|energy|diffusion]
+ *     省略時: dt0=0.2, n_steps0=t_end/dt0（t_end = 10）、observable=msd
+ *   相互作用する N 粒子の分散系（周期境界、itphys/suspension.hpp）:
+ *     ./itphys_engines suspension [N] [density] [T] [m] [gamma] [dt] [n_steps]
+ *                      [--pair wca|lj|yukawa] [--epsilon E] [--sigma S] [--kappa K] [--cutoff RC]
+ *                      [--skin D] [--every K] [--threads N] [--seed S]
+ *     省略時: N=10000, density=0.5, dt=0.002, n_steps=1000, pair=wca、K=100 ステップごとに
+ *     "t msd kinetic potential rebuilds steps_per_s" を出力する
+ *   流体力学的相互作用のある N 粒子の過減衰ブラウン動力学（RPY、itphys/hydrodynamics.hpp）:
+ *     ./itphys_engines bdhi [N] [T] [m] [gamma] [dt] [n_steps] [--radius A] [--spacing S]
+ *                      [--force SPEC] [--tol EPS] [--max-krylov M] [--every K] [--threads N] [--seed S]
+ *     （m は使わない）省略時: N=1000, n_steps=100, radius=0.5, spacing=2.0, tol=1e-4、K=10 ステップごとに
+ *     "t msd center_x center_y krylov_mean steps_per_s" を出力する
+ *   記憶のある摩擦の一般化ランジュバン方程式（プロニー級数、itphys/gle.hpp）:
+ *     ./itphys_engines gle [N] [T] [m] [gamma] [dt] [n_steps] [--kernel G:TAU,...] [--force SPEC]
+ *                      [--every K] [--threads N] [--seed S]
+ *     （gamma は記憶のない摩擦 γ0）省略時: N=10000, kernel=1:1、K=100 ステップごとに
+ *     "t msd msd_theory vacf vacf_theory kinetic aux_temperature steps_per_s" を出力する
+ *     （理論値は外力がないときだけ）
+ *   自己推進する粒子（アクティブ・ブラウン粒子、itphys/active.hpp）:
+ *     ./itphys_engines active [N] [T] [m] [gamma] [dt] [n_steps] [--v0 V] [--rot-diffusion DR]
+ *                      [--noise gaussian|uniform] [--force SPEC] [--every K] [--threads N] [--seed S]
+ *     省略時: N=10000, v0=1, DR=1、K=100 ステップごとに "t msd msd_theory kinetic kinetic_theory steps_per_s"
+ *     を出力し、最後に後半の MSD の傾きの D と D_eff = kBT/γ + v0²/(2 DR) を比べる（理論値は外力がないときだけ。
+ *     傾きは K に依らず n_steps/100 ステップごとの MSD から求め、後半の点が2個未満なら nan）
+ *   初通過時間の分布（吸収された粒子はそこで計算をやめる、itphys/first_passage.hpp）:
+ *     ./itphys_engines fpt [n_walkers] [T] [m] [gamma] [dt] [--condition radius|barrier] [--threshold R]
+ *                      [--start-x X0] [--start-y Y0] [--t-max T] [--bins N] [--lanes refill|mask]
+ *                      [--n-lanes L] [--force SPEC] [--threads N] [--seed S]
+ *     省略時: n_walkers=100000, radius, R=3, t_max=100, bins=100, refill、L=16384。
+ *     "t density density_err" のヒストグラムと、平均の初通過時間・打ち切りの数・レーンの使用率を出力する
+ *   位置引数の T, m, gamma, dt, n_steps は report1_haruki と同じ順番（省略時は LangevinParams の既定値）
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "itphys/active.hpp"
+#include "itphys/first_passage.hpp"
+#include "itphys/force.hpp"
+#include "itphys/gle.hpp"
+#include "itphys/hydrodynamics.hpp"
+#include "itphys/langevin.hpp"
+#include "itphys/mlmc.hpp"
+#include "itphys/observables.hpp"
+#include "itphys/suspension.hpp"
+
+namespace {
+
+/**
+ * MLMC モード: レベルごとの集計と、3つの観測量の推定値・統計誤差を出力
+ * 出力形式: # level dt n_steps samples cost_per_sample mean_diff var_diff（control の観測量）
+ */
+int run_mlmc_mode(const itphys::LangevinParams &p, const itphys::MlmcOptions &opt) {
+    itphys::MlmcResult r;
+    try {
+        r = itphys::run_mlmc(p, opt);
+    } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    const int q = opt.control;
+    std::printf("# level dt n_steps samples cost_per_sample mean_diff var_diff  (%s)\n",
+                itphys::mlmc_observable_name(q));
+    for (std::size_t l = 0; l < r.levels.size(); l++) {
+        const itphys::MlmcLevel &lev = r.levels[l];
+        std::printf("%zu %.6e %lld %llu %.6e %.6e %.6e\n", l, lev.dt, lev.n_steps,
+                    (unsigned long long)lev.samples, lev.cost, lev.diff[q].mean(), lev.diff[q].variance());
+    }
+    const double t_end = p.n_steps * p.dt;
+    for (int k = 0; k < itphys::kMlmcObservables; k++) {
+        std::printf("# %s(t_end = %g) = %.6f +- %.6f\n", itphys::mlmc_observable_name(k), t_end, r.mean[k],
+                    r.std_error[k]);
+    }
+    std::printf("# msd_exact = %.6f (from rest)  bias = %.3e  target_rmse = %g  converged = %d\n",
+                itphys::theoretical_msd_from_rest(t_end, p), r.bias, opt.target_rmse, r.converged ? 1 : 0);
+    std::printf("# cost = %.4e particle-steps  (plain MC at the finest dt: %.4e, %.1fx)\n", r.cost,
+                r.cost_mc, r.cost > 0.0 ? r.cost_mc / r.cost : 0.0);
+    return 0;
+}
+
+/**
+ * 分散系モード: every ステップごとに1粒子あたりの MSD・運動エネルギー・ポテンシャルエネルギーと、
+ * 近傍リストを作った回数、その区間の計算速度（ステップ/秒）を出力
+ */
+int run_suspension(const itphys::LangevinParams &p, const itphys::SuspensionOptions &opt, long long every) {
+    try {
+        itphys::Suspension s(p, opt);
+        std::printf("# N = %zu  box = %.6f  pair = %s  cutoff = %.6f  skin = %.6f\n", s.size(), s.box(),
+                    itphys::pair_potential_name(opt.pair.kind), opt.pair.cutoff_radius(), opt.pair.skin);
+        std::printf("# t msd kinetic potential rebuilds steps_per_s\n");
+        std::printf("%.10e %.10e %.10e %.10e %lld 0\n", s.time(), s.msd(), s.kinetic_energy(),
+                    s.potential_energy(), s.rebuilds());
+        for (long long done = 0; done < p.n_steps;) {
+            const long long k = std::min(every, p.n_steps - done);
+            const auto t0 = std::chrono::steady_clock::now();
+            s.step(k);
+            const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            done += k;
+            std::printf("%.10e %.10e %.10e %.10e %lld %.3f\n", s.time(), s.msd(), s.kinetic_energy(),
+                        s.potential_energy(), s.rebuilds(), k / sec);
+            std::fflush(stdout);
+        }
+    } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * BD-HI モード: every ステップごとに1粒子あたりの MSD、重心の位置、その区間のランチョス法の
+ * 平均反復回数と計算速度（ステップ/秒）を出力
+ */
+int run_bdhi(const itphys::LangevinParams &p, const itphys::HydroOptions &opt, long long every) {
+    try {
+        itphys::HydroBrownian s(p, opt);
+        std::printf("# N = %zu  radius = %.6f  spacing = %.6f  force = %s  tol = %g\n", s.size(), opt.radius,
+                    opt.spacing, itphys::force_field_name(opt.force).c_str(), opt.tolerance);
+        std::printf("# t msd center_x center_y krylov_mean steps_per_s\n");
+        std::printf("%.10e %.10e %.10e %.10e 0 0\n", s.time(), s.msd(), s.center_x(), s.center_y());
+        for (long long done = 0; done < p.n_steps;) {
+            const long long k = std::min(every, p.n_steps - done);
+            const double before = s.mean_krylov() * done;
+            const auto t0 = std::chrono::steady_clock::now();
+            s.step(k);
+            const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            done += k;
+            std::printf("%.10e %.10e %.10e %.10e %.2f %.3f\n", s.time(), s.msd(), s.center_x(), s.center_y(),
+                        (s.mean_krylov() * done - before) / k, k / sec);
+            std::fflush(stdout);
+        }
+        std::printf("# krylov iterations: mean %.2f  max %d\n", s.mean_krylov(), s.max_krylov());
+    } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * 一般化ランジュバン方程式モード: 平衡状態から始めた N 粒子の MSD と速度自己相関を理論値と比べる
+ */
+int run_gle(const itphys::LangevinParams &p, const itphys::GleOptions &opt, long long every) {
+    try {
+        itphys::GleEnsemble g(p, opt);
+        const bool free = !opt.force.any();
+        const auto theory = [&](double (*f)(const itphys::LangevinParams &, const itphys::MemoryKernel &, double)) {
+            return free ? f(p, opt.kernel, g.time()) : std::nan("");
+        };
+        std::printf("# N = %zu  gamma0 = %.6f  kernel = %s  force = %s  D_theory = %.6f\n", g.size(), p.gamma,
+                    itphys::memory_kernel_name(opt.kernel).c_str(), itphys::force_field_name(opt.force).c_str(),
+                    p.kB * p.T / (p.gamma + opt.kernel.static_friction()));
+        std::printf("# t msd msd_theory vacf vacf_theory kinetic aux_temperature steps_per_s\n");
+        for (long long done = 0; done < p.n_steps;) {
+            const long long k = std::min(every, p.n_steps - done);
+            const auto t0 = std::chrono::steady_clock::now();
+            g.step(k);
+            const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            done += k;
+            std::printf("%.10e %.10e %.10e %.10e %.10e %.10e %.10e %.3f\n", g.time(), g.msd(),
+                        theory(itphys::gle_theoretical_msd), g.velocity_autocorrelation(),
+                        theory(itphys::gle_theoretical_vacf), g.kinetic_energy(), g.auxiliary_temperature(),
+                        k / sec);
+            std::fflush(stdout);
+        }
+    } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * 自己推進粒子モード: 静止状態から始めた N 粒子の MSD と運動エネルギーを理論値と比べ、
+ * 後半の MSD の傾きから求めた拡散係数を D_eff と比べる
+ */
+int run_active(const itphys::LangevinParams &p, const itphys::ActiveOptions &opt, long long every) {
+    try {
+        itphys::ActiveBrownian a(p, opt);
+        const bool free = !opt.force.any();
+        const double nan = std::nan("");
+        std::printf("# N = %zu  v0 = %.6f  D_r = %.6f  noise = %s  force = %s\n", a.size(), opt.v0,
+                    opt.rot_diffusion, itphys::noise_name(opt.noise), itphys::force_field_name(opt.force).c_str());
+        std::printf("# t msd msd_theory kinetic kinetic_theory steps_per_s\n");
+        // 傾きの MSD は出力の間隔 every に依らず n_steps/100 ステップごとに取る
+        const long long stride = std::max(1LL, p.n_steps / 100);
+        std::vector<double> t, msd;
+        long long steps = 0;
+        double sec = 0.0;
+        for (long long done = 0; done < p.n_steps;) {
+            const long long next = std::min({(done / every + 1) * every, (done / stride + 1) * stride, p.n_steps});
+            const long long k = next - done;
+            const auto t0 = std::chrono::steady_clock::now();
+            a.step(k);
+            sec += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            steps += k;
+            done = next;
+            t.push_back(a.time());
+            msd.push_back(a.msd());
+            if (done % every != 0 && done < p.n_steps) continue;
+            std::printf("%.10e %.10e %.10e %.10e %.10e %.3f\n", a.time(), msd.back(),
+                        free ? itphys::active_theoretical_msd(a.time(), p, opt.v0, opt.rot_diffusion) : nan,
+                        a.kinetic_energy(),
+                        free ? 0.5 * p.m * itphys::active_theoretical_v2(a.time(), p, opt.v0, opt.rot_diffusion)
+                             : nan,
+                        steps / sec);
+            std::fflush(stdout);
+            steps = 0;
+            sec = 0.0;
+        }
+        // 後半の点が2個未満（n_steps < 4）なら傾きは求められない
+        const double t_half = 0.5 * a.time();
+        const long long n_fit = std::count_if(t.begin(), t.end(), [t_half](double ti) { return ti >= t_half; });
+        std::printf("# D_slope = %.6f  D_eff = %.6f  (D = %.6f, t >= %.6f, %lld points)\n",
+                    n_fit >= 2 ? itphys::fit_diffusion_slope(t, msd, t_half) : nan,
+                    itphys::active_effective_diffusion(p, opt.v0, opt.rot_diffusion),
+                    itphys::diffusion_coefficient(p), t_half, n_fit);
+    } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * 初通過時間モード: 吸収条件を初めて満たす時刻のヒストグラム（誤差は二項分布の標準誤差）
+ */
+int run_fpt(const itphys::LangevinParams &p, const itphys::FptOptions &opt) {
+    try {
+        const auto t0 = std::chrono::steady_clock::now();
+        const itphys::FptResult r = itphys::run_first_passage(p, opt);
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::printf("# walkers = %llu  condition = %s  threshold = %.6f  start = (%.6f, %.6f)  t_max = %.6f  "
+                    "force = %s  lanes = %s\n",
+                    r.walkers, itphys::fpt_condition_name(opt.condition), opt.threshold, opt.start_x, opt.start_y,
+                    opt.t_max, itphys::force_field_name(opt.force).c_str(), itphys::fpt_lanes_name(opt.lanes));
+        std::printf("# t density density_err\n");
+        for (std::size_t i = 0; i < r.n_bins(); i++) {
+            std::printf("%.10e %.10e %.10e\n", r.bin_center(i), r.density(i), r.density_error(i));
+        }
+        std::printf("# mean_fpt = %.6f +- %.6f  (absorbed = %.0f, censored = %llu)\n", r.times.mean(),
+                    r.times.std_error(), r.times.count(), r.censored);
+        if (opt.condition == itphys::FptCondition::kRadius && !opt.force.any()) {
+            // 過減衰の極限の 2 次元の円からの平均脱出時間 (R² - r0²)/(4D)（慣性があると境界層の分だけ長い）
+            const double r0 = opt.start_x * opt.start_x + opt.start_y * opt.start_y;
+            std::printf("# mean_fpt_overdamped = %.6f\n",
+                        (opt.threshold * opt.threshold - r0) / (4.0 * itphys::diffusion_coefficient(p)));
+        }
+        std::printf("# lane_steps = %llu  lane_utilization = %.4f  lane_steps_per_s = %.4e\n", r.lane_steps,
+                    r.lane_utilization(p.dt), r.lane_steps / sec);
+    } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
+
+/** argv[first] 以降の T, m, gamma, dt, n_steps を読む */
+itphys::LangevinParams parse_params(int argc, char *argv[], int first) {
+    itphys::LangevinParams p;
+    if (argc > first) p.T = std::atof(argv[first]);
+    if (argc > first + 1) p.m = std::atof(argv[first + 1]);
+    if (argc > first + 2) p.gamma = std::atof(argv[first + 2]);
+    if (argc > first + 3) p.dt = std::atof(argv[first + 3]);
+    if (argc > first + 4) p.n_steps = std::atoll(argv[first + 4]);
+    return p;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && std::strcmp(argv[1], "mlmc") == 0) {
+        itphys::MlmcOptions opt;
+        std::vector<char *> args = {argv[0], argv[1]};
+        for (int i = 2; i < argc; i++) {
+            const bool v = i + 1 < argc;
+            if (std::strcmp(argv[i], "--integrator") == 0 && v) {
+                if (!itphys::parse_integrator(argv[++i], opt.integrator)) {
+                    std::fprintf(stderr, "--integrator: expected euler or baoab\n");
+                    return 1;
+                }
+            } else if (std::strcmp(argv[i], "--observable") == 0 && v) {
+                const char *name = argv[++i];
+                int k = 0;
+                while (k < itphys::kMlmcObservables && std::strcmp(name, itphys::mlmc_observable_name(k)) != 0) k++;
+                if (k == itphys::kMlmcObservables) {
+                    std::fprintf(stderr, "--observable: expected msd, energy or diffusion\n");
+                    return 1;
+                }
+                opt.control = static_cast<itphys::MlmcObservable>(k);
+            } else {
+                args.push_back(argv[i]);
+            }
+        }
+        const int n = static_cast<int>(args.size());
+        if (n >= 3) opt.target_rmse = std::atof(args[2]);
+        itphys::LangevinParams p = parse_params(n, args.data(), 3);
+        if (n < 7) p.dt = 0.2;       // 最も粗い刻みの既定値
+        if (n < 8) p.n_steps = static_cast<long long>(std::llround(10.0 / p.dt));
+        return run_mlmc_mode(p, opt);
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "suspension") == 0) {
+        itphys::SuspensionOptions opt;
+        opt.n_particles = 10000;
+        long long every = 100;
+        std::vector<char *> args = {argv[0], argv[1]};
+        for (int i = 2; i < argc; i++) {
+            const bool v = i + 1 < argc;
+            if (std::strcmp(argv[i], "--pair") == 0 && v) {
+                if (!itphys::parse_pair_potential(argv[++i], opt.pair.kind)) {
+                    std::fprintf(stderr, "--pair: expected wca, lj or yukawa\n");
+                    return 1;
+                }
+            } else if (std::strcmp(argv[i], "--epsilon") == 0 && v) {
+                opt.pair.epsilon = std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--sigma") == 0 && v) {
+                opt.pair.sigma = std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--kappa") == 0 && v) {
+                opt.pair.kappa = std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--cutoff") == 0 && v) {
+                opt.pair.cutoff = std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--skin") == 0 && v) {
+                opt.pair.skin = std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--every") == 0 && v) {
+                every = std::max(1LL, std::atoll(argv[++i]));
+            } else if (std::strcmp(argv[i], "--threads") == 0 && v) {
+                opt.n_threads = std::atoi(argv[++i]);
+            } else if (std::strcmp(argv[i], "--seed") == 0 && v) {
+                opt.seed = std::strtoull(argv[++i], nullptr, 10);
+            } else {
+                args.push_back(argv[i]);
+            }
+        }
+        const int n = static_cast<int>(args.size());
+        if (n >= 3) opt.n_particles = static_cast<std::size_t>(std::atoll(args[2]));
+        if (n >= 4) opt.density = std::atof(args[3]);
+        itphys::LangevinParams p = parse_params(n, args.data(), 4);
+        if (n < 8) p.dt = 0.002;  // 粒子が重ならない程度の刻み
+        return run_suspension(p, opt, every);
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "bdhi") == 0) {
+        itphys::HydroOptions opt;
+        opt.n_particles = 1000;
+        long long every = 10;
+        std::vector<char *> args = {argv[0], argv[1]};
+        for (int i = 2; i < argc; i++) {
+            const bool v = i + 1 < argc;
+            if (std::strcmp(argv[i], "--radius") == 0 && v) {
+                opt.radius = std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--spacing") == 0 && v) {
+                opt.spacing = std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--force") == 0 && v) {
+                if (!itphys::parse_force_field(argv[++i], opt.force)) {
+                    std::fprintf(stderr, "--force: cannot parse '%s'\n", argv[i]);
+                    return 1;
+                }
+            } else if (std::strcmp(argv[i], "--tol") == 0 && v) {
+                opt.tolerance = std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--max-krylov") == 0 && v) {
+                opt.max_krylov = std::max(1, std::atoi(argv[++i]));
+            } else if (std::strcmp(argv[i], "--every") == 0 && v) {
+                every = std::max(1LL, std::atoll(argv[++i]));
+            } else if (std::strcmp(argv[i], "--threads") == 0 && v) {
+                opt.n_threads = std::atoi(argv[++i]);
+            } else if (std::strcmp(argv[i], "--seed") == 0 && v) {
+                opt.seed = std::strtoull(argv[++i], nullptr, 10);
+            } else {
+                args.push_back(argv[i]);
+            }
+        }
+        const int n = static_cast<int>(args.size());
+        if (n >= 3) opt.n_particles = static_cast<std::size_t>(std::atoll(args[2]));
+        itphys::LangevinParams p = parse_params(n, args.data(), 3);
+        if (n < 8) p.n_steps = 100;  // 1ステップが重いので短くする
+        return run_bdhi(p, opt, every);
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "gle") == 0) {
+        itphys::GleOptions opt;
+        opt.kernel.modes.push_back({1.0, 1.0});
+        long long every = 100;
+        std::vector<char *> args = {argv[0], argv[1]};
+        for (int i = 2; i < argc; i++) {
+            const bool v = i + 1 < argc;
+            if (std::strcmp(argv[i], "--kernel") == 0 && v) {
+                if (!itphys::parse_memory_kernel(argv[++i], opt.kernel)) {
+                    std::fprintf(stderr, "--kernel: expected GAMMA:TAU[,GAMMA:TAU...] or none\n");
+                    return 1;
+                }
+            } else if (std::strcmp(argv[i], "--force") == 0 && v) {
+                if (!itphys::parse_force_field(argv[++i], opt.force)) {
+                    std::fprintf(stderr, "--force: cannot parse '%s'\n", argv[i]);
+                    return 1;
+                }
+            } else if (std::strcmp(argv[i], "--every") == 0 && v) {
+                every = std::max(1LL, std::atoll(argv[++i]));
+            } else if (std::strcmp(argv[i], "--threads") == 0 && v) {
+                opt.n_threads = std::atoi(argv[++i]);
+            } else if (std::strcmp(argv[i], "--seed") == 0 && v) {
+                opt.seed = std::strtoull(argv[++i], nullptr, 10);
+            } else {
+                args.push_back(argv[i]);
+            }
+        }
+        const int n = static_cast<int>(args.size());
+        if (n >= 3) opt.n_particles = static_cast<std::size_t>(std::atoll(args[2]));
+        const itphys::LangevinParams p = parse_params(n, args.data(), 3);
+        return run_gle(p, opt, every);
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "active") == 0) {
+        itphys::ActiveOptions opt;
+        long long every = 100;
+        std::vector<char *> args = {argv[0], argv[1]};
+        for (int i = 2; i < argc; i++) {
+            const bool v = i + 1 < argc;
+            if (std::strcmp(argv[i], "--v0") == 0 && v) {
+                opt.v0 = std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--rot-diffusion") == 0 && v) {
+                opt.rot_diffusion = std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--noise") == 0 && v) {
+                if (!itphys::parse_noise(argv[++i], opt.noise)) {
+                    std::fprintf(stderr, "--noise: expected gaussian or uniform\n");
+                    return 1;
+                }
+            } else if (std::strcmp(argv[i], "--force") == 0 && v) {
+                if (!itphys::parse_force_field(argv[++i], opt.force)) {
+                    std::fprintf(stderr, "--force: cannot parse '%s'\n", argv[i]);
+                    return 1;
+                }
+            } else if (std::strcmp(argv[i], "--every") == 0 && v) {
+                every = std::max(1LL, std::atoll(argv[++i]));
+            } else if (std::strcmp(argv[i], "--threads") == 0 && v) {
+                opt.n_threads = std::atoi(argv[++i]);
+            } else if (std::strcmp(argv[i], "--seed") == 0 && v) {
+                opt.seed = std::strtoull(argv[++i], nullptr, 10);
+            } else {
+                args.push_back(argv[i]);
+            }
+        }
+        const int n = static_cast<int>(args.size());
+        if (n >= 3) opt.n_particles = static_cast<std::size_t>(std::atoll(args[2]));
+        const itphys::LangevinParams p = parse_params(n, args.data(), 3);
+        return run_active(p, opt, every);
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "fpt") == 0) {
+        itphys::FptOptions opt;
+        std::vector<char *> args = {argv[0], argv[1]};
+        for (int i = 2; i < argc; i++) {
+            const bool v = i + 1 < argc;
+            if (std::strcmp(argv[i], "--condition") == 0 && v) {
+                if (!itphys::parse_fpt_condition(argv[++i], opt.condition)) {
+                    std::fprintf(stderr, "--condition: expected radius or barrier\n");
+                    return 1;
+                }
+            } else if (std::strcmp(argv[i], "--threshold") == 0 && v) {
+                opt.threshold = std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--start-x") == 0 && v) {
+                opt.start_x = std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--start-y") == 0 && v) {
+                opt.start_y = std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--t-max") == 0 && v) {
+                opt.t_max = std::atof(argv[++i]);
+            } else if (std::strcmp(argv[i], "--bins") == 0 && v) {
+                opt.n_bins = static_cast<std::size_t>(std::max(1LL, std::atoll(argv[++i])));
+            } else if (std::strcmp(argv[i], "--lanes") == 0 && v) {
+                if (!itphys::parse_fpt_lanes(argv[++i], opt.lanes)) {
+                    std::fprintf(stderr, "--lanes: expected refill or mask\n");
+                    return 1;
+                }
+            } else if (std::strcmp(argv[i], "--n-lanes") == 0 && v) {
+                opt.n_lanes = static_cast<std::size_t>(std::max(1LL, std::atoll(argv[++i])));
+            } else if (std::strcmp(argv[i], "--force") == 0 && v) {
+                if (!itphys::parse_force_field(argv[++i], opt.force)) {
+                    std::fprintf(stderr, "--force: cannot parse '%s'\n", argv[i]);
+                    return 1;
+                }
+            } else if (std::strcmp(argv[i], "--threads") == 0 && v) {
+                opt.n_threads = std::atoi(argv[++i]);
+            } else if (std::strcmp(argv[i], "--seed") == 0 && v) {
+                opt.seed = std::strtoull(argv[++i], nullptr, 10);
+            } else {
+                args.push_back(argv[i]);
+            }
+        }
+        const int n = static_cast<int>(args.size());
+        if (n >= 3) opt.n_walkers = static_cast<std::size_t>(std::atoll(args[2]));
+        const itphys::LangevinParams p = parse_params(n, args.data(), 3);
+        return run_fpt(p, opt);
+    }
+    std::fprintf(stderr, "usage: %s mlmc|suspension|bdhi|gle|active|fpt [args...]\n", argv[0]);
+    return 1;
+}
@@ -18,6 +18,8 @@ import numpy as np          # 数値計算ライブラリ
 import matplotlib.pyplot as plt  # グラフ描画ライブラリ
 import subprocess           # 外部プログラム実行用
 import os                   # ファイル操作用
+import io                   # 文字列をファイルとして読むため
+from itphys_server import BrownianServer  # brownian_motion のサーバーモード
 
 # 日本語フォントの設定
 plt.rcParams['font.family'] = 'Hiragino Sans'
@@ -28,13 +30,13 @@ plt.rcParams['axes.unicode_minus'] = False
 script_dir = os.path.dirname(os.path.abspath(__file__))
 os.chdir(script_dir)
 
-# Cプログラムをコンパイル（必要に応じて）
-source_file = 'brownian_motion.c'
-executable_name = './brownian_motion'
-
-if not os.path.exists(executable_name) or \
-   os.path.getmtime(source_file) > os.path.getmtime(executable_name):
-    subprocess.run(['gcc', '-o', executable_name, source_file, '-lm'])
+# Cプログラムを CMake（Release, -O3）でビルド（変更がなければ何もしない）
+repo_root = os.path.dirname(script_dir)
+build_dir = os.path.join(repo_root, 'build', 'release')
+if not os.path.exists(os.path.join(build_dir, 'CMakeCache.txt')):
+    subprocess.run(['cmake', '--preset', 'release'], cwd=repo_root, check=True)
+subprocess.run(['cmake', '--build', build_dir, '--target', 'brownian_motion'], check=True)
+executable_name = os.path.join(build_dir, 'bin', 'brownian_motion')
 
 # 解析する温度のリスト（3通り）
 T_values = [0.5, 1.0, 2.0]
@@ -54,25 +56,27 @@ os.makedirs('figures', exist_ok=True)   # 図ファイル用ディレクトリ
 energies_by_T = []
 
 # 各温度についてシミュレーションを実行
-for T in T_values:
+# 全ての実行を1つのサーバープロセスにまとめて投入する（実行ごとにプロセスを起動しない）
+n_runs = 10  # 統計を取るために複数回実行（より良い分布を得るため）
+jobs = [dict(T=T, m=m, gamma=gamma, dt=dt, n_steps=n_steps)
+        for T in T_values for run in range(n_runs)]
+with BrownianServer(executable_name) as server:
+    outputs = server.run_many(jobs)
+
+for i_T, T in enumerate(T_values):
     # この温度での全エネルギー値を格納するリスト
     energies = []
-    # 統計を取るために複数回実行（より良い分布を得るため）
-    n_runs = 10
     
     # 各実行について
     for run in range(n_runs):
-        # 出力ファイル名を決定（温度と実行回数を含む）
+        text = outputs[i_T * n_runs + run]
+        # 出力ファイル名を決定（温度と実行回数を含む）し、軌道データを保存
         output_file = os.path.join('data', f'energy_T{T}_run{run+1}.dat')
-        
-        # Cプログラム（brownian_motion）を実行して軌道データを生成
-        # 引数: 温度T、質量m、摩擦係数γ、時間刻みdt、ステップ数n_steps
         with open(output_file, 'w') as f:
-            subprocess.run([executable_name, str(T), str(m), str(gamma), 
-                          str(dt), str(n_steps)], stdout=f)
+            f.write(text)
         
-        # 生成されたデータファイルを読み込む（#で始まるコメント行は無視）
-        data = np.loadtxt(output_file, comments='#')
+        # 軌道データを読み込む（#で始まるコメント行は無視）
+        data = np.loadtxt(io.StringIO(text), comments='#')
         t = data[:, 0]   # 時刻
         vx = data[:, 3]   # x方向の速度
         vy = data[:, 4]   # y方向の速度
@@ -0,0 +1,448 @@
+/*
+ * brownian_motion.cpp
+ * 
+ * 目的: 2次元ブラウン運動を数値的にシミュレートするプログラム
+ * 
+ * 物理モデル:
+ * - ランジュバン方程式に基づくブラウン運動のシミュレーション
+ * - 速度の時間発展: dv/dt = -(γ/m)v + sqrt(2γkBT/m) * η(t)
+ * - 位置の時間発展: dr/dt = v
+ * 
+ * 処理の流れ:
+ * 1. コマンドライン引数から物理パラメータ（温度T、質量m、摩擦係数γ、時間刻みdt、ステップ数）を取得
+ * 2. 初期条件（位置(0,0)、速度(0,0)）を設定
+ * 3. オイラー法で時間発展を計算し、各時刻の位置と速度を出力
+ *
+ * 積分器・乱数・出力は libitphys（itphys/langevin.hpp, rng.hpp, io.hpp）にある
+ *
+ * サーバーモード（./brownian_motion server [--socket PATH] [--threads N]）:
+ * 標準入力（または Unix ドメインソケット）から1行1ジョブの記述を読み、スレッドプールで並行に
+ * 実行して結果を返す。多数の短い実行を1回のプロセス起動で済ませるためのもの。
+ * ジョブと応答の形式は itphys/server.hpp を参照
+ *
+ * 結果のキャッシュ（itphys/cache.hpp）:
+ * - サーバーモードで --cache DIR [--cache-max-mb N] [--cache-verify] を指定すると、seed を指定した
+ *   ジョブの結果を DIR に保存し、同じジョブは再計算せずに返す
+ * - 通常の実行でも、環境変数 ITPHYS_CACHE=DIR があり seed を指定していれば同じようにキャッシュする
+ *   （ITPHYS_CACHE_MAX_MB, ITPHYS_CACHE_VERIFY=1 も同じ意味）
+ * - ./brownian_motion cache DIR stats|verify|evict MAX_MB でキャッシュを管理する
+ *
+ * チェックポイント（itphys/checkpoint.hpp）:
+ *   ./brownian_motion T m gamma dt n_steps seed --output traj.dat [--binary] [--checkpoint-every N]
+ *   ./brownian_motion --resume --output traj.dat        中断した計算をビット単位で同じに続ける
+ *   ./brownian_motion --extend 5000 --output traj.dat   終わった計算にさらに 5000 ステップ追加する
+ * 粒子の状態・乱数生成器の状態・出力ファイルの位置を traj.dat.ckpt（--checkpoint PATH で変更）に
+ * N ステップごと（省略時は最後だけ）と SIGINT/SIGTERM を受けたときに保存する。
+ * 保存する前に出力を fsync するので、出力は必ず保存した位置まである（--resume / --extend で
+ * ファイルがそれより短ければ、壊れているとみなして続けない）。
+ *
+ * 時間方向の並列計算（itphys/time_parallel.hpp）:
+ *   ./brownian_motion T m gamma dt n_steps seed --output traj.bin --binary --time-parallel [--threads N]
+ * 1本の長い軌道を --chunk N ステップ（省略時 65536）ずつに分けて並列に計算し、mmap した出力に
+ * 直接書く。n_steps <= chunk なら通常の実行と同じ結果、それ以外は別の標本路になる。
+ *
+ * 外力（itphys/force.hpp）:
+ *   ./brownian_motion T m gamma dt n_steps seed --force harmonic:k=2+washboard:v0=1,period=1,tilt=0.5
+ * 調和トラップ・傾いた周期ポテンシャル・2重井戸を '+' でつないで掛ける（--time-parallel 以外の
+ * どの実行でも使え、チェックポイントにも保存される）。
+ */
+
+#include <algorithm>  // std::min
+#include <csignal>  // SIGINT, SIGTERM を受けてチェックポイントを書くため
+#include <cstdio>   // stdout を使用するため
+#include <cstdlib>  // atof, atoll, strtoull関数を使用するため
+#include <cstring>  // strcmp関数を使用するため
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>  // ftruncate
+
+#include "itphys/cache.hpp"
+#include "itphys/checkpoint.hpp"
+#include "itphys/force.hpp"
+#include "itphys/io.hpp"
+#include "itphys/langevin.hpp"
+#include "itphys/rng.hpp"
+#include "itphys/server.hpp"
+#include "itphys/time_parallel.hpp"
+
+/** MiB 単位の大きさをバイト数にする */
+static std::uint64_t mib_to_bytes(const char *s) {
+    return static_cast<std::uint64_t>(std::atof(s) * 1024.0 * 1024.0);
+}
+
+/**
+ * サーバーモード
+ *
+ * @param argv argv[1] は "server"。その後に --socket PATH（省略時は標準入出力）、
+ *             --threads N（省略時または0: CPU のコア数）、--cache DIR（結果のキャッシュ）、
+ *             --cache-max-mb N（キャッシュの上限）、--cache-verify（ヒットしても再計算して確かめる）
+ * @return 正常終了時は0を返す
+ */
+static int run_server(int argc, char *argv[]) {
+    std::string socket_path, cache_dir;
+    int n_threads = 0;
+    std::uint64_t cache_max = 0;
+    bool cache_verify = false;
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            n_threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--cache-max-mb") == 0 && i + 1 < argc) {
+            cache_max = mib_to_bytes(argv[++i]);
+        } else if (std::strcmp(argv[i], "--cache-verify") == 0) {
+            cache_verify = true;
+        } else {
+            std::fprintf(stderr,
+                         "usage: %s server [--socket PATH] [--threads N] [--cache DIR]\n"
+                         "          [--cache-max-mb N] [--cache-verify]\n", argv[0]);
+            return 1;
+        }
+    }
+    std::unique_ptr<itphys::ResultCache> cache;
+    if (!cache_dir.empty()) {
+        cache.reset(new itphys::ResultCache(cache_dir, cache_max, cache_verify));
+    }
+    if (!socket_path.empty()) return itphys::serve_unix_socket(socket_path, n_threads, cache.get());
+    itphys::serve_stream(0, 1, n_threads, cache.get());  // 標準入力から読み、標準出力に返す
+    return 0;
+}
+
+/**
+ * キャッシュの管理: cache DIR stats | verify | evict MAX_MB
+ *
+ * @return 正常終了時は0、verify で一致しないエントリがあれば1を返す
+ */
+static int run_cache_command(int argc, char *argv[]) {
+    if (argc < 4 || (std::strcmp(argv[3], "evict") == 0 && argc < 5)) {
+        std::fprintf(stderr, "usage: %s cache DIR stats|verify|evict MAX_MB\n", argv[0]);
+        return 1;
+    }
+    itphys::ResultCache cache(argv[2]);
+    if (std::strcmp(argv[3], "stats") == 0) {
+        const itphys::ResultCache::Stats st = cache.stats();
+        std::printf("%zu entries, %.3f MiB\n", st.entries, st.bytes / 1048576.0);
+        return 0;
+    }
+    if (std::strcmp(argv[3], "evict") == 0) {
+        const std::uint64_t removed = cache.evict(mib_to_bytes(argv[4]));
+        std::printf("removed %.3f MiB\n", removed / 1048576.0);
+        return 0;
+    }
+    if (std::strcmp(argv[3], "verify") == 0) {
+        const itphys::CacheVerifyResult r = itphys::verify_cache(cache, stdout);
+        std::printf("ok %zu, mismatch %zu, stale %zu, invalid %zu\n", r.ok, r.mismatch, r.stale,
+                    r.invalid);
+        return r.mismatch > 0 ? 1 : 0;
+    }
+    std::fprintf(stderr, "unknown cache command: %s\n", argv[3]);
+    return 1;
+}
+
+/** 出力ファイルとチェックポイントの指定（"--" で始まる引数） */
+struct RunOptions {
+    std::string output;      // --output PATH（省略時は標準出力）
+    bool binary = false;     // --binary（BinarySink の形式で出力）
+    std::string checkpoint;  // --checkpoint PATH（省略時は出力ファイル名 + ".ckpt"）
+    long long every = 0;     // --checkpoint-every N（0: 最後と中断時だけ）
+    bool resume = false;     // --resume
+    long long extend = 0;    // --extend N
+    bool time_parallel = false;  // --time-parallel
+    int threads = 0;             // --threads N（--time-parallel のスレッド数）
+    long long chunk = itphys::TimeParallelOptions().chunk;  // --chunk N
+    itphys::ForceField force;    // --force SPEC
+};
+
+static volatile std::sig_atomic_t g_stop = 0;
+
+static void request_stop(int) { g_stop = 1; }
+
+/** 状態 s（step ステップ目）と出力ファイルの位置 cursor をチェックポイントに書く */
+static void write_checkpoint(const RunOptions &opt, const itphys::LangevinParams &p,
+                             std::uint64_t seed, long long step, const itphys::ParticleState &s,
+                             const itphys::NormalRng &rng, std::uint64_t cursor) {
+    itphys::Checkpoint ck;
+    ck.put("params", p);
+    ck.put("seed", seed);
+    ck.put("step", step);
+    ck.put("state", s);
+    ck.put("force", opt.force);
+    itphys::save_state(ck, "rng", rng);
+    ck.put("output.path", opt.output);
+    ck.put("output.binary", static_cast<unsigned char>(opt.binary));
+    ck.put("output.cursor", cursor);
+    ck.save(opt.checkpoint);
+}
+
+/**
+ * step ステップ目の状態 s から p.n_steps まで計算して sink に書き、途中でチェックポイントを保存する
+ * チェックポイントの cursor より前の出力が必ずディスクにあるように、保存する前に出力を fsync する
+ *
+ * @param fd   出力ファイルのファイル記述子
+ * @param base この sink で書く前の出力ファイルの大きさ
+ * @return 正常終了時は0、シグナルで中断したときか出力を fsync できなかったときは1
+ */
+template <class Sink>
+static int run_with_checkpoints(const RunOptions &opt, const itphys::LangevinParams &p,
+                                std::uint64_t seed, long long step, itphys::ParticleState s,
+                                itphys::NormalRng &rng, Sink &sink, int fd, std::uint64_t base) {
+    constexpr long long kChunk = 1 << 16;  // シグナルを確かめる間隔（ステップ）
+    while (step < p.n_steps) {
+        long long chunk = std::min(p.n_steps - step, kChunk);
+        if (opt.every > 0) chunk = std::min(chunk, opt.every - step % opt.every);
+        itphys::advance_brownian_motion(p, rng, sink, s, chunk, opt.force);
+        step += chunk;
+        if ((opt.every > 0 && step % opt.every == 0) || step == p.n_steps || g_stop) {
+            sink.flush();
+            if (::fsync(fd) != 0) {
+                std::perror(opt.output.c_str());
+                return 1;
+            }
+            write_checkpoint(opt, p, seed, step, s, rng, base + sink.bytes_written());
+        }
+        if (g_stop && step < p.n_steps) {
+            std::fprintf(stderr, "brownian_motion: stopped at step %lld of %lld (resume with --resume)\n",
+                         step, p.n_steps);
+            return 1;
+        }
+    }
+    sink.flush();
+    return 0;
+}
+
+/**
+ * チェックポイントを使う実行（新しく始める、--resume で続ける、--extend でステップを追加する）
+ *
+ * @return 正常終了時は0を返す
+ */
+static int run_checkpointed(RunOptions opt, itphys::LangevinParams p, std::uint64_t seed) {
+    if (opt.checkpoint.empty()) {
+        if (opt.output.empty()) {
+            std::fprintf(stderr, "brownian_motion: checkpoints need --output PATH or --checkpoint PATH\n");
+            return 1;
+        }
+        opt.checkpoint = opt.output + ".ckpt";
+    }
+
+    long long step = 0;
+    itphys::ParticleState s;
+    itphys::NormalRng rng;
+    std::uint64_t cursor = 0;
+    std::FILE *fp = nullptr;
+    if (opt.resume || opt.extend > 0) {
+        try {
+            const itphys::Checkpoint ck = itphys::Checkpoint::load(opt.checkpoint);
+            p = ck.get<itphys::LangevinParams>("params");
+            seed = ck.get<std::uint64_t>("seed");
+            step = ck.get<long long>("step");
+            s = ck.get<itphys::ParticleState>("state");
+            // 外力を保存する前のチェックポイントは力なし
+            opt.force = ck.has("force") ? ck.get<itphys::ForceField>("force") : itphys::ForceField();
+            itphys::load_state(ck, "rng", rng);
+            opt.output = ck.get_string("output.path");
+            opt.binary = ck.get<unsigned char>("output.binary") != 0;
+            cursor = ck.get<std::uint64_t>("output.cursor");
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "brownian_motion: %s\n", e.what());
+            return 1;
+        }
+        p.n_steps += opt.extend;
+        // チェックポイントより後に書かれた分を捨て、その位置から書き足す
+        // （cursor より短いファイルは途中が失われているので、ゼロで埋めて伸ばさずに止める）
+        fp = std::fopen(opt.output.c_str(), "r+b");
+        if (fp && (std::fseek(fp, 0, SEEK_END) != 0 || std::ftell(fp) < static_cast<long>(cursor))) {
+            std::fprintf(stderr, "brownian_motion: %s is shorter than the checkpoint cursor (%llu bytes)\n",
+                         opt.output.c_str(), (unsigned long long)cursor);
+            std::fclose(fp);
+            return 1;
+        }
+        if (!fp || ::ftruncate(fileno(fp), static_cast<off_t>(cursor)) != 0 ||
+            std::fseek(fp, 0, SEEK_END) != 0 || std::ftell(fp) != static_cast<long>(cursor)) {
+            std::fprintf(stderr, "brownian_motion: cannot reopen %s at byte %llu\n",
+                         opt.output.c_str(), (unsigned long long)cursor);
+            if (fp) std::fclose(fp);
+            return 1;
+        }
+    } else {
+        if (seed == 0) seed = itphys::seed_from_time();
+        rng = itphys::NormalRng(seed);
+        fp = std::fopen(opt.output.c_str(), "wb");
+        if (!fp) {
+            std::perror(opt.output.c_str());
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT, request_stop);
+    std::signal(SIGTERM, request_stop);
+    int rc;
+    if (opt.binary) {
+        itphys::BinarySink sink(fp);
+        if (cursor == 0) {
+            sink.header();
+            sink.write(s);
+        }
+        rc = run_with_checkpoints(opt, p, seed, step, s, rng, sink, fileno(fp), cursor);
+    } else {
+        itphys::TextSink sink(fp);
+        if (cursor == 0) {
+            sink.header();
+            sink.write(s);
+        }
+        rc = run_with_checkpoints(opt, p, seed, step, s, rng, sink, fileno(fp), cursor);
+    }
+    std::fclose(fp);
+    return rc;
+}
+
+/**
+ * 時間方向に並列に計算して opt.output に BinarySink の形式で書く（チェックポイントは使わない）
+ *
+ * @return 正常終了時は0を返す
+ */
+static int run_time_parallel_to_file(const RunOptions &opt, const itphys::LangevinParams &p, std::uint64_t seed) {
+    if (opt.output.empty() || !opt.binary || opt.resume || opt.extend > 0 || opt.every > 0 ||
+        !opt.checkpoint.empty()) {
+        std::fprintf(stderr, "brownian_motion: --time-parallel needs --output PATH --binary "
+                             "and no checkpoint options\n");
+        return 1;
+    }
+    if (opt.force.any()) {
+        // 並列スキャンは力のない線形な漸化式のときだけ使える
+        std::fprintf(stderr, "brownian_motion: --time-parallel cannot be used with --force\n");
+        return 1;
+    }
+    itphys::TimeParallelOptions tp;
+    tp.seed = seed != 0 ? seed : itphys::seed_from_time();
+    tp.n_threads = opt.threads;
+    tp.chunk = opt.chunk;
+    try {
+        // ファイルは最初から最終的な大きさで作り、各スレッドが自分の範囲に直接書く
+        const std::size_t n_records = static_cast<std::size_t>(p.n_steps) + 1;
+        itphys::MmapSink sink(opt.output,
+                              itphys::kBinaryHeaderSize + n_records * itphys::kStateFields * sizeof(double));
+        sink.header();
+        itphys::run_time_parallel(p, tp, sink.reserve(n_records));
+    } catch (const std::system_error &e) {
+        std::fprintf(stderr, "brownian_motion: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * メイン関数
+ * ランジュバン方程式に基づいて2次元ブラウン運動をシミュレート
+ * 
+ * @param argc コマンドライン引数の個数
+ * @param argv コマンドライン引数の配列
+ *             argv[1]: 温度T（デフォルト: 1.0）
+ *             argv[2]: 質量m（デフォルト: 1.0）
+ *             argv[3]: 摩擦係数γ（デフォルト: 1.0）
+ *             argv[4]: 時間刻みdt（デフォルト: 0.01）
+ *             argv[5]: ステップ数n_steps（デフォルト: 1000）
+ *             argv[6]: 乱数のシード（省略時または0: 現在時刻）
+ *             argv[1] が "server" ならサーバーモード（run_server）、
+ *             "cache" ならキャッシュの管理（run_cache_command）
+ *             "--" で始まる引数は出力ファイルとチェックポイントの指定（RunOptions）
+ * @return 正常終了時は0を返す
+ */
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && std::strcmp(argv[1], "server") == 0) return run_server(argc, argv);
+    if (argc >= 2 && std::strcmp(argv[1], "cache") == 0) return run_cache_command(argc, argv);
+
+    // "--" で始まるオプションを取り除き、残りを位置引数として読む
+    RunOptions opt;
+    std::vector<char *> args = {argv[0]};
+    for (int i = 1; i < argc; i++) {
+        const bool v = i + 1 < argc;
+        if (std::strcmp(argv[i], "--output") == 0 && v) {
+            opt.output = argv[++i];
+        } else if (std::strcmp(argv[i], "--binary") == 0) {
+            opt.binary = true;
+        } else if (std::strcmp(argv[i], "--checkpoint") == 0 && v) {
+            opt.checkpoint = argv[++i];
+        } else if (std::strcmp(argv[i], "--checkpoint-every") == 0 && v) {
+            opt.every = std::atoll(argv[++i]);
+        } else if (std::strcmp(argv[i], "--resume") == 0) {
+            opt.resume = true;
+        } else if (std::strcmp(argv[i], "--extend") == 0 && v) {
+            opt.extend = std::atoll(argv[++i]);
+        } else if (std::strcmp(argv[i], "--time-parallel") == 0) {
+            opt.time_parallel = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && v) {
+            opt.threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--chunk") == 0 && v) {
+            opt.chunk = std::atoll(argv[++i]);
+        } else if (std::strcmp(argv[i], "--force") == 0 && v &&
+                   itphys::parse_force_field(argv[i + 1], opt.force)) {
+            i++;
+        } else if (std::strncmp(argv[i], "--", 2) == 0) {
+            std::fprintf(stderr,
+                         "usage: %s [T] [m] [gamma] [dt] [n_steps] [seed] [--output PATH] [--binary]\n"
+                         "          [--checkpoint PATH] [--checkpoint-every N] [--resume] [--extend N]\n"
+                         "          [--time-parallel [--threads N] [--chunk N]] [--force SPEC]\n"
+                         "       %s server ... | %s cache ...\n", argv[0], argv[0], argv[0]);
+            return 1;
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    argc = static_cast<int>(args.size());
+    argv = args.data();
+
+    // 物理パラメータ（デフォルト値は LangevinParams の初期値）
+    itphys::LangevinParams p;
+    
+    // コマンドライン引数からパラメータを取得（指定されていない場合はデフォルト値を使用）
+    if (argc >= 2) p.T = std::atof(argv[1]);         // 温度Tを取得
+    if (argc >= 3) p.m = std::atof(argv[2]);         // 質量mを取得
+    if (argc >= 4) p.gamma = std::atof(argv[3]);     // 摩擦係数γを取得
+    if (argc >= 5) p.dt = std::atof(argv[4]);        // 時間刻みdtを取得
+    if (argc >= 6) p.n_steps = std::atoll(argv[5]);  // ステップ数n_stepsを取得
+    std::uint64_t seed = (argc >= 7) ? std::strtoull(argv[6], nullptr, 10) : 0;
+
+    if (opt.time_parallel) return run_time_parallel_to_file(opt, p, seed);
+
+    // --output があればチェックポイントを使う（途中で止めても --resume で続けられる）
+    if (!opt.output.empty() || !opt.checkpoint.empty() || opt.resume || opt.extend > 0) {
+        return run_checkpointed(opt, p, seed);
+    }
+
+    // seed を指定していてキャッシュが有効なら、同じ条件の結果を再利用する
+    const char *cache_dir = std::getenv("ITPHYS_CACHE");
+    if (seed != 0 && cache_dir && *cache_dir) {
+        const char *max_mb = std::getenv("ITPHYS_CACHE_MAX_MB");
+        const char *verify = std::getenv("ITPHYS_CACHE_VERIFY");
+        try {
+            itphys::ResultCache cache(cache_dir, max_mb ? mib_to_bytes(max_mb) : 0,
+                                      verify && std::strcmp(verify, "1") == 0);
+            itphys::Job job;
+            job.p = p;
+            job.seed = seed;
+            job.force = opt.force;
+            const std::string body = itphys::run_job(job, &cache);
+            std::fwrite(body.data(), 1, body.size(), stdout);
+            return 0;
+        } catch (const std::system_error &e) {
+            // キャッシュが使えなければ普通に計算する
+            std::fprintf(stderr, "brownian_motion: cache disabled: %s\n", e.what());
+        }
+    }
+    if (seed == 0) seed = itphys::seed_from_time();
+    
+    itphys::NormalRng rng(seed);
+    itphys::TextSink out(stdout);  // "%.15e" × 5 列
+
+    // ヘッダー行 "# t x y vx vy" の後、初期状態と各ステップ後の状態を出力
+    out.header();
+    itphys::run_brownian_motion(p, rng, out, opt.force);
+    out.flush();
+    
+    return 0;  // 正常終了
+}
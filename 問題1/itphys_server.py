@@ -0,0 +1,88 @@
+"""
+itphys_server.py
+
+目的: brownian_motion のサーバーモードを1回だけ起動し、多数のシミュレーションを流し込む
+- 実行ごとに subprocess.run でプロセスを起動する代わりに使う（起動・パイプの準備の時間がなくなる）
+- ジョブの記述と応答の形式は libitphys/include/itphys/server.hpp を参照
+
+使い方:
+    from itphys_server import BrownianServer
+    with BrownianServer(executable_name) as server:
+        # 結果は投入した順のテキスト（brownian_motion の標準出力と同じ形式）
+        texts = server.run_many([dict(T=1.0, n_steps=1000, seed=1, stream=i) for i in range(100)])
+    data = np.loadtxt(io.StringIO(texts[0]), comments='#')
+
+    # cache_dir を指定すると、seed を指定したジョブの結果をそこにキャッシュする（同じ条件は再計算しない）
+    with BrownianServer(executable_name, cache_dir='data/cache') as server:
+        data = server.trajectory(dict(T=1.0, seed=1))   # (n_steps+1) × 5 の配列 t, x, y, vx, vy
+"""
+
+import subprocess           # サーバーの起動用
+
+
+class BrownianServer:
+    """brownian_motion server を子プロセスとして持ち、標準入出力でジョブをやり取りする"""
+
+    def __init__(self, executable, threads=0, cache_dir=None, cache_max_mb=None):
+        # threads: ワーカー数（0: CPU のコア数）
+        # cache_dir, cache_max_mb: 結果のキャッシュの保存先と上限（MiB）
+        args = [executable, 'server', '--threads', str(threads)]
+        if cache_dir is not None:
+            args += ['--cache', cache_dir]
+            if cache_max_mb is not None:
+                args += ['--cache-max-mb', str(cache_max_mb)]
+        self.proc = subprocess.Popen(args, stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+        self.next_id = 0
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def close(self):
+        """サーバーを終了させる"""
+        if self.proc.poll() is None:
+            self.proc.stdin.write(b'quit\n')
+            self.proc.stdin.close()
+            self.proc.wait()
+
+    def run_many(self, jobs, binary=False):
+        """
+        ジョブ（key=value の辞書）のリストを全て投入し、結果を投入した順に返す
+
+        binary=False なら str、True なら bytes（format=binary のとき）を返す
+        """
+        ids = []
+        lines = []
+        for job in jobs:
+            job_id = str(self.next_id)
+            self.next_id += 1
+            ids.append(job_id)
+            fields = [f'id={job_id}'] + [f'{k}={v}' for k, v in job.items()]
+            lines.append(' '.join(fields) + '\n')
+        # 応答はジョブの終わった順に返るので、全て投入してから id で並べ直す
+        self.proc.stdin.write(''.join(lines).encode())
+        self.proc.stdin.flush()
+
+        results = {}
+        while len(results) < len(ids):
+            header = self.proc.stdout.readline().decode()
+            if not header:
+                raise RuntimeError('brownian_motion server exited unexpectedly')
+            # "# job <id> ok <n_bytes>" または "# job <id> error <メッセージ>"
+            parts = header.split(None, 4)
+            if len(parts) < 4 or parts[1] != 'job':
+                continue
+            if parts[3] == 'error':
+                raise RuntimeError(f'job {parts[2]}: {header.strip()}')
+            body = self.proc.stdout.read(int(parts[4]))
+            results[parts[2]] = body if binary else body.decode()
+        return [results[i] for i in ids]
+
+    def trajectory(self, job):
+        """1つのジョブをバイナリ形式で実行し、(行数, 5) の numpy 配列で返す"""
+        import numpy as np
+        body = self.run_many([dict(job, format='binary')], binary=True)[0]
+        # BinarySink の形式: 16バイトのヘッダーの後に double × 5 のレコード
+        return np.frombuffer(body, dtype='<f8', offset=16).reshape(-1, 5)
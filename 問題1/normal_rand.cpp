@@ -0,0 +1,46 @@
+/*
+ * normal_rand.cpp
+ * 
+ * 目的: Box-Muller変換を用いて標準正規分布N(0,1)に従う乱数を生成するプログラム
+ * 
+ * 処理の流れ:
+ * 1. コマンドライン引数から生成する乱数の個数（とシード）を取得
+ * 2. 乱数生成器を初期化（シード省略時は現在時刻）
+ * 3. 指定された個数分の正規分布乱数を生成して標準出力に出力
+ *
+ * 乱数生成は libitphys の itphys::NormalRng（xoshiro256** + Box-Muller）を使う
+ */
+
+#include <cstdio>   // printf関数を使用するため
+#include <cstdlib>  // atoi, strtoull関数を使用するため
+#include <vector>
+
+#include "itphys/rng.hpp"  // 正規分布乱数（libitphys）
+
+/**
+ * メイン関数
+ * コマンドライン引数から生成する乱数の個数を取得し、その個数分の正規分布乱数を生成
+ * 
+ * @param argc コマンドライン引数の個数
+ * @param argv コマンドライン引数の配列
+ *             argv[1]: 生成する乱数の個数（デフォルト: 1000）
+ *             argv[2]: 乱数のシード（省略時または0: 現在時刻）
+ * @return 正常終了時は0を返す
+ */
+int main(int argc, char *argv[]) {
+    // コマンドライン引数から生成する乱数の個数を取得（指定されていない場合は1000個）
+    const int n_samples = (argc >= 2) ? std::atoi(argv[1]) : 1000;
+    std::uint64_t seed = (argc >= 3) ? std::strtoull(argv[2], nullptr, 10) : 0;
+    if (seed == 0) seed = itphys::seed_from_time();  // 毎回異なる乱数列を生成するため
+
+    itphys::NormalRng rng(seed);
+
+    // まとめて生成してから15桁の指数表記で出力
+    std::vector<double> z(n_samples > 0 ? n_samples : 0);
+    rng.fill(z.data(), z.size());
+    for (double v : z) {
+        std::printf("%.15e\n", v);
+    }
+
+    return 0;  // 正常終了
+}
@@ -16,15 +16,34 @@ plot_msd_parameters.py
 import numpy as np          # 数値計算ライブラリ
 import matplotlib.pyplot as plt  # グラフ描画ライブラリ
 import os                   # ファイル操作用
+import sys                  # モジュールの検索パス用
+import atexit               # 終了時にサーバーを止めるため
+import subprocess           # 外部プログラム実行用
 
 # 日本語フォントの設定
 plt.rcParams['font.family'] = 'Hiragino Sans'
 # マイナス記号の文字化けを防ぐ設定
 plt.rcParams['axes.unicode_minus'] = False
 
+# Cプログラムを CMake（Release, -O3）でビルド（変更がなければ何もしない）
+script_dir = os.path.dirname(os.path.abspath(__file__))
+repo_root = os.path.dirname(script_dir)
+build_dir = os.path.join(repo_root, 'build', 'release')
+if not os.path.exists(os.path.join(build_dir, 'CMakeCache.txt')):
+    subprocess.run(['cmake', '--preset', 'release'], cwd=repo_root, check=True)
+subprocess.run(['cmake', '--build', build_dir, '--target', 'brownian_motion'], check=True)
+executable_name = os.path.join(build_dir, 'bin', 'brownian_motion')
+
+# シミュレーションは brownian_motion のサーバーモードで行う（プロセスの起動は1回だけ）。
+# seed を指定した実行の結果は data/cache にキャッシュされ、図を作り直すときは再計算しない
+sys.path.insert(0, script_dir)
+from itphys_server import BrownianServer
+server = BrownianServer(executable_name, cache_dir=os.path.join(script_dir, 'data', 'cache'))
+atexit.register(server.close)
+
 def simulate_brownian_motion(T, m, gamma, kB=1.0, dt=0.01, n_steps=1000, seed=None):
     """
-    ブラウン運動を数値的にシミュレートする関数
+    ブラウン運動を数値的にシミュレートする関数（brownian_motion サーバーで計算）
     
     @param T: 温度
     @param m: 粒子の質量
@@ -32,51 +51,14 @@ def simulate_brownian_motion(T, m, gamma, kB=1.0, dt=0.01, n_steps=1000, seed=No
     @param kB: ボルツマン定数（デフォルト: 1.0）
     @param dt: 時間刻み（デフォルト: 0.01）
     @param n_steps: 時間ステップ数（デフォルト: 1000）
-    @param seed: 乱数のシード（デフォルト: None）
+    @param seed: 乱数のシード（デフォルト: None、このときはキャッシュしない）
     @return: (t, x, y) のタプル（時刻、x座標、y座標の配列）
     """
-    # 乱数のシードを設定（再現性のため）
+    job = dict(T=T, m=m, gamma=gamma, kB=kB, dt=dt, n_steps=n_steps)
     if seed is not None:
-        np.random.seed(seed)
-    
-    # 初期条件
-    rx, ry = 0.0, 0.0  # 初期位置（原点）
-    vx, vy = 0.0, 0.0  # 初期速度（ゼロ）
-    
-    # ランジュバン方程式の係数を事前計算
-    coeff1 = gamma / m  # 減衰項の係数: -(γ/m)
-    coeff2 = np.sqrt(2.0 * gamma * kB * T / m)  # ノイズ項の係数: sqrt(2γkBT/m)
-    
-    # 配列を初期化
-    t = np.zeros(n_steps + 1)  # 時刻の配列
-    x = np.zeros(n_steps + 1)  # x座標の配列
-    y = np.zeros(n_steps + 1)  # y座標の配列
-    
-    # 初期値を設定
-    t[0] = 0.0
-    x[0] = rx
-    y[0] = ry
-    
-    # 時間発展のループ（オイラー法で数値積分）
-    for n in range(n_steps):
-        # 標準正規分布に従う乱数（ホワイトノイズ）を生成
-        eta_x = np.random.normal(0, 1)  # x方向のノイズ
-        eta_y = np.random.normal(0, 1)   # y方向のノイズ
-        
-        # ランジュバン方程式に基づいて速度を更新
-        vx = vx - coeff1 * vx * dt + coeff2 * np.sqrt(dt) * eta_x
-        vy = vy - coeff1 * vy * dt + coeff2 * np.sqrt(dt) * eta_y
-        
-        # 位置を更新
-        rx += vx * dt  # x座標を更新
-        ry += vy * dt  # y座標を更新
-        
-        # 配列に値を保存
-        t[n+1] = (n+1) * dt
-        x[n+1] = rx
-        y[n+1] = ry
-    
-    return t, x, y
+        job['seed'] = seed + 1  # サーバーでは seed=0 が「現在時刻」の意味なので1ずらす
+    data = server.trajectory(job)
+    return data[:, 0], data[:, 1], data[:, 2]
 
 def calculate_msd_from_trajectories(trajectories):
     """
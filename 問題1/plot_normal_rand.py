@@ -6,7 +6,7 @@ plot_normal_rand.py
 - 各サンプル数のヒストグラムを描画し、理論的な正規分布と比較
 
 処理の流れ:
-1. Cプログラム（normal_rand.c）をコンパイル（必要に応じて）
+1. Cプログラム（normal_rand.cpp）をコンパイル（必要に応じて）
 2. Cプログラム（normal_rand）を実行して正規分布乱数を生成
 3. 生成されたデータを読み込み
 4. ヒストグラムと理論曲線を描画して比較
@@ -27,14 +27,13 @@ plt.rcParams['axes.unicode_minus'] = False
 script_dir = os.path.dirname(os.path.abspath(__file__))
 os.chdir(script_dir)
 
-# Cプログラムをコンパイル（必要に応じて）
-source_file = 'normal_rand.c'
-executable_name = './normal_rand'
-
-# 実行可能ファイルが存在しない、またはソースファイルより古い場合はコンパイル
-if not os.path.exists(executable_name) or \
-   os.path.getmtime(source_file) > os.path.getmtime(executable_name):
-    subprocess.run(['gcc', '-o', executable_name, source_file, '-lm'])
+# Cプログラムを CMake（Release, -O3）でビルド（変更がなければ何もしない）
+repo_root = os.path.dirname(script_dir)
+build_dir = os.path.join(repo_root, 'build', 'release')
+if not os.path.exists(os.path.join(build_dir, 'CMakeCache.txt')):
+    subprocess.run(['cmake', '--preset', 'release'], cwd=repo_root, check=True)
+subprocess.run(['cmake', '--build', build_dir, '--target', 'normal_rand'], check=True)
+executable_name = os.path.join(build_dir, 'bin', 'normal_rand')
 
 # データと図を保存するディレクトリを作成（既に存在する場合は何もしない）
 os.makedirs('data', exist_ok=True)      # データファイル用ディレクトリ
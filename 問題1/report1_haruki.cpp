@@ -0,0 +1,460 @@
+/*
+ * report1_haruki.cpp
+ *
+ * 問題1用のプログラム統合版（計算は libitphys を使用）
+ *
+ * 1. 正規分布乱数（Box-Muller）の生成
+ * 2. 2次元ブラウン運動（ランジュバン方程式）のシミュレーション
+ * 3. 平均二乗変位（MSD）の集計と理論値・拡散係数の比較
+ * 4. 運動エネルギー分布の集計と理論値 P(E) = exp(-E/kBT)/kBT の比較
+ *
+ * 使い方:
+ *   正規分布乱数を n 個生成:     ./report1_haruki normal_rand <n> [seed]
+ *   ブラウン運動をシミュレート:  ./report1_haruki [T] [m] [gamma] [dt] [n_steps]
+ *     省略時: T=1.0, m=1.0, gamma=1.0, dt=0.01, n_steps=1000
+ *   MSD を集計:                  ./report1_haruki msd [n_runs] [T] [m] [gamma] [dt] [n_steps]
+ *   エネルギー分布を集計:        ./report1_haruki energy [n_runs] [T] [m] [gamma] [dt] [n_steps]
+ *     省略時: n_runs=100（試行 i は seed=i+1 で実行する）
+ *     energy は最後に ⟨E⟩ の標準誤差と積分自己相関時間をブロッキング解析で出す（毎ステップの標本は独立でない）
+ *   msd / energy の集計の途中経過を保存:
+ *     ./report1_haruki msd 100000 ... --checkpoint msd.ckpt [--checkpoint-every N]
+ *     ./report1_haruki msd --checkpoint msd.ckpt --resume      中断したところから続ける
+ *     ./report1_haruki msd --checkpoint msd.ckpt --extend 5000 試行を 5000 回追加する
+ *     （N 試行ごと（省略時 100）と最後に、集計器と終わった試行の数を保存する）
+ *   MSD を分散低減して集計（n_runs 個の粒子を run_ensemble で並列に計算する）:
+ *     ./report1_haruki msd 1000 --variance-reduction control[,antithetic][,stratified]
+ *     （列 vr_factor は同じ本数の独立な試行と比べた分散の低減率）
+ *   次元・積分器・ノイズを選んで run_ensemble で集計（msd / energy、チェックポイントなし）:
+ *     ./report1_haruki msd 100000 ... [--dim 1|2|3] [--integrator euler|baoab|exact_ou]
+ *                      [--noise gaussian|uniform] [--precision double|mixed]
+ *     （組み合わせは起動時に一度だけ選び、その組み合わせ専用にインスタンス化した計算を呼ぶ）
+ *   標準誤差が許容値を下回るまで粒子をバッチごとに足して MSD を集計（itphys/adaptive.hpp）:
+ *     ./report1_haruki msd [max_particles] ... [--rel-tolerance R] [--tolerance EPS] [--time-budget SEC]
+ *                      [--batch B] [--min-batches K] [--target diffusion|msd|energy] （上の run_ensemble の指定も使える）
+ *     省略時: R=0.01（--tolerance だけなら 0）、B=4096、K=8、target=diffusion、max_particles=0（上限なし）。
+ *     バッチごとの "# batch particles estimate std_error seconds" を標準エラー出力に出す
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "itphys/adaptive.hpp"
+#include "itphys/checkpoint.hpp"
+#include "itphys/ensemble.hpp"
+#include "itphys/force.hpp"
+#include "itphys/io.hpp"
+#include "itphys/langevin.hpp"
+#include "itphys/observables.hpp"
+#include "itphys/rng.hpp"
+
+namespace {
+
+/**
+ * 正規分布乱数モード: コマンドライン第2引数で指定した個数だけ乱数を標準出力に出力
+ */
+int run_normal_rand(int n_samples, std::uint64_t seed) {
+    itphys::NormalRng rng(seed != 0 ? seed : itphys::seed_from_time());
+    std::vector<double> z(n_samples > 0 ? n_samples : 0);
+    rng.fill(z.data(), z.size());
+    for (double v : z) {
+        std::printf("%.15e\n", v);
+    }
+    return 0;
+}
+
+/**
+ * ブラウン運動モード: ランジュバン方程式に基づく2次元シミュレーション
+ * 出力形式: # t x y vx vy のヘッダー付きで、各行に t x y vx vy を出力
+ */
+int run_trajectory(const itphys::LangevinParams& p) {
+    itphys::NormalRng rng(itphys::seed_from_time());
+    itphys::TextSink out(stdout);
+    out.header();
+    itphys::run_brownian_motion(p, rng, out);
+    out.flush();
+    return 0;
+}
+
+/** 集計のチェックポイントの指定 */
+struct CheckpointOptions {
+    std::string path;        // --checkpoint PATH（空ならチェックポイントを使わない）
+    long long every = 100;   // --checkpoint-every N（試行）
+    bool resume = false;     // --resume
+    long long extend = 0;    // --extend N（試行）
+};
+
+/**
+ * 試行 first..n_runs-1 を実行し、ck_opt.every 試行ごとと最後に集計器 acc をチェックポイントに書く
+ *
+ * @param run_one 試行 run を1回実行して acc に集計する関数
+ */
+template <class Acc, class RunOne>
+void run_trials(const char *mode, const itphys::LangevinParams &p, long long first, long long n_runs,
+                Acc &acc, const CheckpointOptions &ck_opt, RunOne run_one) {
+    for (long long run = first; run < n_runs; run++) {
+        run_one(run);
+        const long long done = run + 1;
+        if (!ck_opt.path.empty() && (done % ck_opt.every == 0 || done == n_runs)) {
+            itphys::Checkpoint ck;
+            ck.put("mode", std::string(mode));
+            ck.put("params", p);
+            ck.put("runs_done", done);
+            ck.put("n_runs", n_runs);
+            itphys::save_state(ck, mode, acc);
+            ck.save(ck_opt.path);
+        }
+    }
+}
+
+/**
+ * --resume / --extend のとき、チェックポイントから p, 終わった試行の数, 全試行の数を読む
+ *
+ * @return 読めなければ false
+ */
+bool load_progress(const char *mode, const CheckpointOptions &ck_opt, itphys::Checkpoint &ck,
+                   itphys::LangevinParams &p, long long &done, long long &n_runs) {
+    try {
+        ck = itphys::Checkpoint::load(ck_opt.path);
+        if (ck.get_string("mode") != mode) {
+            std::fprintf(stderr, "%s: not a %s checkpoint\n", ck_opt.path.c_str(), mode);
+            return false;
+        }
+        p = ck.get<itphys::LangevinParams>("params");
+        done = ck.get<long long>("runs_done");
+        n_runs = ck.get<long long>("n_runs") + ck_opt.extend;
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * MSD モード: n_runs 本の軌道から ⟨r²(t)⟩ とその標準誤差を求め、理論値と並べて出力
+ * 出力形式: # t msd msd_err msd_theory（最後に拡散係数のフィッティング結果）
+ */
+int run_msd(itphys::LangevinParams p, long long n_runs, const CheckpointOptions &ck_opt) {
+    long long first = 0;
+    itphys::Checkpoint ck;
+    const bool restart = ck_opt.resume || ck_opt.extend > 0;
+    if (restart && !load_progress("msd", ck_opt, ck, p, first, n_runs)) return 1;
+    itphys::MsdAccumulator msd(static_cast<std::size_t>(p.n_steps) + 1);
+    if (restart) itphys::load_state(ck, "msd", msd);
+
+    run_trials("msd", p, first, n_runs, msd, ck_opt, [&](long long run) {
+        itphys::NormalRng rng(run + 1);
+        msd.begin_run();
+        itphys::run_brownian_motion(p, rng, msd);
+    });
+
+    std::printf("# t msd msd_err msd_theory\n");
+    for (std::size_t i = 0; i < msd.size(); i++) {
+        const double t = msd.time(i);
+        std::printf("%.10e %.10e %.10e %.10e\n", t, msd.at(i).mean(), msd.at(i).std_error(),
+                    itphys::theoretical_msd(t, p));
+    }
+    // report1_haruki.py と同じく後半の時刻で MSD/(4t) を平均する
+    const double t_start = msd.time(msd.size() / 2);
+    std::printf("# D_fit = %.6f  D_theory = %.6f  (n_runs = %lld)\n",
+                itphys::fit_diffusion_coefficient(msd, t_start),
+                itphys::diffusion_coefficient(p), n_runs);
+    return 0;
+}
+
+/**
+ * アンサンブルの MSD モード: opt.n_particles 個の粒子を run_ensemble で計算し、⟨r²(t)⟩ を出力
+ * 出力形式: # t msd msd_err msd_theory [vr_factor]（vr_factor は分散低減のときだけ。最後に
+ * 拡散係数のフィッティング結果。D_fit は msd モードと同じ MSD/(2·dim·t) の平均、D_slope は後半の傾きから求めた値）
+ */
+int run_msd_ensemble(const itphys::LangevinParams &p, const itphys::EnsembleOptions &opt) {
+    const bool reduced = opt.variance_reduction.any();
+    itphys::EnsembleObservables obs(static_cast<std::size_t>(p.n_steps) + 1);
+    try {
+        itphys::run_ensemble(p, opt, &obs);
+    } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    std::vector<double> t(obs.msd.size()), msd(obs.msd.size());
+    std::printf(reduced ? "# t msd msd_err msd_theory vr_factor\n" : "# t msd msd_err msd_theory\n");
+    for (std::size_t i = 0; i < obs.msd.size(); i++) {
+        t[i] = obs.msd.time(i);
+        const double theory = itphys::theoretical_msd(t[i], p, opt.dim);
+        if (reduced) {
+            const itphys::ReducedEstimate &r = obs.msd_reduced[i];
+            msd[i] = r.mean;
+            std::printf("%.10e %.10e %.10e %.10e %.4e\n", t[i], r.mean, r.std_error, theory, r.factor);
+        } else {
+            msd[i] = obs.msd.at(i).mean();
+            std::printf("%.10e %.10e %.10e %.10e\n", t[i], msd[i], obs.msd.at(i).std_error(), theory);
+        }
+    }
+    const double t_start = t[t.size() / 2];
+    std::printf("# D_fit = %.6f  D_slope = %.6f  D_theory = %.6f  (n_runs = %zu, dim = %d, integrator = %s, "
+                "noise = %s, precision = %s, variance_reduction = %s)\n",
+                itphys::fit_diffusion_coefficient(t, msd, t_start, opt.dim),
+                itphys::fit_diffusion_slope(t, msd, t_start, opt.dim), itphys::diffusion_coefficient(p),
+                opt.n_particles, opt.dim, itphys::integrator_name(opt.integrator), itphys::noise_name(opt.noise),
+                itphys::precision_name(opt.precision), itphys::variance_reduction_name(opt.variance_reduction).c_str());
+    return 0;
+}
+
+/**
+ * 自動の試行数の MSD モード: 目標量の標準誤差が許容値を下回るまでバッチを足し、⟨r²(t)⟩ を出力
+ * 出力形式は msd モードと同じ（msd_err はバッチ間のばらつきから求めた値）。最後に目標量の推定値と
+ * 標準誤差、使った粒子数と止まった理由
+ */
+int run_msd_adaptive(const itphys::LangevinParams &p, const itphys::AdaptiveOptions &opt) {
+    itphys::AdaptiveResult r;
+    try {
+        r = itphys::run_adaptive(p, opt, [](const itphys::AdaptiveResult &s) {
+            if (s.batches == 1) std::fprintf(stderr, "# batch particles estimate std_error seconds\n");
+            std::fprintf(stderr, "%zu %zu %.6e %.6e %.3f\n", s.batches, s.particles, s.target.mean(),
+                         s.target.std_error(), s.seconds);
+        });
+    } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    const int dim = opt.ensemble.dim;
+    std::vector<double> msd(r.msd.size());
+    std::printf("# t msd msd_err msd_theory\n");
+    for (std::size_t i = 0; i < r.msd.size(); i++) {
+        msd[i] = r.msd[i].mean();
+        std::printf("%.10e %.10e %.10e %.10e\n", r.time[i], msd[i], r.msd[i].std_error(),
+                    itphys::theoretical_msd(r.time[i], p, dim));
+    }
+    const double t_start = r.time[r.time.size() / 2];
+    const double t_end = r.time.back();
+    const char *target = itphys::adaptive_target_name(opt.target);
+    double theory = itphys::diffusion_coefficient(p);
+    if (opt.target == itphys::AdaptiveTarget::kMsd) theory = itphys::theoretical_msd(t_end, p, dim);
+    if (opt.target == itphys::AdaptiveTarget::kEnergy) theory = 0.5 * dim * p.kB * p.T;
+    std::printf("# %s = %.6f +- %.6f  (theory %.6f)  D_fit = %.6f  D_slope = %.6f  D_theory = %.6f\n", target,
+                r.target.mean(), r.target.std_error(), theory,
+                itphys::fit_diffusion_coefficient(r.time, msd, t_start, dim),
+                itphys::fit_diffusion_slope(r.time, msd, t_start, dim), itphys::diffusion_coefficient(p));
+    std::printf("# n_runs = %zu  batches = %zu  stop = %s  seconds = %.3f  (dim = %d, integrator = %s, noise = %s, "
+                "precision = %s, variance_reduction = %s)\n",
+                r.particles, r.batches, itphys::adaptive_stop_name(r.stop), r.seconds, dim,
+                itphys::integrator_name(opt.ensemble.integrator), itphys::noise_name(opt.ensemble.noise),
+                itphys::precision_name(opt.ensemble.precision),
+                itphys::variance_reduction_name(opt.ensemble.variance_reduction).c_str());
+    return 0;
+}
+
+/** dim 次元の運動エネルギーの熱平衡分布 P(E) = E^{dim/2-1} e^{-E/kBT} / (Γ(dim/2) (kBT)^{dim/2}) */
+double energy_density_theory(double e, double kT, int dim) {
+    const double k = 0.5 * dim;
+    return std::pow(e / kT, k - 1.0) * std::exp(-e / kT) / (std::tgamma(k) * kT);
+}
+
+/**
+ * ⟨E⟩ の標準誤差をブロッキング解析で出力（毎ステップの標本は相関しているので、独立とみなした
+ * naive の誤差は小さすぎる）。τ_int は標本の間隔（ステップ）と時間の単位で出す
+ */
+void print_blocking(const itphys::EnergyHistogram &hist, double dt) {
+    const itphys::BlockingStats &b = hist.blocking();
+    if (b.n_levels() == 0) return;
+    const int l = b.plateau_level();
+    const double tau = b.autocorrelation_time();
+    std::printf("# <E> std_error = %.6e (naive %.6e)  tau_int = %.3f steps = %.6f  plateau_level = %d%s\n",
+                b.plateau_std_error(), hist.stats().std_error(), tau, tau * dt, l,
+                l < 0 ? " (no plateau: the series is too short, std_error is a lower bound)" : "");
+}
+
+/**
+ * エネルギーモード: 全試行・全時刻の運動エネルギーのヒストグラムを理論値と並べて出力
+ * 出力形式: # E density density_theory
+ */
+int run_energy(itphys::LangevinParams p, long long n_runs, const CheckpointOptions &ck_opt) {
+    long long first = 0;
+    itphys::Checkpoint ck;
+    const bool restart = ck_opt.resume || ck_opt.extend > 0;
+    if (restart && !load_progress("energy", ck_opt, ck, p, first, n_runs)) return 1;
+    const double kT = p.kB * p.T;
+    itphys::EnergyHistogram hist(p.m, 10.0 * kT, 50);
+    if (restart) itphys::load_state(ck, "energy", hist);
+
+    run_trials("energy", p, first, n_runs, hist, ck_opt, [&](long long run) {
+        itphys::NormalRng rng(run + 1);
+        itphys::run_brownian_motion(p, rng, hist);
+    });
+
+    std::printf("# E density density_theory\n");
+    for (std::size_t i = 0; i < hist.n_bins(); i++) {
+        const double e = hist.bin_center(i);
+        std::printf("%.10e %.10e %.10e\n", e, hist.density(i), std::exp(-e / kT) / kT);
+    }
+    std::printf("# <E> = %.6f  (kBT = %.6f)  n = %.0f  overflow = %llu\n",
+                hist.stats().mean(), kT, hist.stats().count(), hist.overflow());
+    print_blocking(hist, p.dt);
+    return 0;
+}
+
+/**
+ * アンサンブルのエネルギーモード: opt.n_particles 個の粒子の全時刻の運動エネルギーのヒストグラムを
+ * dim 次元の理論値と並べて出力（出力形式は energy モードと同じ）
+ */
+int run_energy_ensemble(const itphys::LangevinParams &p, const itphys::EnsembleOptions &opt) {
+    const double kT = p.kB * p.T;
+    itphys::EnergyHistogram hist(p.m, 10.0 * kT, 50);
+    try {
+        itphys::run_ensemble(p, opt, nullptr, &hist);
+    } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    std::printf("# E density density_theory\n");
+    for (std::size_t i = 0; i < hist.n_bins(); i++) {
+        const double e = hist.bin_center(i);
+        std::printf("%.10e %.10e %.10e\n", e, hist.density(i), energy_density_theory(e, kT, opt.dim));
+    }
+    std::printf("# <E> = %.6f  (dim kBT/2 = %.6f)  n = %.0f  overflow = %llu  (dim = %d, integrator = %s, "
+                "noise = %s, precision = %s)\n",
+                hist.stats().mean(), 0.5 * opt.dim * kT, hist.stats().count(), hist.overflow(), opt.dim,
+                itphys::integrator_name(opt.integrator), itphys::noise_name(opt.noise),
+                itphys::precision_name(opt.precision));
+    print_blocking(hist, p.dt);
+    return 0;
+}
+
+/** argv[first] 以降の T, m, gamma, dt, n_steps を読む */
+itphys::LangevinParams parse_params(int argc, char *argv[], int first) {
+    itphys::LangevinParams p;
+    if (argc > first) p.T = std::atof(argv[first]);
+    if (argc > first + 1) p.m = std::atof(argv[first + 1]);
+    if (argc > first + 2) p.gamma = std::atof(argv[first + 2]);
+    if (argc > first + 3) p.dt = std::atof(argv[first + 3]);
+    if (argc > first + 4) p.n_steps = std::atoll(argv[first + 4]);
+    return p;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && std::strcmp(argv[1], "normal_rand") == 0) {
+        /* 正規分布乱数モード */
+        const int n_samples = (argc >= 3) ? std::atoi(argv[2]) : 1000;
+        const std::uint64_t seed = (argc >= 4) ? std::strtoull(argv[3], nullptr, 10) : 0;
+        return run_normal_rand(n_samples, seed);
+    }
+    if (argc >= 2 && (std::strcmp(argv[1], "msd") == 0 || std::strcmp(argv[1], "energy") == 0)) {
+        // "--" で始まるチェックポイントの指定を取り除き、残りを位置引数として読む
+        CheckpointOptions ck_opt;
+        itphys::EnsembleOptions eo;
+        bool ensemble = false;  // --dim, --integrator, --noise, --precision, --variance-reduction で run_ensemble を使う
+        itphys::AdaptiveOptions ao;
+        ao.ensemble.n_particles = 4096;
+        bool adaptive = false;  // --tolerance, --rel-tolerance, --time-budget などでバッチを足していく
+        bool rel_given = false;
+        std::vector<char *> args = {argv[0], argv[1]};
+        for (int i = 2; i < argc; i++) {
+            const bool v = i + 1 < argc;
+            if (std::strcmp(argv[i], "--checkpoint") == 0 && v) {
+                ck_opt.path = argv[++i];
+            } else if (std::strcmp(argv[i], "--checkpoint-every") == 0 && v) {
+                ck_opt.every = std::max(1LL, std::atoll(argv[++i]));
+            } else if (std::strcmp(argv[i], "--resume") == 0) {
+                ck_opt.resume = true;
+            } else if (std::strcmp(argv[i], "--extend") == 0 && v) {
+                ck_opt.extend = std::atoll(argv[++i]);
+            } else if (std::strcmp(argv[i], "--variance-reduction") == 0 && v) {
+                if (!itphys::parse_variance_reduction(argv[++i], eo.variance_reduction)) {
+                    std::fprintf(stderr, "--variance-reduction: expected antithetic,control,stratified\n");
+                    return 1;
+                }
+                ensemble = true;
+            } else if (std::strcmp(argv[i], "--dim") == 0 && v) {
+                eo.dim = std::atoi(argv[++i]);
+                if (eo.dim < 1 || eo.dim > 3) {
+                    std::fprintf(stderr, "--dim: expected 1, 2 or 3\n");
+                    return 1;
+                }
+                ensemble = true;
+            } else if (std::strcmp(argv[i], "--integrator") == 0 && v) {
+                if (!itphys::parse_integrator(argv[++i], eo.integrator)) {
+                    std::fprintf(stderr, "--integrator: expected euler, baoab or exact_ou\n");
+                    return 1;
+                }
+                ensemble = true;
+            } else if (std::strcmp(argv[i], "--noise") == 0 && v) {
+                if (!itphys::parse_noise(argv[++i], eo.noise)) {
+                    std::fprintf(stderr, "--noise: expected gaussian or uniform\n");
+                    return 1;
+                }
+                ensemble = true;
+            } else if (std::strcmp(argv[i], "--precision") == 0 && v) {
+                if (!itphys::parse_precision(argv[++i], eo.precision)) {
+                    std::fprintf(stderr, "--precision: expected double or mixed\n");
+                    return 1;
+                }
+                ensemble = true;
+            } else if (std::strcmp(argv[i], "--tolerance") == 0 && v) {
+                ao.tolerance = std::atof(argv[++i]);
+                adaptive = true;
+            } else if (std::strcmp(argv[i], "--rel-tolerance") == 0 && v) {
+                ao.rel_tolerance = std::atof(argv[++i]);
+                adaptive = rel_given = true;
+            } else if (std::strcmp(argv[i], "--time-budget") == 0 && v) {
+                ao.time_budget = std::atof(argv[++i]);
+                adaptive = true;
+            } else if (std::strcmp(argv[i], "--batch") == 0 && v) {
+                ao.ensemble.n_particles = static_cast<std::size_t>(std::max(1LL, std::atoll(argv[++i])));
+                adaptive = true;
+            } else if (std::strcmp(argv[i], "--min-batches") == 0 && v) {
+                ao.min_batches = static_cast<std::size_t>(std::max(1LL, std::atoll(argv[++i])));
+                adaptive = true;
+            } else if (std::strcmp(argv[i], "--target") == 0 && v) {
+                if (!itphys::parse_adaptive_target(argv[++i], ao.target)) {
+                    std::fprintf(stderr, "--target: expected diffusion, msd or energy\n");
+                    return 1;
+                }
+                adaptive = true;
+            } else {
+                args.push_back(argv[i]);
+            }
+        }
+        if ((ck_opt.resume || ck_opt.extend > 0) && ck_opt.path.empty()) {
+            std::fprintf(stderr, "--resume and --extend need --checkpoint PATH\n");
+            return 1;
+        }
+        const int n = static_cast<int>(args.size());
+        const long long n_runs = (n >= 3) ? std::atoll(args[2]) : 100;
+        const itphys::LangevinParams p = parse_params(n, args.data(), 3);
+        if (adaptive) {
+            if (!ck_opt.path.empty() || argv[1][0] != 'm') {
+                std::fprintf(stderr, "--tolerance, --rel-tolerance, --time-budget, --batch, --min-batches and "
+                                     "--target work only with msd and cannot be used with checkpoints\n");
+                return 1;
+            }
+            if (ao.tolerance > 0.0 && !rel_given) ao.rel_tolerance = 0.0;  // 絶対誤差だけで止める
+            const std::size_t batch = ao.ensemble.n_particles;
+            ao.ensemble = eo;
+            ao.ensemble.n_particles = batch;
+            if (n >= 3 && n_runs > 0) ao.max_batches = (static_cast<std::size_t>(n_runs) + batch - 1) / batch;
+            return run_msd_adaptive(p, ao);
+        }
+        if (ensemble) {
+            if (!ck_opt.path.empty() || (eo.variance_reduction.any() && argv[1][0] != 'm')) {
+                std::fprintf(stderr, "--variance-reduction works only with msd; run_ensemble options cannot "
+                                     "be used with checkpoints\n");
+                return 1;
+            }
+            eo.n_particles = static_cast<std::size_t>(std::max(1LL, n_runs));
+            return argv[1][0] == 'm' ? run_msd_ensemble(p, eo) : run_energy_ensemble(p, eo);
+        }
+        return argv[1][0] == 'm' ? run_msd(p, n_runs, ck_opt) : run_energy(p, n_runs, ck_opt);
+    }
+
+    /* ブラウン運動モード: デフォルト T=1.0, m=1.0, gamma=1.0, dt=0.01, n_steps=1000 */
+    return run_trajectory(parse_params(argc, argv, 1));
+}
@@ -28,13 +28,13 @@ plt.rcParams['axes.unicode_minus'] = False
 script_dir = os.path.dirname(os.path.abspath(__file__))
 os.chdir(script_dir)
 
-# Cプログラムをコンパイル（必要に応じて）
-source_file = 'brownian_motion.c'
-executable_name = './brownian_motion'
-
-if not os.path.exists(executable_name) or \
-   os.path.getmtime(source_file) > os.path.getmtime(executable_name):
-    subprocess.run(['gcc', '-o', executable_name, source_file, '-lm'])
+# Cプログラムを CMake（Release, -O3）でビルド（変更がなければ何もしない）
+repo_root = os.path.dirname(script_dir)
+build_dir = os.path.join(repo_root, 'build', 'release')
+if not os.path.exists(os.path.join(build_dir, 'CMakeCache.txt')):
+    subprocess.run(['cmake', '--preset', 'release'], cwd=repo_root, check=True)
+subprocess.run(['cmake', '--build', build_dir, '--target', 'brownian_motion'], check=True)
+executable_name = os.path.join(build_dir, 'bin', 'brownian_motion')
 
 # コマンドライン引数から実行回数を取得（指定がない場合はデフォルト値5を使用）
 n_runs = int(sys.argv[1]) if len(sys.argv) > 1 else 5
@@ -0,0 +1,233 @@
+/*
+ * canonical.c
+ *
+ * 目的: 2準位系のカノニカル集団の熱力学量を密な β グリッドで計算し、
+ *       ミクロカノニカルの T(x) と比較する
+ *
+ * 物理モデル（ε = kB = 1）:
+ * - Z(β) = Σ_M C(N,M) e^{-βM}、厳密には ln Z = N ln(1 + e^{-β})
+ * - ⟨E⟩ = -∂ln Z/∂β,  C = β²(⟨E²⟩ - ⟨E⟩²),  F = -T ln Z,  S = β(⟨E⟩ - F)
+ *
+ * 実装の要点:
+ * - ln C(N,M) は log_binomial.c の O(1) 表 (ln k! の表) から引く
+ * - ln Z は log-sum-exp: a_M = ln C(N,M) - βM の最大値 a* を引いてから exp の和を取る
+ * - a_M は M について上に凸なので、最頻値 M* から両側に二分探索して
+ *   a_M - a* >= -LSE_CUT となる窓だけを足す（それより外は e^-LSE_CUT 以下で倍精度に寄与しない）。
+ *   窓の幅は O(√N) なので、N = 10^7 でも β 1点あたり数万項で済む
+ * - exp は分岐と libm 呼び出しのない多項式で書き、窓の和は #pragma omp simd でベクトル化する
+ * - β グリッドは OpenMP で並列に処理する
+ *
+ * コンパイル: gcc -O3 -march=native -fopenmp -o canonical canonical.c log_binomial.c -lm
+ * 使い方:     ./canonical [N] [n_beta] [beta_min] [beta_max] [full]
+ *   省略時: N=10000000, n_beta=10000, beta_min=0.01, beta_max=10
+ *   full: 窓を使わず M = 0..N の全項で log-sum-exp を取る（検証用）
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "log_binomial.h"
+
+/* 窓の打ち切り: e^-50 ≈ 2e-22 は倍精度の和に寄与しない */
+#define LSE_CUT 50.0
+
+/* 1つの β に対する結果 */
+typedef struct {
+    double beta;
+    double lnZ;     /* ln Z / N */
+    double energy;  /* ⟨E⟩ / N = x */
+    double heat;    /* C / N */
+    double free_e;  /* F / N */
+    double entropy; /* S / N */
+    long long n_terms;
+} canon_t;
+
+/**
+ * 分岐のない exp(x)（x <= 0 を想定）
+ * x = k ln2 + r (|r| <= ln2/2) に分け、e^r を13次の Taylor 多項式で、2^k を指数部のビット操作で作る。
+ * x < -708 は 0 を返す
+ */
+static inline double exp_simd(double x) {
+    const double LOG2E = 1.4426950408889634;
+    const double LN2_HI = 6.93147180369123816490e-01;
+    const double LN2_LO = 1.90821492927058770002e-10;
+    double under = (double)(x < -708.0);
+    x = x - under * (x + 708.0);
+    double k = floor(x * LOG2E + 0.5);
+    double r = (x - k * LN2_HI) - k * LN2_LO;
+    double p = 1.0 / 6227020800.0;
+    p = p * r + 1.0 / 479001600.0;
+    p = p * r + 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+    long long bits = ((long long)k + 1023) << 52;
+    double scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return (1.0 - under) * p * scale;
+}
+
+/* a_M = ln C(N,M) - βM */
+static inline double lse_term(const lnC_table_t *tab, long long N, long long M, double beta) {
+    return lnC_table_get(tab, N, M) - beta * (double)M;
+}
+
+/**
+ * 凸関数 a_M の窓 [lo, hi] を求める。a_M は M* まで単調増加、その後単調減少なので二分探索できる
+ */
+static void lse_window(const lnC_table_t *tab, long long N, double beta, long long m_star,
+                       double a_star, long long *lo, long long *hi) {
+    long long l = 0, r = m_star;
+    while (l < r) {
+        long long mid = l + (r - l) / 2;
+        if (lse_term(tab, N, mid, beta) - a_star >= -LSE_CUT) r = mid;
+        else l = mid + 1;
+    }
+    *lo = l;
+    l = m_star;
+    r = N;
+    while (l < r) {
+        long long mid = r - (r - l) / 2;
+        if (lse_term(tab, N, mid, beta) - a_star >= -LSE_CUT) l = mid;
+        else r = mid - 1;
+    }
+    *hi = l;
+}
+
+/**
+ * 1つの β について log-sum-exp と M の1次・2次モーメントを計算する
+ * モーメントは M* からのずれ d = M - M* で取り、分散の桁落ちを防ぐ
+ */
+static canon_t canonical_point(const lnC_table_t *tab, long long N, double beta, int full) {
+    /* 最頻値: 二項分布 p = 1/(1+e^β) の mode の近傍で a_M を最大にする M */
+    double p = 1.0 / (1.0 + exp(beta));
+    long long m_star = (long long)floor((N + 1) * p);
+    if (m_star > N) m_star = N;
+    double a_star = lse_term(tab, N, m_star, beta);
+    for (long long m = m_star - 1; m <= m_star + 1; m++) {
+        if (m < 0 || m > N) continue;
+        double a = lse_term(tab, N, m, beta);
+        if (a > a_star) {
+            a_star = a;
+            m_star = m;
+        }
+    }
+
+    long long lo = 0, hi = N;
+    if (!full) lse_window(tab, N, beta, m_star, a_star, &lo, &hi);
+
+    const double *lf = tab->lf;
+    const double lfN = lf[N];
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0;
+#pragma omp simd reduction(+:s0, s1, s2)
+    for (long long m = lo; m <= hi; m++) {
+        double a = lfN - lf[m] - lf[N - m] - beta * (double)m;
+        double w = exp_simd(a - a_star);
+        double d = (double)(m - m_star);
+        s0 += w;
+        s1 += w * d;
+        s2 += w * d * d;
+    }
+
+    canon_t c;
+    double mean_d = s1 / s0;
+    double var = s2 / s0 - mean_d * mean_d;
+    double lnZ = a_star + log(s0);
+    double E = (double)m_star + mean_d;
+    c.beta = beta;
+    c.lnZ = lnZ / N;
+    c.energy = E / N;
+    c.heat = beta * beta * var / N;
+    c.free_e = -lnZ / beta / N;
+    c.entropy = (beta * E + lnZ) / N;
+    c.n_terms = hi - lo + 1;
+    return c;
+}
+
+int main(int argc, char *argv[]) {
+    long long N = 10000000;
+    int n_beta = 10000;
+    double beta_min = 0.01;
+    double beta_max = 10.0;
+    int full = 0;
+
+    if (argc >= 2) N = atoll(argv[1]);
+    if (argc >= 3) n_beta = atoi(argv[2]);
+    if (argc >= 4) beta_min = atof(argv[3]);
+    if (argc >= 5) beta_max = atof(argv[4]);
+    if (argc >= 6) full = (strcmp(argv[5], "full") == 0);
+
+    if (N < 2 || n_beta < 1) {
+        fprintf(stderr, "canonical: need N >= 2 and n_beta >= 1\n");
+        return 1;
+    }
+
+    struct timespec t0, t1, t2;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    lnC_table_t tab;
+    if (lnC_table_init(&tab, N) != 0) {
+        fprintf(stderr, "canonical: out of memory for N=%lld\n", N);
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    canon_t *res = malloc((size_t)n_beta * sizeof(canon_t));
+    if (!res) {
+        fprintf(stderr, "canonical: out of memory\n");
+        return 1;
+    }
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int i = 0; i < n_beta; i++) {
+        double beta = (n_beta == 1) ? beta_min
+                                    : beta_min + (beta_max - beta_min) * i / (n_beta - 1.0);
+        res[i] = canonical_point(&tab, N, beta, full);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+
+    /*
+     * 厳密解との比較: ln Z = N ln(1+e^-β),  x = 1/(e^β+1),  C/N = β² e^β/(e^β+1)²
+     * ミクロカノニカル: M = round(N⟨x⟩) での T(M) = 2/(S(M+1)-S(M-1))（log_binomial_diff）
+     */
+    printf("# N=%lld n_beta=%d beta=[%g, %g] mode=%s\n", N, n_beta, beta_min, beta_max,
+           full ? "full" : "window");
+    printf("# beta T lnZ/N F/N E/N C/N S/N relerr_lnZ relerr_E relerr_C T_micro n_terms\n");
+    long long total_terms = 0;
+    for (int i = 0; i < n_beta; i++) {
+        const canon_t *c = &res[i];
+        double b = c->beta;
+        double lnZ_ex = log1p(exp(-b));
+        double x_ex = 1.0 / (exp(b) + 1.0);
+        double C_ex = b * b * exp(-b) / ((1.0 + exp(-b)) * (1.0 + exp(-b)));
+        double M = floor(c->energy * N + 0.5);
+        double T_micro = NAN;
+        if (M >= 1 && M <= N - 1) {
+            double dS = log_binomial_diff((double)N, M + 1.0, M - 1.0, NULL);
+            if (dS != 0.0) T_micro = 2.0 / dS;
+        }
+        printf("%.15e %.15e %.15e %.15e %.15e %.15e %.15e %.3e %.3e %.3e %.15e %lld\n",
+               b, 1.0 / b, c->lnZ, c->free_e, c->energy, c->heat, c->entropy,
+               fabs(c->lnZ - lnZ_ex) / lnZ_ex, fabs(c->energy - x_ex) / x_ex,
+               fabs(c->heat - C_ex) / C_ex, T_micro, c->n_terms);
+        total_terms += c->n_terms;
+    }
+
+    double t_tab = (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+    double t_lse = (t2.tv_sec - t1.tv_sec) + 1e-9 * (t2.tv_nsec - t1.tv_nsec);
+    fprintf(stderr, "canonical: table %.3f s, %d betas in %.3f s (%.3e terms/s)\n",
+            t_tab, n_beta, t_lse, total_terms / (t_lse > 0 ? t_lse : 1e-300));
+
+    free(res);
+    lnC_table_free(&tab);
+    return 0;
+}
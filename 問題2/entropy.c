@@ -0,0 +1,144 @@
+/*
+ * entropy.c
+ *
+ * 目的: 非常に大きな N に対する 2準位系のエントロピー S(M) = ln C(N,M) と温度 T(M) の計算
+ *
+ * report2.py と同じ定義 T(M) = 2 / (S(M+1) - S(M-1))（ε = 1）を使う。
+ * N ≳ 10^12 では倍精度の S(M) どうしの差が桁落ちするので、
+ * log_binomial.c が誤差評価から自動で double-double に切り替える。
+ *
+ * コンパイル: gcc -O3 -march=native -fopenmp -o entropy entropy.c log_binomial.c -lm
+ *   （-DUSE_QUADMATH ... -lquadmath を付けると check モードで __float128 の参照値も出す）
+ * 使い方:     ./entropy [N] [n_points] [check|bench]
+ *   省略時: N=1e12, n_points=21
+ *   check: 倍精度のみ・自動選択・厳密な差分公式の T を並べて相対誤差を出力
+ *   bench: 倍精度経路と double-double 経路（まとめて計算）のスループットを比較
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "log_binomial.h"
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/**
+ * S(M+1) - S(M-1) = ln((N-M+1)/M) + ln((N-M)/(M+1)) を log1p で直接計算する
+ * 桁落ちのない参照値（check モード用）
+ */
+static double diff_exact(double N, double M) {
+    return log1p((N - 2.0 * M + 1.0) / M) + log1p((N - 2.0 * M - 1.0) / (M + 1.0));
+}
+
+/* check モードで比較する、倍精度だけで計算した差分 */
+static double diff_double_only(double N, double M) {
+    return (lgamma(M - 1.0 + 1.0) + lgamma(N - M + 1.0 + 1.0))
+         - (lgamma(M + 1.0 + 1.0) + lgamma(N - M - 1.0 + 1.0));
+}
+
+static int run_table(double N, int n_points) {
+    printf("# N=%.17g\n", N);
+    printf("# M x S/N T path err_T\n");
+    for (int i = 1; i <= n_points; i++) {
+        double M = floor(N * i / (n_points + 1.0));
+        if (M < 1.0) M = 1.0;
+        if (M > N - 1.0) M = N - 1.0;
+        lb_status_t st_s, st_d;
+        double S = log_binomial(N, M, &st_s);
+        double dS = log_binomial_diff(N, M + 1.0, M - 1.0, &st_d);
+        double T = 2.0 / dS;
+        double err_T = fabs(T) * st_d.err / fabs(dS);
+        printf("%.17g %.15e %.15e %.15e %s %.3e\n", M, M / N, S / N, T,
+               st_d.path == LB_DD ? "dd" : "double", err_T);
+    }
+    return 0;
+}
+
+static int run_check(double N, int n_points) {
+    printf("# N=%.17g\n", N);
+    printf("# M T_exact relerr_double relerr_auto path%s\n",
+#ifdef USE_QUADMATH
+           " relerr_quad"
+#else
+           ""
+#endif
+    );
+    for (int i = 1; i <= n_points; i++) {
+        double M = floor(N * i / (n_points + 1.0));
+        if (M < 1.0) M = 1.0;
+        if (M > N - 1.0) M = N - 1.0;
+        double T_ref = 2.0 / diff_exact(N, M);
+        double T_dbl = 2.0 / diff_double_only(N, M);
+        lb_status_t st;
+        double T_auto = 2.0 / log_binomial_diff(N, M + 1.0, M - 1.0, &st);
+        printf("%.17g %.15e %.3e %.3e %s", M, T_ref,
+               fabs(T_dbl - T_ref) / fabs(T_ref), fabs(T_auto - T_ref) / fabs(T_ref),
+               st.path == LB_DD ? "dd" : "double");
+#ifdef USE_QUADMATH
+        double T_q = 2.0 / log_binomial_diff_q(N, M + 1.0, M - 1.0);
+        printf(" %.3e", fabs(T_q - T_ref) / fabs(T_ref));
+#endif
+        printf("\n");
+    }
+    return 0;
+}
+
+static int run_bench(double N, int n_points) {
+    size_t n = (size_t)n_points;
+    double *M = malloc(n * sizeof(double));
+    double *out_d = malloc(n * sizeof(double));
+    dd_t *out_dd = malloc(n * sizeof(dd_t));
+    if (!M || !out_d || !out_dd) {
+        fprintf(stderr, "entropy: out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < n; i++) M[i] = floor(N * (i + 1.0) / (n + 1.0));
+
+    double t0 = now_sec();
+    for (size_t i = 0; i < n; i++) {
+        out_d[i] = lgamma(N + 1.0) - lgamma(M[i] + 1.0) - lgamma(N - M[i] + 1.0);
+    }
+    double t1 = now_sec();
+    log_binomial_dd_batch(N, M, out_dd, n);
+    double t2 = now_sec();
+
+    double max_rel = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double v = out_dd[i].hi + out_dd[i].lo;
+        double rel = fabs(out_d[i] - v) / fabs(v);
+        if (rel > max_rel) max_rel = rel;
+    }
+    printf("# N=%.17g n=%zu\n", N, n);
+    printf("double (lgamma):    %.3e evals/s\n", n / (t1 - t0));
+    printf("double-double SIMD: %.3e evals/s\n", n / (t2 - t1));
+    printf("max |double - dd| / dd = %.3e\n", max_rel);
+
+    free(M);
+    free(out_d);
+    free(out_dd);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    double N = 1e12;
+    int n_points = 21;
+
+    if (argc >= 2) N = floor(atof(argv[1]));
+    if (argc >= 3) n_points = atoi(argv[2]);
+
+    if (N < 2.0 || N >= 9007199254740992.0) {
+        fprintf(stderr, "entropy: N must satisfy 2 <= N < 2^53 (got %g)\n", N);
+        return 1;
+    }
+
+    if (argc >= 4 && strcmp(argv[3], "check") == 0) return run_check(N, n_points);
+    if (argc >= 4 && strcmp(argv[3], "bench") == 0) return run_bench(N, n_points);
+    return run_table(N, n_points);
+}
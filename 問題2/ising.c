@@ -0,0 +1,356 @@
+/*
+ * ising.c
+ *
+ * 目的: 2次元イジング模型のモンテカルロ計算（マルチスピンコーディング版）
+ *
+ * 物理モデル:
+ * - H = -J Σ_<ij> s_i s_j - h Σ_i s_i  （L×L 正方格子、周期境界条件）
+ * - J = 0 のとき各スピンは独立な2準位系（問題2）になり、
+ *   下向きスピン数 M の分布から ln C(N,M) と Stirling 近似が再現される
+ *
+ * 実装の要点:
+ * - 1ワード(uint64_t)に64スピンを詰める。列 c = k*W + j をワード j のビット k に置く
+ *   （W = L/64）。こうすると左右の隣接スピンも隣のワードの同じビットになり、
+ *   行の端だけ1ビット回転すればよい
+ * - W が偶数なら1ワード内の64スピンは全て同じ色になるので、
+ *   チェッカーボードの各色をワード単位で更新できる（L は128の倍数）
+ * - 反平行な隣接数 a (0..4) をビットスライス加算で求め、
+ *   受理確率との比較もビットスライスした一様乱数で64スピン同時に行う
+ * - 行ごとに独立な乱数列 (seed, sweep, 色, 行) を使うので、
+ *   OpenMP のスレッド数によらず同じ結果になる
+ *
+ * 出力:
+ * - 「壊れたボンド数」k と「下向きスピン数」M のヒストグラム
+ * - 各ビンについて ln Ω = ln H + βεk（定数差を除く）と
+ *   中心差分による温度 T/ε（report2.py の T(M) と同じ定義。周期境界では k は偶数しか取らないので、
+ *   ボンドの差分は k±2 で取る）
+ *
+ * コンパイル: gcc -O3 -march=native -fopenmp -o ising ising.c -lm
+ * 使い方:     ./ising [L] [T] [J] [h] [n_sweeps] [n_therm] [seed] [metropolis|heatbath]
+ *   省略時: L=256, T=2.269, J=1.0, h=0.0, n_sweeps=1000, n_therm=200, seed=1, metropolis
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* 受理確率の固定小数点精度（ビット数）。残る偏りは 2^-32 以下 */
+#define PROB_BITS 32
+
+/* スピンの状態クラス: (中心スピンの向き, 反平行な隣接数 a) の 2×5 通り */
+#define N_CLASS 10
+
+/* 乱数: splitmix64 でシードを撹拌し xoshiro256** で生成 */
+typedef struct {
+    uint64_t s[4];
+} rng_t;
+
+static inline uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rotr64(uint64_t x, int k) {
+    return (x >> k) | (x << (64 - k));
+}
+
+static void rng_seed(rng_t *r, uint64_t seed, uint64_t a, uint64_t b, uint64_t c) {
+    uint64_t x = seed;
+    x ^= splitmix64(&a);
+    x ^= rotl64(splitmix64(&b), 21);
+    x ^= rotl64(splitmix64(&c), 42);
+    for (int i = 0; i < 4; i++) r->s[i] = splitmix64(&x);
+}
+
+static inline uint64_t rng_next(rng_t *r) {
+    uint64_t *s = r->s;
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return result;
+}
+
+/* 格子: L 行 × W ワード。ビット1が下向きスピン (s = -1) */
+typedef struct {
+    int L;
+    int W;
+    uint64_t *w;
+} lattice_t;
+
+/* 各クラスの受理確率を固定小数点で保持したテーブル */
+typedef struct {
+    uint64_t always;                  /* p >= 1 のクラスのビット集合 */
+    uint32_t p[N_CLASS];              /* floor(p * 2^32) */
+    uint64_t bit[PROB_BITS][N_CLASS]; /* p の第 b ビットが1なら全ビット1 */
+} accept_table_t;
+
+/**
+ * 受理確率テーブルを作成する
+ * metropolis: p = min(1, exp(-βΔE)),  heatbath: p = 1 / (1 + exp(βΔE))
+ */
+static void build_accept_table(accept_table_t *tab, double beta, double J, double h,
+                               int heatbath) {
+    memset(tab, 0, sizeof(*tab));
+    for (int spin = 0; spin < 2; spin++) {
+        double s = spin ? -1.0 : 1.0;
+        for (int a = 0; a <= 4; a++) {
+            int c = spin * 5 + a;
+            double dE = 4.0 * J * (2 - a) + 2.0 * h * s;
+            double p = heatbath ? 1.0 / (1.0 + exp(beta * dE))
+                                : (dE <= 0.0 ? 1.0 : exp(-beta * dE));
+            if (!heatbath && p >= 1.0) {
+                tab->always |= 1ULL << c;
+                continue;
+            }
+            double q = ldexp(p, PROB_BITS);
+            tab->p[c] = q >= 4294967295.0 ? 0xFFFFFFFFu : (uint32_t)q;
+            for (int b = 0; b < PROB_BITS; b++) {
+                int bitpos = PROB_BITS - 1 - b;
+                tab->bit[b][c] = ((tab->p[c] >> bitpos) & 1u) ? ~0ULL : 0ULL;
+            }
+        }
+    }
+}
+
+/**
+ * 1ワード(64スピン)分の反転マスクを求める
+ * 反平行数 a をビットスライス加算し、クラスごとの閾値と
+ * ビットスライスした一様乱数 U を上位ビットから比較する (U < p なら反転)
+ */
+static inline uint64_t flip_mask(uint64_t s, uint64_t up, uint64_t dn,
+                                 uint64_t lf, uint64_t rt,
+                                 const accept_table_t *tab, rng_t *r) {
+    uint64_t n1 = s ^ up, n2 = s ^ dn, n3 = s ^ lf, n4 = s ^ rt;
+    uint64_t s1 = n1 ^ n2, c1 = n1 & n2;
+    uint64_t s2 = n3 ^ n4, c2 = n3 & n4;
+    uint64_t b0 = s1 ^ s2;
+    uint64_t k0 = s1 & s2;
+    uint64_t b1 = c1 ^ c2 ^ k0;
+    uint64_t b2 = (c1 & c2) | (k0 & (c1 ^ c2));
+
+    uint64_t eq[5];
+    eq[0] = ~b0 & ~b1 & ~b2;
+    eq[1] = b0 & ~b1 & ~b2;
+    eq[2] = ~b0 & b1 & ~b2;
+    eq[3] = b0 & b1;
+    eq[4] = b2;
+
+    uint64_t cls[N_CLASS];
+    uint64_t acc = 0;
+    for (int a = 0; a <= 4; a++) {
+        cls[a] = ~s & eq[a];
+        cls[5 + a] = s & eq[a];
+        if (tab->always & (1ULL << a)) acc |= cls[a];
+        if (tab->always & (1ULL << (5 + a))) acc |= cls[5 + a];
+    }
+
+    uint64_t und = ~acc;
+    for (int b = 0; b < PROB_BITS && und; b++) {
+        uint64_t thr = 0;
+        for (int c = 0; c < N_CLASS; c++) thr |= cls[c] & tab->bit[b][c];
+        uint64_t R = rng_next(r);
+        acc |= und & thr & ~R;
+        und &= ~(thr ^ R);
+    }
+    return acc;
+}
+
+/**
+ * チェッカーボードの一方の色 (color = 0, 1) を更新する
+ * 同じ色のワードは互いに隣接しないので、行単位でスレッド並列にできる
+ */
+static void update_color(lattice_t *lat, int color, uint64_t seed, uint64_t sweep,
+                         const accept_table_t *tab) {
+    const int L = lat->L, W = lat->W;
+    uint64_t *w = lat->w;
+
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < L; i++) {
+        rng_t r;
+        rng_seed(&r, seed, sweep, (uint64_t)color, (uint64_t)i);
+        uint64_t *row = w + (size_t)i * W;
+        const uint64_t *rowu = w + (size_t)((i + L - 1) % L) * W;
+        const uint64_t *rowd = w + (size_t)((i + 1) % L) * W;
+        for (int j = (i + color) & 1; j < W; j += 2) {
+            uint64_t lf = (j > 0) ? row[j - 1] : rotl64(row[W - 1], 1);
+            uint64_t rt = (j < W - 1) ? row[j + 1] : rotr64(row[0], 1);
+            row[j] ^= flip_mask(row[j], rowu[j], rowd[j], lf, rt, tab, &r);
+        }
+    }
+}
+
+/**
+ * 壊れたボンド数（反平行な最近接対の数）と下向きスピン数を数える
+ */
+static void measure(const lattice_t *lat, long long *n_bond, long long *n_down) {
+    const int L = lat->L, W = lat->W;
+    const uint64_t *w = lat->w;
+    long long nb = 0, nd = 0;
+
+#pragma omp parallel for schedule(static) reduction(+:nb, nd)
+    for (int i = 0; i < L; i++) {
+        const uint64_t *row = w + (size_t)i * W;
+        const uint64_t *rowd = w + (size_t)((i + 1) % L) * W;
+        for (int j = 0; j < W; j++) {
+            uint64_t rt = (j < W - 1) ? row[j + 1] : rotr64(row[0], 1);
+            nb += __builtin_popcountll(row[j] ^ rt) + __builtin_popcountll(row[j] ^ rowd[j]);
+            nd += __builtin_popcountll(row[j]);
+        }
+    }
+    *n_bond = nb;
+    *n_down = nd;
+}
+
+/* 範囲を必要に応じて広げるヒストグラム（N = 4096² でも平衡揺らぎの幅だけ確保する） */
+typedef struct {
+    long long lo;
+    long long n;
+    unsigned long long *count;
+} hist_t;
+
+static void hist_add(hist_t *hs, long long k) {
+    if (hs->n == 0) {
+        hs->lo = k;
+        hs->n = 1;
+        hs->count = calloc(1, sizeof(unsigned long long));
+    } else if (k < hs->lo || k >= hs->lo + hs->n) {
+        long long lo = k < hs->lo ? k : hs->lo;
+        long long hi = k >= hs->lo + hs->n ? k + 1 : hs->lo + hs->n;
+        unsigned long long *c = calloc((size_t)(hi - lo), sizeof(unsigned long long));
+        memcpy(c + (hs->lo - lo), hs->count, (size_t)hs->n * sizeof(unsigned long long));
+        free(hs->count);
+        hs->count = c;
+        hs->lo = lo;
+        hs->n = hi - lo;
+    }
+    hs->count[k - hs->lo]++;
+}
+
+/**
+ * ヒストグラムを出力する
+ * ln Ω(k) = ln H(k) + βεk（定数差を除く）、T/ε = 2s / (ln Ω(k+s) - ln Ω(k-s))
+ * s は k の取りうる値の間隔（周期境界の壊れたボンド数は常に偶数なので 2、下向きスピン数は 1）
+ * ε = 0 の周辺分布では温度が定義できないので nan を出力する
+ */
+static void print_hist(const char *kind, const hist_t *hs, long long n_units,
+                       double beta, double eps, long long s) {
+    for (long long i = 0; i < hs->n; i++) {
+        long long k = hs->lo + i;
+        if (hs->count[i] == 0) continue;
+        double ln_omega = log((double)hs->count[i]) + beta * eps * (double)k;
+        double T_eps = NAN;
+        if (eps != 0.0 && i >= s && i + s < hs->n && hs->count[i - s] && hs->count[i + s]) {
+            double dS = log((double)hs->count[i + s]) - log((double)hs->count[i - s])
+                        + 2.0 * (double)s * beta * eps;
+            if (fabs(dS) > 1e-12) T_eps = 2.0 * (double)s / dS;
+        }
+        printf("%s %lld %.15e %llu %.15e %.15e\n", kind, k, (double)k / (double)n_units,
+               hs->count[i], ln_omega, T_eps);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int L = 256;
+    double T = 2.269;
+    double J = 1.0;
+    double h = 0.0;
+    int n_sweeps = 1000;
+    int n_therm = 200;
+    unsigned long long seed = 1;
+    int heatbath = 0;
+
+    if (argc >= 2) L = atoi(argv[1]);
+    if (argc >= 3) T = atof(argv[2]);
+    if (argc >= 4) J = atof(argv[3]);
+    if (argc >= 5) h = atof(argv[4]);
+    if (argc >= 6) n_sweeps = atoi(argv[5]);
+    if (argc >= 7) n_therm = atoi(argv[6]);
+    if (argc >= 8) seed = strtoull(argv[7], NULL, 10);
+    if (argc >= 9) heatbath = (strcmp(argv[8], "heatbath") == 0);
+
+    if (L < 128 || L % 128 != 0) {
+        fprintf(stderr, "ising: L must be a positive multiple of 128 (got %d)\n", L);
+        return 1;
+    }
+    if (T <= 0.0) {
+        fprintf(stderr, "ising: T must be positive (got %g)\n", T);
+        return 1;
+    }
+
+    lattice_t lat;
+    lat.L = L;
+    lat.W = L / 64;
+    lat.w = calloc((size_t)L * lat.W, sizeof(uint64_t));
+    if (!lat.w) {
+        fprintf(stderr, "ising: out of memory\n");
+        return 1;
+    }
+
+    /* 初期状態: 高温側からランダムに配置 */
+    {
+        rng_t r;
+        rng_seed(&r, seed, ~0ULL, 0, 0);
+        for (size_t i = 0; i < (size_t)L * lat.W; i++) lat.w[i] = rng_next(&r);
+    }
+
+    double beta = 1.0 / T;
+    accept_table_t tab;
+    build_accept_table(&tab, beta, J, h, heatbath);
+
+    hist_t h_bond = {0, 0, NULL}, h_down = {0, 0, NULL};
+    long long N = (long long)L * L;
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int sweep = 0; sweep < n_therm + n_sweeps; sweep++) {
+        update_color(&lat, 0, seed, (uint64_t)sweep, &tab);
+        update_color(&lat, 1, seed, (uint64_t)sweep, &tab);
+        if (sweep >= n_therm) {
+            long long nb, nd;
+            measure(&lat, &nb, &nd);
+            hist_add(&h_bond, nb);
+            hist_add(&h_down, nd);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double elapsed = (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+
+    int n_threads = 1;
+#ifdef _OPENMP
+    n_threads = omp_get_max_threads();
+#endif
+
+    printf("# ising L=%d N=%lld T=%.15e J=%.15e h=%.15e algo=%s sweeps=%d therm=%d seed=%llu\n",
+           L, N, T, J, h, heatbath ? "heatbath" : "metropolis", n_sweeps, n_therm, seed);
+    printf("# bond: k = 壊れたボンド数 (N_unit = 2N, ε = 2J),"
+           " spin: k = 下向きスピン数 (N_unit = N, ε = 2h)\n");
+    printf("# kind k x count ln_omega T_over_eps\n");
+    print_hist("bond", &h_bond, 2 * N, beta, 2.0 * J, 2);
+    print_hist("spin", &h_down, N, beta, 2.0 * h, 1);
+
+    fprintf(stderr, "ising: %d sweeps in %.3f s (%.3e spin updates/s, %d threads)\n",
+            n_therm + n_sweeps, elapsed,
+            (double)N * (n_therm + n_sweeps) / (elapsed > 0 ? elapsed : 1e-300), n_threads);
+
+    free(h_bond.count);
+    free(h_down.count);
+    free(lat.w);
+    return 0;
+}
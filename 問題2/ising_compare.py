@@ -0,0 +1,92 @@
+# 問題2 発展: 2次元イジング模型（有限結合 J）と独立2準位系（Stirling 極限）の比較
+#
+# ising.c のヒストグラムから ln Ω(k) = ln H(k) + βεk を作り、
+# 複数の温度で得た窓を Stirling の s(x) = -x ln x - (1-x) ln(1-x) に重ねる。
+# 温度は report2.py と同じ中心差分 T/ε = 2 / (S(k+1) - S(k-1)) で求める。
+#
+# 実行: python3 ising_compare.py [L] [J]
+#   省略時: L=256, J=1.0（J=0 を指定すると磁場 h=0.5 の独立スピンで比較する）
+import os
+import subprocess
+import sys
+
+import numpy as np
+import matplotlib.pyplot as plt
+
+script_dir = os.path.dirname(os.path.abspath(__file__))
+os.chdir(script_dir)
+
+# CMake（Release, OpenMP）でビルド（変更がなければ何もしない）
+repo_root = os.path.dirname(script_dir)
+build_dir = os.path.join(repo_root, 'build', 'release')
+if not os.path.exists(os.path.join(build_dir, 'CMakeCache.txt')):
+    subprocess.run(['cmake', '--preset', 'release'], cwd=repo_root, check=True)
+subprocess.run(['cmake', '--build', build_dir, '--target', 'ising'], check=True)
+executable_name = os.path.join(build_dir, 'bin', 'ising')
+
+L = int(sys.argv[1]) if len(sys.argv) >= 2 else 256
+J = float(sys.argv[2]) if len(sys.argv) >= 3 else 1.0
+h = 0.0 if J != 0.0 else 0.5
+# J≠0 ではボンド、J=0 ではスピンの周辺分布がエネルギーを担う
+kind = 'bond' if J != 0.0 else 'spin'
+T_list = [1.5, 2.0, 2.269, 3.0, 5.0, 10.0] if J != 0.0 else [0.5, 1.0, 2.0, 5.0]
+
+
+def run_ising(T):
+    """ising を実行し、指定した周辺分布の (x, ln Ω, N_unit, T/ε) を返す"""
+    out = subprocess.run([executable_name, str(L), str(T), str(J), str(h), '2000', '500'],
+                         capture_output=True, text=True, check=True).stdout
+    N = int(out.split()[3].split('=')[1])
+    n_unit = 2 * N if kind == 'bond' else N
+    rows = [line.split() for line in out.splitlines()
+            if line and not line.startswith('#') and line.split()[0] == kind]
+    x = np.array([float(r[2]) for r in rows])
+    ln_omega = np.array([float(r[4]) for r in rows])
+    T_eps = np.array([float(r[5]) for r in rows])
+    return x, ln_omega, n_unit, T_eps
+
+
+def s_stirling(x):
+    return -(x * np.log(x) + (1 - x) * np.log(1 - x))
+
+
+def main():
+    fig_s, ax_s = plt.subplots(figsize=(6, 4))
+    fig_t, ax_t = plt.subplots(figsize=(6, 4))
+    x_cont = np.linspace(1e-6, 1 - 1e-6, 400)
+    ax_s.plot(x_cont, s_stirling(x_cont), 'k-', lw=2, label='Stirling (J=0)')
+    y_clip = 8
+    ax_t.plot(x_cont, np.clip(1.0 / np.log((1 - x_cont) / x_cont), -y_clip, y_clip),
+              'k-', lw=2, label=r'Stirling $T_{\mathrm{th}}(x)$')
+
+    for T in T_list:
+        x, ln_omega, n_unit, T_eps = run_ising(T)
+        # ln Ω の定数は決まらないので、ヒストグラムの最頻値で Stirling 曲線に合わせる
+        eps = 2.0 * J if kind == 'bond' else 2.0 * h
+        i0 = np.argmax(ln_omega - eps * x * n_unit / T)
+        s = (ln_omega - ln_omega[i0]) / n_unit + s_stirling(x[i0])
+        ax_s.plot(x, s, '.', ms=2, label=f'T={T}')
+        ok = np.isfinite(T_eps)
+        ax_t.plot(x[ok], T_eps[ok], '.', ms=2, label=f'T={T}')
+
+    ax_s.set_xlabel(r'$x = k/N_{\mathrm{unit}}$')
+    ax_s.set_ylabel(r'$s = S/N_{\mathrm{unit}}$')
+    ax_s.set_title(f'L={L}, J={J}, h={h}')
+    ax_s.legend(fontsize=8)
+    ax_s.grid(True, alpha=0.3)
+    fig_s.tight_layout()
+    fig_s.savefig('fig_ising_entropy.png', dpi=150)
+
+    ax_t.set_ylim(-y_clip, y_clip)
+    ax_t.set_xlabel(r'$x = k/N_{\mathrm{unit}}$')
+    ax_t.set_ylabel(r'$T/\varepsilon$')
+    ax_t.set_title(f'L={L}, J={J}, h={h}')
+    ax_t.legend(fontsize=8)
+    ax_t.grid(True, alpha=0.3)
+    fig_t.tight_layout()
+    fig_t.savefig('fig_ising_temperature.png', dpi=150)
+    print('fig_ising_entropy.png, fig_ising_temperature.png を保存しました。')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,86 @@
+/*
+ * log_binomial.h
+ *
+ * ln C(N,M)（2準位系のエントロピー S(M)）の計算
+ *
+ * - 倍精度の経路: lgamma による ln C(N,M) と、O(1) で引ける ln k! の表
+ * - 拡張精度の経路: double-double（約106ビット）の Stirling 級数
+ *   N ≳ 10^12 では ln N! ~ 10^13 同士の引き算で倍精度の桁が消えるため、
+ *   誤差評価が許容値を超えたときだけ自動的にこちらへ切り替える
+ * - -DUSE_QUADMATH を付けてコンパイルすると __float128 の参照値も使える
+ */
+
+#ifndef LOG_BINOMIAL_H
+#define LOG_BINOMIAL_H
+
+#include <stddef.h>
+
+/* double-double: 値は hi + lo (|lo| <= ulp(hi)/2) */
+typedef struct {
+    double hi;
+    double lo;
+} dd_t;
+
+/* どの経路で計算したか */
+enum {
+    LB_DOUBLE = 0,
+    LB_DD = 1
+};
+
+typedef struct {
+    int path;   /* LB_DOUBLE または LB_DD */
+    double err; /* 絶対誤差の上限の見積もり */
+} lb_status_t;
+
+/* 自動選択の許容相対誤差。倍精度の誤差評価がこれを超えると double-double に切り替える */
+#define LB_REL_TOL 1e-12
+
+/**
+ * ln C(N,M) を計算する（経路は自動選択）
+ * @param st NULL でなければ使った経路と誤差評価を返す
+ */
+double log_binomial(double N, double M, lb_status_t *st);
+
+/**
+ * S(Ma) - S(Mb) = ln C(N,Ma) - ln C(N,Mb) を計算する（経路は自動選択）
+ * 温度 T(M) = 2 / (S(M+1) - S(M-1)) の分母に使う。ln N! は厳密に打ち消し合う
+ */
+double log_binomial_diff(double N, double Ma, double Mb, lb_status_t *st);
+
+/**
+ * ln n! を double-double で計算する
+ * n <= 1024 は表、それより大きい n は Stirling 級数（7項）
+ * @param err NULL でなければ絶対誤差の上限を返す
+ */
+dd_t lnfact_dd(double n, double *err);
+
+/** ln C(N,M) を double-double で計算する */
+dd_t log_binomial_dd(double N, double M, double *err);
+
+/**
+ * ln C(N,M[i]) をまとめて double-double で計算する
+ * 分岐のない double-double 演算だけで書いてあり、ループはSIMD化される
+ */
+void log_binomial_dd_batch(double N, const double *M, dd_t *out, size_t n);
+
+#ifdef USE_QUADMATH
+/** __float128 (lgammaq) による参照値 ln C(N,Ma) - ln C(N,Mb) */
+double log_binomial_diff_q(double N, double Ma, double Mb);
+#endif
+
+/* ln k! (k = 0..n_max) の表。ln C(N,M) = lf[N] - lf[M] - lf[N-M] を O(1) で引く */
+typedef struct {
+    long long n_max;
+    double *lf;
+} lnC_table_t;
+
+/** 表を作る。失敗したら -1 を返す */
+int lnC_table_init(lnC_table_t *tab, long long n_max);
+
+void lnC_table_free(lnC_table_t *tab);
+
+static inline double lnC_table_get(const lnC_table_t *tab, long long N, long long M) {
+    return tab->lf[N] - tab->lf[M] - tab->lf[N - M];
+}
+
+#endif /* LOG_BINOMIAL_H */